@@ -0,0 +1,359 @@
+/*
+ * bankdiff.c
+ */
+
+#include "bankdiff.h"
+
+// SSE2 is always there on x86-64
+#if defined(__GNUC__) && defined(__SSE2__)
+#define BANKDIFF_SSE2
+#include <emmintrin.h>
+#endif
+
+/*
+ * __bankdiff_byte
+ *
+ * Adds differing byte "i" to the open run "run", or closes it and opens a
+ * new one if "i" is too far past it. A run with 0 "bytes" isn't open.
+ */
+
+void __bankdiff_byte(ar_diff_part_t *part, ar_diff_run_t *run, size_t i) {
+	uint8_t x;
+
+	x = part->a[i] ^ part->b[i];
+
+	if (run->bytes > 0 && i - (run->start + run->len - 1) > part->gap) {
+		cn_vec_push_back(part->runs, run);
+		run->bytes = 0;
+	}
+
+	if (run->bytes == 0) {
+		memset(run, 0, sizeof(ar_diff_run_t));
+		run->start = i;
+	}
+
+	run->len       = i - run->start + 1;
+	run->bytes    += 1;
+	run->bits     += __builtin_popcount(x);
+	run->bits_set += __builtin_popcount(x & part->b[i]);
+	run->bits_clr += __builtin_popcount(x & part->a[i]);
+}
+
+/*
+ * __bankdiff_range
+ *
+ * Finds the runs in a single part. Blocks are compared all at once, and only
+ * ones that differ are looked at a byte at a time.
+ */
+
+void __bankdiff_range(ar_diff_part_t *part) {
+	ar_diff_run_t  run;
+	size_t         i;
+#ifdef BANKDIFF_SSE2
+	__m128i        x, y;
+	uint32_t       mask;
+#else
+	uint64_t       wa, wb;
+	size_t         k;
+#endif
+
+	run.bytes = 0;
+	i         = part->start;
+
+#ifdef BANKDIFF_SSE2
+	// 16 bytes at a time. Each set bit in "mask" is a byte that differs.
+	for (; i + 16 <= part->end; i += 16) {
+		x    = _mm_loadu_si128((const __m128i *) (part->a + i));
+		y    = _mm_loadu_si128((const __m128i *) (part->b + i));
+		mask = ~_mm_movemask_epi8(_mm_cmpeq_epi8(x, y)) & 0xFFFF;
+
+		for (; mask != 0; mask &= mask - 1)
+			__bankdiff_byte(part, &run, i + __builtin_ctz(mask));
+	}
+#else
+	// 8 bytes at a time
+	for (; i + 8 <= part->end; i += 8) {
+		memcpy(&wa, part->a + i, 8);
+		memcpy(&wb, part->b + i, 8);
+
+		if (wa == wb)
+			continue;
+
+		for (k = 0; k < 8; k++) {
+			if (part->a[i + k] != part->b[i + k])
+				__bankdiff_byte(part, &run, i + k);
+		}
+	}
+#endif
+
+	// Whatever is left, byte-by-byte
+	for (; i < part->end; i++) {
+		if (part->a[i] != part->b[i])
+			__bankdiff_byte(part, &run, i);
+	}
+
+	if (run.bytes > 0)
+		cn_vec_push_back(part->runs, &run);
+}
+
+/*
+ * __bankdiff_worker
+ *
+ * pthread entry point for "bankdiff".
+ */
+
+void *__bankdiff_worker(void *arg) {
+	__bankdiff_range((ar_diff_part_t *) arg);
+	return NULL;
+}
+
+/*
+ * __bankdiff_merge
+ *
+ * Merges run "src" into run "dst", which comes before it.
+ */
+
+void __bankdiff_merge(ar_diff_run_t *dst, const ar_diff_run_t *src) {
+	dst->len       = src->start + src->len - dst->start;
+	dst->bytes    += src->bytes;
+	dst->bits     += src->bits;
+	dst->bits_set += src->bits_set;
+	dst->bits_clr += src->bits_clr;
+}
+
+/*
+ * bankdiff
+ *
+ * Compares the "size" bytes at "a" and "b", and returns a CN_VEC of every
+ * ar_diff_run_t, in order. Differing bytes at most "gap" bytes apart share a
+ * run (0 means BANKDIFF_GAP). If "threads" is 0, one thread per online CPU
+ * is used. Small buffers are done on the calling thread.
+ */
+
+CN_VEC bankdiff(
+	const uint8_t *a,
+	const uint8_t *b,
+	size_t         size,
+	size_t         gap,
+	size_t         threads
+) {
+	CN_VEC          runs;
+	ar_diff_part_t *parts;
+	ar_diff_run_t  *run, *last;
+	pthread_t      *tids;
+	size_t          i, num, part_sz;
+
+	if (gap == 0)
+		gap = BANKDIFF_GAP;
+
+	if (threads == 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	// Not worth splitting up into parts smaller than BANKDIFF_MIN_PART
+	num = size / BANKDIFF_MIN_PART;
+
+	if (num > threads)
+		num = threads;
+
+	if (num == 0)
+		num = 1;
+
+	part_sz = size / num;
+	parts   = (ar_diff_part_t *) malloc(sizeof(ar_diff_part_t) * num);
+
+	for (i = 0; i < num; i++) {
+		parts[i].a     = a;
+		parts[i].b     = b;
+		parts[i].start = i * part_sz;
+		parts[i].end   = (i == num - 1) ? size : (i + 1) * part_sz;
+		parts[i].gap   = gap;
+		parts[i].runs  = cn_vec_init(ar_diff_run_t);
+	}
+
+	if (num == 1)
+		__bankdiff_range(&parts[0]);
+	else {
+		tids = (pthread_t *) malloc(sizeof(pthread_t) * num);
+
+		for (i = 0; i < num; i++)
+			pthread_create(&tids[i], NULL, __bankdiff_worker, &parts[i]);
+
+		for (i = 0; i < num; i++)
+			pthread_join(tids[i], NULL);
+
+		free(tids);
+	}
+
+	// Put the parts together. Runs that meet at the edge of a part merge.
+	runs = cn_vec_init(ar_diff_run_t);
+	last = NULL;
+
+	for (i = 0; i < num; i++) {
+		cn_vec_traverse(parts[i].runs, run) {
+			if (
+				last != NULL &&
+				run->start - (last->start + last->len - 1) <= gap
+			) {
+				__bankdiff_merge(last, run);
+			}
+			else {
+				cn_vec_push_back(runs, run);
+				last = (ar_diff_run_t *) cn_vec_at(runs, cn_vec_size(runs) - 1);
+			}
+		}
+
+		cn_vec_free(parts[i].runs);
+	}
+
+	free(parts);
+	return runs;
+}
+
+/*
+ * bankdiff_total
+ *
+ * Adds up every run in "runs" into "total", as if it were one big run.
+ */
+
+void bankdiff_total(CN_VEC runs, ar_diff_run_t *total) {
+	ar_diff_run_t *run;
+
+	memset(total, 0, sizeof(ar_diff_run_t));
+
+	cn_vec_traverse(runs, run) {
+		if (total->bytes == 0)
+			total->start = run->start;
+
+		__bankdiff_merge(total, run);
+	}
+}
+
+/*
+ * __bankdiff_vote
+ *
+ * Votes on byte "i" of the "num" banks, and puts the most common value in
+ * "out". Ties go to the value from the earliest bank. Returns 1 if more
+ * than half of the banks agreed on it, or 0 if not.
+ */
+
+int __bankdiff_vote(
+	const uint8_t **banks,
+	size_t          num,
+	size_t          i,
+	uint8_t        *out
+) {
+	size_t j, k, count, best;
+
+	for (j = 0, best = 0; j < num; j++) {
+		for (k = 0, count = 0; k < num; k++)
+			count += (banks[k][i] == banks[j][i]);
+
+		if (count > best) {
+			best   = count;
+			out[i] = banks[j][i];
+		}
+	}
+
+	return best * 2 > num;
+}
+
+/*
+ * bankdiff_vote
+ *
+ * Rebuilds "size" bytes into "out" from "num" banks that should all be the
+ * same, by taking the most common value of each byte. The offset of every
+ * byte where no value had more than half the votes is pushed onto "unclear"
+ * (a CN_VEC of uint32_t). Returns how many bytes the banks disagreed on,
+ * unclear ones included.
+ *
+ * Blocks of 16 bytes (8 without SSE2) that every bank agrees on are copied
+ * straight over. Only blocks with a difference are voted on byte-by-byte.
+ */
+
+size_t bankdiff_vote(
+	const uint8_t **banks,
+	size_t          num,
+	size_t          size,
+	uint8_t        *out,
+	CN_VEC          unclear
+) {
+	size_t   i, k, differ;
+	uint32_t off;
+#ifdef BANKDIFF_SSE2
+	__m128i  x;
+	uint32_t mask;
+#else
+	uint64_t w0, wk, mask;
+#endif
+
+	differ = 0;
+	i      = 0;
+
+#ifdef BANKDIFF_SSE2
+	for (; i + 16 <= size; i += 16) {
+		x    = _mm_loadu_si128((const __m128i *) (banks[0] + i));
+		mask = 0;
+
+		// Each set bit is a byte that some bank disagrees with bank 0 on
+		for (k = 1; k < num; k++) {
+			mask |= ~_mm_movemask_epi8(
+				_mm_cmpeq_epi8(
+					x,
+					_mm_loadu_si128((const __m128i *) (banks[k] + i))
+				)
+			) & 0xFFFF;
+		}
+
+		_mm_storeu_si128((__m128i *) (out + i), x);
+
+		for (; mask != 0; mask &= mask - 1) {
+			off = i + __builtin_ctz(mask);
+			differ++;
+
+			if (!__bankdiff_vote(banks, num, off, out))
+				cn_vec_push_back(unclear, &off);
+		}
+	}
+#else
+	for (; i + 8 <= size; i += 8) {
+		memcpy(&w0, banks[0] + i, 8);
+		memcpy(out + i, &w0, 8);
+
+		for (k = 1, mask = 0; k < num; k++) {
+			memcpy(&wk, banks[k] + i, 8);
+			mask |= w0 ^ wk;
+		}
+
+		if (mask == 0)
+			continue;
+
+		for (off = i; off < i + 8; off++, mask >>= 8) {
+			if ((mask & 0xFF) == 0)
+				continue;
+
+			differ++;
+
+			if (!__bankdiff_vote(banks, num, off, out))
+				cn_vec_push_back(unclear, &off);
+		}
+	}
+#endif
+
+	// Whatever is left, byte-by-byte
+	for (; i < size; i++) {
+		out[i] = banks[0][i];
+
+		for (k = 1; k < num && banks[k][i] == banks[0][i]; k++);
+
+		if (k == num)
+			continue;
+
+		differ++;
+		off = i;
+
+		if (!__bankdiff_vote(banks, num, off, out))
+			cn_vec_push_back(unclear, &off);
+	}
+
+	return differ;
+}
@@ -0,0 +1,95 @@
+/*
+ * ARDS Utils - Bank Diff
+ *
+ * Description:
+ *     Provides an engine for finding exactly where two equally sized buffers
+ *     (such as two banks of a dump) differ. The differing bytes are merged
+ *     into runs, and each run keeps count of how many bytes and bits differ,
+ *     and which way the bits went.
+ *
+ *     The buffers are split into one part per thread. Each part is compared
+ *     16 bytes at a time with SSE2 (or 8 at a time without it), and only
+ *     blocks that differ are looked at byte-by-byte. Runs that meet at the
+ *     edge of a part are merged afterwards.
+ *
+ *     Several banks that should be mirrors can also be voted on, byte by
+ *     byte, to rebuild what they should have been. The same block compare
+ *     skips everything all banks agree on.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_BANKDIFF__
+#define __ARDS_UTILS_BANKDIFF__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Bank Diff Data Structs                                                  {{{1
+// ----------------------------------------------------------------------------
+
+// Smallest part "bankdiff" will hand to a thread
+#define BANKDIFF_MIN_PART 0x00010000
+
+// Differing bytes at most this far apart are put in the same run
+#define BANKDIFF_GAP 16
+
+/*
+ * AR_DIFF_RUN_T
+ *
+ * A run of differing bytes. It starts and ends on a byte that differs, but
+ * may have bytes that don't in between (up to the gap it was made with).
+ */
+
+typedef struct AR_DIFF_RUN_T {
+	uint32_t start;    // Offset of the first byte that differs
+	uint32_t len;      // Bytes from "start" to the last that differs
+	uint32_t bytes;    // Bytes that differ
+	uint32_t bits;     // Bits that differ
+	uint32_t bits_set; // Bits that are 0 in "a" and 1 in "b"
+	uint32_t bits_clr; // Bits that are 1 in "a" and 0 in "b"
+} ar_diff_run_t;
+
+/*
+ * AR_DIFF_PART_T
+ *
+ * A single thread's share of the work in "bankdiff".
+ */
+
+typedef struct AR_DIFF_PART_T {
+	const uint8_t *a;     // Whole buffers. Offsets stay absolute.
+	const uint8_t *b;
+	size_t         start; // This part's range
+	size_t         end;
+	size_t         gap;
+	CN_VEC         runs;  // Result
+} ar_diff_part_t;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+void  __bankdiff_byte  (ar_diff_part_t *, ar_diff_run_t *, size_t);
+void  __bankdiff_range (ar_diff_part_t *);
+void *__bankdiff_worker(void *);
+void  __bankdiff_merge (ar_diff_run_t *, const ar_diff_run_t *);
+int   __bankdiff_vote  (const uint8_t **, size_t, size_t, uint8_t *);
+
+// Bank Diff Functions
+CN_VEC bankdiff        (const uint8_t *, const uint8_t *, size_t, size_t,
+                        size_t);
+void   bankdiff_total  (CN_VEC, ar_diff_run_t *);
+size_t bankdiff_vote   (const uint8_t **, size_t, size_t, uint8_t *, CN_VEC);
+
+#endif
@@ -0,0 +1,489 @@
+/*
+ * conflict.c
+ */
+
+#include "conflict.h"
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __conflict_cmp_write
+ *
+ * Orders ranges by where they start, then by where they end.
+ */
+
+int __conflict_cmp_write(const void *x, const void *y) {
+	const ar_write_t *a = (const ar_write_t *) x,
+	                 *b = (const ar_write_t *) y;
+
+	if (a->start != b->start)
+		return (a->start > b->start) - (a->start < b->start);
+
+	return (a->end > b->end) - (a->end < b->end);
+}
+
+/*
+ * __conflict_cmp_pair
+ *
+ * Orders overlaps by the pair of cheats, then by where they start.
+ */
+
+int __conflict_cmp_pair(const void *x, const void *y) {
+	const ar_conflict_t *a = (const ar_conflict_t *) x,
+	                    *b = (const ar_conflict_t *) y;
+
+	if (a->a != b->a)
+		return (a->a > b->a) - (a->a < b->a);
+
+	if (a->b != b->b)
+		return (a->b > b->b) - (a->b < b->b);
+
+	return (a->start > b->start) - (a->start < b->start);
+}
+
+/*
+ * __conflict_push
+ *
+ * Adds a range of "len" bytes from "start" that cheat "cheat" writes to.
+ * Ranges that would go past the end of the address space stop there. A range
+ * that carries on from the last one the cheat wrote is merged into it, so
+ * loops that fill memory don't add a range every repeat.
+ */
+
+void __conflict_push(
+	ar_conflict_game_t *cg,
+	uint32_t            cheat,
+	uint64_t            start,
+	uint64_t            len
+) {
+	ar_write_t *last;
+	ar_write_t  w;
+
+	if (len == 0)
+		return;
+
+	start &= 0xFFFFFFFF;
+
+	w.start = start;
+	w.end   = (start + len - 1 > 0xFFFFFFFF) ? 0xFFFFFFFF : start + len - 1;
+	w.cheat = cheat;
+	w.max   = w.end;
+
+	if (cn_vec_size(cg->writes) > 0) {
+		last = cn_vec_at(cg->writes, cn_vec_size(cg->writes) - 1);
+
+		if (
+			last->cheat == cheat &&
+			last->end   != 0xFFFFFFFF &&
+			last->end + 1 == w.start
+		) {
+			last->end = last->max = w.end;
+			return;
+		}
+	}
+
+	cn_vec_push_back(cg->writes, &w);
+}
+
+/*
+ * __conflict_decode
+ *
+ * Works out every range of bytes the "num" lines of cheat "cheat" write to.
+ * The offset is followed for as long as it's known. Once it comes from RAM,
+ * writes that use it are only counted, until D2 or D3 sets it again.
+ *
+ * A C0 loop is gone through again at each D1 or D2 while it has repeats left,
+ * like the ARDS does, so writes that move with the offset land where every
+ * repeat puts them. Once a repeat starts where the last one did, the rest
+ * would write the same bytes, so they're skipped. If the cheat goes past
+ * CONFLICT_MAX_STEPS lines, the loop is gone through one last time with the
+ * offset unknown, and its writes are only counted.
+ */
+
+void __conflict_decode(
+	ar_conflict_game_t *cg,
+	uint32_t            cheat,
+	const ar_line_t    *lines,
+	size_t              num
+) {
+	ar_cheat_ref_t *ref;
+	uint32_t        l, r, x, size, offset, count, loop_offset;
+	uint8_t         known, loop, loop_known;
+	size_t          i, loop_start, steps;
+
+	ref         = cn_vec_at(cg->cheats, cheat);
+	offset      = 0;
+	known       = 1;
+	loop        = 0;
+	count       = 0;
+	loop_start  = 0;
+	loop_offset = 0;
+	loop_known  = 1;
+	steps       = 0;
+
+	for (i = 0; i < num; i++, steps++) {
+		l = lines[i].memory_location;
+		r = lines[i].value;
+		x = l & 0x0FFFFFFF;
+
+		switch (l >> 28) {
+			case 0x0:
+			case 0x1:
+			case 0x2:
+				// Writes, aligned down like the ARM9 does
+				size = 4 >> (l >> 28);
+
+				x = (x + offset) & ~(size - 1);
+
+				if (known)
+					__conflict_push(cg, cheat, x, size);
+				else
+					ref->dynamic++;
+
+				break;
+
+			case 0xB:
+				// Offset is read from RAM
+				known = 0;
+				break;
+
+			case 0xC:
+				if ((l >> 24) == 0xC0) {
+					loop        = 1;
+					count       = r;
+					loop_start  = i + 1;
+					loop_offset = offset;
+					loop_known  = known;
+				}
+				else
+				if ((l >> 24) == 0xC6)
+					__conflict_push(cg, cheat, r & ~3, 4);
+
+				break;
+
+			case 0xD:
+				switch (l >> 24) {
+					case 0xD1:
+					case 0xD2:
+						// Every repeat left is the same as this one
+						if (offset == loop_offset && known == loop_known)
+							count = 0;
+
+						if (loop && count > 0) {
+							count--;
+
+							if (steps >= CONFLICT_MAX_STEPS) {
+								// Too many. Go through it once more, unplaced.
+								count = 0;
+								known = 0;
+							}
+
+							loop_offset = offset;
+							loop_known  = known;
+							i           = loop_start - 1;
+							break;
+						}
+
+						loop = 0;
+
+						if ((l >> 24) == 0xD2) {
+							offset = 0;
+							known  = 1;
+						}
+
+						break;
+
+					case 0xD3:
+						offset = r;
+						known  = 1;
+						break;
+
+					case 0xDC:
+						offset += r;
+						break;
+
+					case 0xD6:
+					case 0xD7:
+					case 0xD8:
+						// Writes move the offset along
+						size = 4 >> ((l >> 24) - 0xD6);
+
+						if (known)
+							__conflict_push(cg, cheat, r + offset, size);
+						else
+							ref->dynamic++;
+
+						offset += size;
+						break;
+				}
+
+				break;
+
+			case 0xE:
+				// Patch. The data follows in the next lines.
+				if (known)
+					__conflict_push(cg, cheat, (uint64_t) x + offset, r);
+				else
+					ref->dynamic++;
+
+				i += r / 8 + (r % 8 != 0);
+				break;
+
+			case 0xF:
+				// Copy to an address that's given outright
+				__conflict_push(cg, cheat, x, r);
+				break;
+		}
+	}
+
+	cg->dynamic += ref->dynamic;
+}
+
+/*
+ * __conflict_walk
+ *
+ * Adds every cheat in "root" to "cheats", in the order the ARDS shows them,
+ * going into folders. "path" is the path of folders so far, of length "len".
+ * "folder" is the AR_FLAG_ONLYONE folder "root" is, if it is one.
+ */
+
+void __conflict_walk(
+	ar_conflict_game_t *cg,
+	CN_VEC              root,
+	char               *path,
+	size_t              len,
+	uint32_t            folder
+) {
+	ar_data_t      *it;
+	ar_cheat_ref_t  ref;
+
+	cn_vec_rtraverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		snprintf(
+			&path[len],
+			CONFLICT_PATH_SZ - len,
+			"%s%s",
+			(len > 0) ? "/" : "",
+			(it->name != NULL) ? it->name : ""
+		);
+
+		switch (it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				ref.data    = it;
+				ref.path    = strdup(path);
+				ref.folder  = folder;
+				ref.dynamic = 0;
+
+				cn_vec_push_back(cg->cheats, &ref);
+
+				__conflict_decode(
+					cg,
+					cn_vec_size(cg->cheats) - 1,
+					cn_vec_array(it->data, ar_line_t),
+					cn_vec_size(it->data)
+				);
+
+				break;
+
+			case AR_FLAG_FOLDER:
+				__conflict_walk(
+					cg,
+					it->data,
+					path,
+					strlen(path),
+					(it->flag & AR_FLAG_ONLYONE)
+						? cg->folders++
+						: CONFLICT_NO_FOLDER
+				);
+
+				break;
+		}
+
+		path[len] = '\0';
+	}
+}
+
+/*
+ * __conflict_tree
+ *
+ * Fills in "max" for the subtree over "w[lo, hi)", whose root is the middle.
+ * Returns it.
+ */
+
+uint32_t __conflict_tree(ar_write_t *w, size_t lo, size_t hi) {
+	size_t   mid;
+	uint32_t left, right;
+
+	if (lo >= hi)
+		return 0;
+
+	mid   = lo + (hi - lo) / 2;
+	left  = __conflict_tree(w, lo, mid);
+	right = __conflict_tree(w, mid + 1, hi);
+
+	w[mid].max = w[mid].end;
+
+	if (left > w[mid].max)
+		w[mid].max = left;
+
+	if (right > w[mid].max)
+		w[mid].max = right;
+
+	return w[mid].max;
+}
+
+/*
+ * __conflict_query
+ *
+ * Finds every range in the subtree over "w[lo, hi)" that comes after range
+ * "i" and overlaps it, from another cheat, and adds it to "hits".
+ */
+
+void __conflict_query(
+	ar_conflict_game_t *cg,
+	size_t              lo,
+	size_t              hi,
+	size_t              i,
+	CN_VEC              hits
+) {
+	ar_write_t    *w, *q;
+	ar_conflict_t  hit;
+	size_t         mid;
+
+	if (lo >= hi)
+		return;
+
+	w   = cn_vec_array(cg->writes, ar_write_t);
+	q   = &w[i];
+	mid = lo + (hi - lo) / 2;
+
+	// Nothing in here gets as far as "q"
+	if (w[mid].max < q->start)
+		return;
+
+	__conflict_query(cg, lo, mid, i, hits);
+
+	// Everything right of "mid" starts at or after it
+	if (w[mid].start > q->end)
+		return;
+
+	if (mid > i && w[mid].end >= q->start && w[mid].cheat != q->cheat) {
+		hit.a        = (q->cheat < w[mid].cheat) ? q->cheat : w[mid].cheat;
+		hit.b        = (q->cheat < w[mid].cheat) ? w[mid].cheat : q->cheat;
+		hit.start    = w[mid].start;
+		hit.end      = (w[mid].end < q->end) ? w[mid].end : q->end;
+		hit.overlaps = 1;
+		hit.expected = 0;
+
+		cn_vec_push_back(hits, &hit);
+	}
+
+	__conflict_query(cg, mid + 1, hi, i, hits);
+}
+
+// ----------------------------------------------------------------------------
+// Conflict Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * conflict_init
+ *
+ * Sets up "cg" to analyse "game". The game isn't copied, and has to outlive
+ * it.
+ */
+
+void conflict_init(ar_conflict_game_t *cg, ARDS_GAME game) {
+	cg->game      = game;
+	cg->cheats    = cn_vec_init(ar_cheat_ref_t);
+	cg->writes    = cn_vec_init(ar_write_t);
+	cg->conflicts = cn_vec_init(ar_conflict_t);
+	cg->folders   = 0;
+	cg->dynamic   = 0;
+	cg->expected  = 0;
+}
+
+/*
+ * conflict_find
+ *
+ * Finds every pair of cheats in the game that write to the same bytes.
+ * Returns how many pairs there are.
+ */
+
+size_t conflict_find(ar_conflict_game_t *cg) {
+	ar_write_t     *w;
+	ar_conflict_t  *hit, *last;
+	ar_cheat_ref_t *cheats;
+	CN_VEC          hits;
+	char            path[CONFLICT_PATH_SZ];
+	size_t          i, n;
+
+	path[0] = '\0';
+	__conflict_walk(cg, cg->game->library, path, 0, CONFLICT_NO_FOLDER);
+
+	// Build the tree
+	n = cn_vec_size(cg->writes);
+	w = cn_vec_array(cg->writes, ar_write_t);
+
+	qsort(w, n, sizeof(ar_write_t), __conflict_cmp_write);
+	__conflict_tree(w, 0, n);
+
+	// Every overlap, once
+	hits = cn_vec_init(ar_conflict_t);
+
+	for (i = 0; i < n; i++)
+		__conflict_query(cg, 0, n, i, hits);
+
+	// Merge them into one per pair of cheats
+	qsort(
+		cn_vec_data(hits),
+		cn_vec_size(hits),
+		sizeof(ar_conflict_t),
+		__conflict_cmp_pair
+	);
+
+	cheats = cn_vec_array(cg->cheats, ar_cheat_ref_t);
+	last   = NULL;
+
+	cn_vec_traverse(hits, hit) {
+		if (last != NULL && last->a == hit->a && last->b == hit->b) {
+			if (hit->end > last->end)
+				last->end = hit->end;
+
+			last->overlaps++;
+			continue;
+		}
+
+		hit->expected = (
+			cheats[hit->a].folder != CONFLICT_NO_FOLDER &&
+			cheats[hit->a].folder == cheats[hit->b].folder
+		);
+
+		cg->expected += hit->expected;
+
+		cn_vec_push_back(cg->conflicts, hit);
+		last = cn_vec_at(cg->conflicts, cn_vec_size(cg->conflicts) - 1);
+	}
+
+	cn_vec_free(hits);
+
+	return cn_vec_size(cg->conflicts);
+}
+
+/*
+ * conflict_free
+ */
+
+void conflict_free(ar_conflict_game_t *cg) {
+	ar_cheat_ref_t *it;
+
+	cn_vec_traverse(cg->cheats, it)
+		free(it->path);
+
+	cn_vec_free(cg->cheats);
+	cn_vec_free(cg->writes);
+	cn_vec_free(cg->conflicts);
+}
@@ -0,0 +1,131 @@
+/*
+ * ARDS Utils - Conflict
+ *
+ * Description:
+ *     Provides an analyser for finding cheats in a game that write to the
+ *     same addresses, and so fight each other when they're on together.
+ *
+ *     Each cheat's lines are gone through once to work out the ranges of
+ *     bytes it writes to, without running it. Writes that depend on a
+ *     pointer read from RAM (after a B code) can't be placed, so they are
+ *     only counted. Every conditional is assumed to pass, and C0 loops are
+ *     gone through once per repeat, so writes that move with the offset
+ *     cover every repeat.
+ *
+ *     The ranges of every cheat in a game go into an interval tree: an array
+ *     sorted by start, where the middle of each range of the array is the
+ *     root of a subtree, and keeps the last byte any range in the subtree
+ *     writes. Each range is then looked up in the tree to find the ones
+ *     after it that overlap, skipping every subtree that ends before it.
+ *
+ *     Overlaps are merged into one conflict per pair of cheats. Pairs in the
+ *     same folder that only allows one cheat on at once (AR_FLAG_ONLYONE)
+ *     are still reported, but marked as expected.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_CONFLICT__
+#define __ARDS_UTILS_CONFLICT__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "io.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Conflict Data Structs                                                   {{{1
+// ----------------------------------------------------------------------------
+
+#define CONFLICT_NO_FOLDER 0xFFFFFFFF // Cheat isn't in an AR_FLAG_ONLYONE one
+#define CONFLICT_PATH_SZ   1024       // Longest "Folder/Cheat" path kept
+#define CONFLICT_MAX_STEPS 0x10000    // Lines gone through per cheat
+
+/*
+ * AR_WRITE_T
+ *
+ * A range of bytes a cheat writes to. Also a node of the interval tree.
+ */
+
+typedef struct AR_WRITE_T {
+	uint32_t start; // First byte written
+	uint32_t end;   // Last byte written
+	uint32_t cheat; // Index into "cheats"
+	uint32_t max;   // Largest "end" in the subtree this is the root of
+} ar_write_t;
+
+/*
+ * AR_CHEAT_REF_T
+ *
+ * A cheat of the game being analysed.
+ */
+
+typedef struct AR_CHEAT_REF_T {
+	ar_data_t *data;
+	char      *path;    // "Folder/Cheat"
+	uint32_t   folder;  // AR_FLAG_ONLYONE folder it's directly in
+	uint32_t   dynamic; // Writes that couldn't be placed
+} ar_cheat_ref_t;
+
+/*
+ * AR_CONFLICT_T
+ *
+ * A pair of cheats that write to some of the same bytes.
+ */
+
+typedef struct AR_CONFLICT_T {
+	uint32_t a;        // Cheats, with "a" before "b"
+	uint32_t b;
+	uint32_t start;    // First byte both write to
+	uint32_t end;      // Last byte both write to
+	uint32_t overlaps; // Pairs of ranges that overlap
+	uint8_t  expected; // Both are in the same AR_FLAG_ONLYONE folder
+} ar_conflict_t;
+
+/*
+ * AR_CONFLICT_GAME_T
+ *
+ * Everything found about a single game.
+ */
+
+typedef struct AR_CONFLICT_GAME_T {
+	ARDS_GAME game;
+	CN_VEC    cheats;    // ar_cheat_ref_t, in the order the ARDS shows them
+	CN_VEC    writes;    // ar_write_t, sorted into the interval tree
+	CN_VEC    conflicts; // ar_conflict_t, sorted by "a" then "b"
+	uint32_t  folders;   // AR_FLAG_ONLYONE folders seen
+	uint32_t  dynamic;   // Writes that couldn't be placed, over every cheat
+	size_t    expected;  // Conflicts that are expected
+} ar_conflict_game_t;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+int      __conflict_cmp_write(const void *, const void *);
+int      __conflict_cmp_pair (const void *, const void *);
+void     __conflict_push     (ar_conflict_game_t *, uint32_t, uint64_t,
+                              uint64_t);
+void     __conflict_decode   (ar_conflict_game_t *, uint32_t,
+                              const ar_line_t *, size_t);
+void     __conflict_walk     (ar_conflict_game_t *, CN_VEC, char *, size_t,
+                              uint32_t);
+uint32_t __conflict_tree     (ar_write_t *, size_t, size_t);
+void     __conflict_query    (ar_conflict_game_t *, size_t, size_t, size_t,
+                              CN_VEC);
+
+// Conflict Functions
+void   conflict_init(ar_conflict_game_t *, ARDS_GAME);
+size_t conflict_find(ar_conflict_game_t *);
+void   conflict_free(ar_conflict_game_t *);
+
+#endif
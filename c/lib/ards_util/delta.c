@@ -0,0 +1,513 @@
+/*
+ * ARDS Utils - Delta
+ *
+ * Description:
+ *     Provides binary deltas between two buffers. See "delta.h" for how
+ *     matches are found and how a delta is stored.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include "delta.h"
+
+// Multiplier for the rolling hash
+#define DELTA_HASH_MUL 0x01000193
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __delta_hash
+ *
+ * Polynomial hash of the "len" bytes at "bytes". Rolled forward a byte at a
+ * time in "delta_compute".
+ */
+
+uint32_t __delta_hash(const uint8_t *bytes, size_t len) {
+	uint32_t h;
+	size_t   i;
+
+	for (i = 0, h = 0; i < len; i++)
+		h = h * DELTA_HASH_MUL + bytes[i];
+
+	return h;
+}
+
+/*
+ * __delta_extend
+ *
+ * Returns how many bytes at "a" and "b" match, up to however many are left
+ * in the shorter of the two.
+ */
+
+size_t __delta_extend(
+	const uint8_t *a,
+	size_t         a_len,
+	const uint8_t *b,
+	size_t         b_len
+) {
+	size_t i, max;
+
+	max = (a_len < b_len) ? a_len : b_len;
+
+	for (i = 0; i < max && a[i] == b[i]; i++);
+
+	return i;
+}
+
+/*
+ * __delta_push
+ *
+ * Appends an operation to "ops". A COPY that picks up right where the last
+ * one left off (in both "src" and "dst") is merged into it.
+ */
+
+void __delta_push(
+	CN_VEC   ops,
+	uint32_t type,
+	uint32_t dst_off,
+	uint32_t src_off,
+	uint32_t len
+) {
+	ar_delta_op_t op, *last;
+
+	if (len == 0)
+		return;
+
+	if (cn_vec_size(ops) > 0) {
+		last = (ar_delta_op_t *) cn_vec_at(ops, cn_vec_size(ops) - 1);
+
+		if (
+			type == AR_DELTA_COPY                 &&
+			last->type == AR_DELTA_COPY           &&
+			last->dst_off + last->len == dst_off  &&
+			last->src_off + last->len == src_off
+		) {
+			last->len += len;
+			return;
+		}
+	}
+
+	op.type    = type;
+	op.dst_off = dst_off;
+	op.src_off = src_off;
+	op.len     = len;
+
+	cn_vec_push_back(ops, &op);
+}
+
+/*
+ * __delta_varint_size
+ *
+ * Bytes "__delta_write_varint" would write for "v".
+ */
+
+size_t __delta_varint_size(uint64_t v) {
+	size_t n;
+
+	for (n = 1; v >= 0x80; v >>= 7)
+		n++;
+
+	return n;
+}
+
+/*
+ * __delta_write_varint
+ *
+ * Writes "v" 7 bits at a time, lowest first. The top bit of each byte is set
+ * if more follow.
+ */
+
+void __delta_write_varint(FILE *fp, uint64_t v) {
+	for (; v >= 0x80; v >>= 7)
+		fputc((v & 0x7F) | 0x80, fp);
+
+	fputc(v, fp);
+}
+
+/*
+ * __delta_read_varint
+ *
+ * Reads a varint written by "__delta_write_varint" into "v". Returns 0 on
+ * success, or -1 if the file ended or the value is too long.
+ */
+
+int __delta_read_varint(FILE *fp, uint64_t *v) {
+	int    c;
+	size_t shift;
+
+	for (*v = 0, shift = 0; shift < 64; shift += 7) {
+		if ((c = fgetc(fp)) == EOF)
+			return -1;
+
+		*v |= (uint64_t) (c & 0x7F) << shift;
+
+		if (!(c & 0x80))
+			return 0;
+	}
+
+	return -1;
+}
+
+// ----------------------------------------------------------------------------
+// Delta Functions                                                         {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * delta_compute
+ *
+ * Finds the operations that build "dst" (of "dst_sz" bytes) out of "src" (of
+ * "src_sz" bytes). "block_sz" is the smallest match looked for, and 0 means
+ * DELTA_BLOCK_SZ. Returns a CN_VEC of ar_delta_op_t, in "dst" order.
+ *
+ * At each position, continuing on from the last match is tried first, since
+ * most of a new revision lines up with the old one. Then every block in the
+ * rolling hash's bucket is tried, and the longest match wins.
+ */
+
+CN_VEC delta_compute(
+	const uint8_t *src,
+	size_t         src_sz,
+	const uint8_t *dst,
+	size_t         dst_sz,
+	size_t         block_sz
+) {
+	CN_VEC    ops;
+	uint32_t *hashes, h, top;
+	int32_t  *head, *next, k;
+	size_t    num_blocks, bits, i, pos, lit, prev_end, expect, chain;
+	size_t    len, best_len, best_src, back;
+
+	ops = cn_vec_init(ar_delta_op_t);
+
+	if (block_sz == 0)
+		block_sz = DELTA_BLOCK_SZ;
+
+	// Index every whole block of "src" by hash
+	num_blocks = src_sz / block_sz;
+
+	for (bits = 4; ((size_t) 1 << bits) < num_blocks * 2; bits++);
+
+	hashes = (uint32_t *) malloc(sizeof(uint32_t) * (num_blocks + 1));
+	next   = (int32_t  *) malloc(sizeof(int32_t)  * (num_blocks + 1));
+	head   = (int32_t  *) malloc(sizeof(int32_t)  * ((size_t) 1 << bits));
+
+	for (i = 0; i < ((size_t) 1 << bits); i++)
+		head[i] = -1;
+
+	// Insert backwards, so the earliest block is first in each chain
+	for (i = num_blocks; i > 0; i--) {
+		hashes[i - 1] = __delta_hash(&src[(i - 1) * block_sz], block_sz);
+
+		k             = (hashes[i - 1] * 0x9E3779B1u) >> (32 - bits);
+		next[i - 1]   = head[k];
+		head[k]       = i - 1;
+	}
+
+	// Multiplier^(block_sz - 1), to roll the oldest byte out
+	for (i = 1, top = 1; i < block_sz; i++)
+		top *= DELTA_HASH_MUL;
+
+	pos      = 0; // Current position in "dst"
+	lit      = 0; // Start of bytes not matched yet
+	prev_end = 0; // Where the last COPY ended in "src"
+
+	if (dst_sz >= block_sz)
+		h = __delta_hash(dst, block_sz);
+
+	while (pos + block_sz <= dst_sz) {
+		best_len = 0;
+		best_src = 0;
+
+		// Carrying on from the last match, as if the bytes since were changed
+		expect = prev_end + (pos - lit);
+
+		if (expect + block_sz <= src_sz) {
+			len = __delta_extend(
+				&src[expect], src_sz - expect, &dst[pos], dst_sz - pos
+			);
+
+			if (len >= block_sz) {
+				best_len = len;
+				best_src = expect;
+			}
+		}
+
+		// Every block with the same hash
+		k = head[(h * 0x9E3779B1u) >> (32 - bits)];
+
+		for (chain = 0; k != -1 && chain < DELTA_MAX_CHAIN; k = next[k]) {
+			chain++;
+
+			if (hashes[k] != h)
+				continue;
+
+			len = __delta_extend(
+				&src[k * block_sz],
+				src_sz - k * block_sz,
+				&dst[pos],
+				dst_sz - pos
+			);
+
+			if (len >= block_sz && len > best_len) {
+				best_len = len;
+				best_src = k * block_sz;
+			}
+		}
+
+		if (best_len == 0) {
+			// No match. Roll the hash forward a byte.
+			if (pos + block_sz < dst_sz)
+				h = (h - dst[pos] * top) * DELTA_HASH_MUL + dst[pos + block_sz];
+
+			pos++;
+			continue;
+		}
+
+		// Grow the match backwards into the bytes not matched yet
+		for (
+			back = 0;
+			pos - back > lit && best_src - back > 0 &&
+			dst[pos - back - 1] == src[best_src - back - 1];
+			back++
+		);
+
+		__delta_push(ops, AR_DELTA_ADD, lit, 0, pos - back - lit);
+		__delta_push(
+			ops,
+			AR_DELTA_COPY,
+			pos - back,
+			best_src - back,
+			best_len + back
+		);
+
+		pos     += best_len;
+		lit      = pos;
+		prev_end = best_src + best_len;
+
+		if (pos + block_sz <= dst_sz)
+			h = __delta_hash(&dst[pos], block_sz);
+	}
+
+	// Whatever is left at the end
+	__delta_push(ops, AR_DELTA_ADD, lit, 0, dst_sz - lit);
+
+	free(hashes);
+	free(next);
+	free(head);
+
+	return ops;
+}
+
+/*
+ * delta_size
+ *
+ * Bytes "delta_write" would write for "ops", header included.
+ */
+
+size_t delta_size(CN_VEC ops) {
+	ar_delta_op_t *op;
+	size_t         sz;
+	int64_t        rel;
+	uint32_t       prev_end;
+
+	sz       = sizeof(ar_delta_header_t) + 1;
+	prev_end = 0;
+
+	cn_vec_traverse(ops, op) {
+		sz += __delta_varint_size(((uint64_t) op->len << 1) | op->type);
+
+		if (op->type == AR_DELTA_ADD) {
+			sz += op->len;
+			continue;
+		}
+
+		// Zigzag
+		rel       = (int64_t) op->src_off - prev_end;
+		sz       += __delta_varint_size((rel << 1) ^ (rel >> 63));
+		prev_end  = op->src_off + op->len;
+	}
+
+	return sz;
+}
+
+/*
+ * delta_write
+ *
+ * Writes "ops" (from "delta_compute") to "fp" as a delta file. "dst" is
+ * needed for the bytes of each ADD. Returns the number of bytes written.
+ */
+
+size_t delta_write(
+	FILE          *fp,
+	CN_VEC         ops,
+	const uint8_t *src,
+	size_t         src_sz,
+	const uint8_t *dst,
+	size_t         dst_sz
+) {
+	ar_delta_header_t  header;
+	ar_delta_op_t     *op;
+	int64_t            rel;
+	uint32_t           prev_end;
+
+	memcpy(header.magic, DELTA_MAGIC, 4);
+	header.src_size = src_sz;
+	header.dst_size = dst_sz;
+	header.src_crc  = crc16(0xFFFF, src_sz, (uint8_t *) src);
+	header.dst_crc  = crc16(0xFFFF, dst_sz, (uint8_t *) dst);
+
+	fwrite(&header, sizeof(ar_delta_header_t), 1, fp);
+
+	prev_end = 0;
+
+	cn_vec_traverse(ops, op) {
+		__delta_write_varint(fp, ((uint64_t) op->len << 1) | op->type);
+
+		if (op->type == AR_DELTA_ADD) {
+			fwrite(&dst[op->dst_off], sizeof(uint8_t), op->len, fp);
+			continue;
+		}
+
+		rel      = (int64_t) op->src_off - prev_end;
+		prev_end = op->src_off + op->len;
+
+		__delta_write_varint(fp, (rel << 1) ^ (rel >> 63));
+	}
+
+	// End of operations
+	__delta_write_varint(fp, 0);
+
+	return delta_size(ops);
+}
+
+/*
+ * delta_apply
+ *
+ * Reads a delta from "fp" and applies it to "src" (of "src_sz" bytes). On
+ * success, "out" is set to a malloc'd buffer of the result, and "out_sz" to
+ * its size. Returns one of AR_DELTA_*. "out" is only set on AR_DELTA_OK.
+ */
+
+int delta_apply(
+	FILE          *fp,
+	const uint8_t *src,
+	size_t         src_sz,
+	uint8_t      **out,
+	size_t        *out_sz
+) {
+	ar_delta_header_t  header;
+	uint8_t           *dst;
+	uint64_t           tag, zz, len;
+	int64_t            src_off;
+	size_t             pos;
+	uint32_t           prev_end;
+	int                status;
+
+	if (
+		fread(&header, sizeof(ar_delta_header_t), 1, fp) != 1 ||
+		memcmp(header.magic, DELTA_MAGIC, 4) != 0
+	) {
+		return AR_DELTA_BAD_HEADER;
+	}
+
+	if (
+		header.src_size != src_sz ||
+		header.src_crc  != crc16(0xFFFF, src_sz, (uint8_t *) src)
+	) {
+		return AR_DELTA_WRONG_SOURCE;
+	}
+
+	// Bigger than any firmware. Don't trust it.
+	if (header.dst_size > DELTA_MAX_SIZE)
+		return AR_DELTA_CORRUPT;
+
+	dst = (uint8_t *) malloc((size_t) header.dst_size + 1);
+
+	if (dst == NULL)
+		return AR_DELTA_NO_MEMORY;
+
+	pos      = 0;
+	prev_end = 0;
+	status   = AR_DELTA_CORRUPT;
+
+	while (__delta_read_varint(fp, &tag) == 0) {
+		// End of operations
+		if (tag == 0) {
+			status = AR_DELTA_OK;
+			break;
+		}
+
+		len = tag >> 1;
+
+		if (len > header.dst_size - pos)
+			break;
+
+		if ((tag & 1) == AR_DELTA_ADD) {
+			if (fread(&dst[pos], sizeof(uint8_t), len, fp) != len)
+				break;
+		}
+		else {
+			if (__delta_read_varint(fp, &zz) != 0)
+				break;
+
+			src_off = (int64_t) prev_end + (int64_t) ((zz >> 1) ^ -(zz & 1));
+
+			if (src_off < 0 || src_off + len > src_sz)
+				break;
+
+			memcpy(&dst[pos], &src[src_off], len);
+			prev_end = src_off + len;
+		}
+
+		pos += len;
+	}
+
+	if (status == AR_DELTA_OK && pos != header.dst_size)
+		status = AR_DELTA_CORRUPT;
+
+	if (status == AR_DELTA_OK && crc16(0xFFFF, pos, dst) != header.dst_crc)
+		status = AR_DELTA_BAD_RESULT;
+
+	if (status != AR_DELTA_OK) {
+		free(dst);
+		return status;
+	}
+
+	*out    = dst;
+	*out_sz = pos;
+
+	return AR_DELTA_OK;
+}
+
+/*
+ * delta_strerror
+ *
+ * Describes a status from "delta_apply".
+ */
+
+const char *delta_strerror(int status) {
+	switch (status) {
+		case AR_DELTA_OK:
+			return "Success";
+
+		case AR_DELTA_BAD_HEADER:
+			return "Not a delta file";
+
+		case AR_DELTA_WRONG_SOURCE:
+			return "Delta was made from a different source";
+
+		case AR_DELTA_CORRUPT:
+			return "Delta is corrupt";
+
+		case AR_DELTA_BAD_RESULT:
+			return "Result doesn't match the delta's checksum";
+
+		case AR_DELTA_NO_MEMORY:
+			return "Not enough memory for the result";
+	}
+
+	return "Unknown error";
+}
@@ -0,0 +1,127 @@
+/*
+ * ARDS Utils - Delta
+ *
+ * Description:
+ *     Provides binary deltas between two buffers, such as two firmware
+ *     payloads. A delta is a list of operations that build the new buffer
+ *     ("dst") out of the old one ("src"):
+ *
+ *         COPY: "len" bytes from "src" at "src_off"
+ *         ADD:  "len" bytes that are only in "dst", stored in the delta
+ *
+ *     Matches are found rsync-style. "src" is cut into fixed-size blocks,
+ *     each indexed by a rolling hash. A hash is then rolled over "dst" one
+ *     byte at a time, and wherever it hits a block, the match is grown in
+ *     both directions as far as the bytes agree.
+ *
+ *     Written to disk, a delta is a 16 byte header, followed by operations.
+ *     Each one starts with a varint of (len << 1 | type). An ADD is followed
+ *     by its bytes. A COPY is followed by a zigzag varint of how far its
+ *     "src_off" is from where the last COPY ended, which is 0 for anything
+ *     that didn't move. A 0 ends the list.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_DELTA__
+#define __ARDS_UTILS_DELTA__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "firmware.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Delta Data Structs                                                      {{{1
+// ----------------------------------------------------------------------------
+
+#define DELTA_MAGIC     "ARDD"
+#define DELTA_BLOCK_SZ  32         // Default block size for matching
+#define DELTA_MAX_CHAIN 16         // Most blocks tried per hash bucket
+#define DELTA_MAX_SIZE  0x10000000 // Largest "dst" to make (256 MiB)
+
+/*
+ * AR_DELTA_OP_TYPE_T
+ */
+
+typedef enum AR_DELTA_OP_TYPE_T {
+	AR_DELTA_ADD  = 0,
+	AR_DELTA_COPY = 1
+} ar_delta_op_type_t;
+
+/*
+ * AR_DELTA_OP_T
+ *
+ * A single operation. "dst_off" is where its bytes land in "dst".
+ */
+
+typedef struct AR_DELTA_OP_T {
+	uint32_t type;    // AR_DELTA_ADD or AR_DELTA_COPY
+	uint32_t dst_off; // Offset in "dst"
+	uint32_t src_off; // Offset in "src" (COPY only)
+	uint32_t len;     // Bytes
+} ar_delta_op_t;
+
+/*
+ * AR_DELTA_HEADER_T
+ *
+ * First 16 bytes of a delta file. The CRC16s make sure it's applied to the
+ * right "src", and that the result is right.
+ */
+
+typedef struct AR_DELTA_HEADER_T {
+	                   // Bytes    Description
+	                   // ---      ---
+	char     magic[4]; // 00 - 03. "ARDD"
+	uint32_t src_size; // 04 - 07. Bytes in "src"
+	uint32_t dst_size; // 08 - 11. Bytes in "dst"
+	uint16_t src_crc;  // 12 - 13. crc16(0xFFFF, src)
+	uint16_t dst_crc;  // 14 - 15. crc16(0xFFFF, dst)
+} ar_delta_header_t;
+
+/*
+ * AR_DELTA_STATUS_T
+ *
+ * Results of "delta_apply".
+ */
+
+typedef enum AR_DELTA_STATUS_T {
+	AR_DELTA_OK = 0,
+	AR_DELTA_BAD_HEADER,   // Not a delta
+	AR_DELTA_WRONG_SOURCE, // Made from a different "src"
+	AR_DELTA_CORRUPT,      // Operations don't fit, or file ended early
+	AR_DELTA_BAD_RESULT,   // Result doesn't match "dst_crc"
+	AR_DELTA_NO_MEMORY     // Couldn't allocate "dst"
+} ar_delta_status_t;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+uint32_t __delta_hash        (const uint8_t *, size_t);
+size_t   __delta_extend      (const uint8_t *, size_t, const uint8_t *, size_t);
+void     __delta_push        (CN_VEC, uint32_t, uint32_t, uint32_t, uint32_t);
+size_t   __delta_varint_size (uint64_t);
+void     __delta_write_varint(FILE *, uint64_t);
+int      __delta_read_varint (FILE *, uint64_t *);
+
+// Delta Functions
+CN_VEC      delta_compute (const uint8_t *, size_t, const uint8_t *, size_t,
+                           size_t);
+size_t      delta_size    (CN_VEC);
+size_t      delta_write   (FILE *, CN_VEC, const uint8_t *, size_t,
+                           const uint8_t *, size_t);
+int         delta_apply   (FILE *, const uint8_t *, size_t, uint8_t **,
+                           size_t *);
+const char *delta_strerror(int);
+
+#endif
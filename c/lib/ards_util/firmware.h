@@ -12,9 +12,43 @@
 #ifndef __ARDS_UTILS_FIRMWARE__
 #define __ARDS_UTILS_FIRMWARE__
 
+#include <stdio.h>
 #include <stdlib.h>
 #include <stdint.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
 
-uint16_t crc16(uint16_t, size_t, uint8_t *);
+// Firmware files are "FIRM", a 32-bit checksum, then the payload
+#define FIRMWARE_MAGIC     "FIRM"
+#define FIRMWARE_HEADER_SZ 8
+
+// Smallest part "crc16_parallel" will hand to a thread
+#define CRC16_MIN_PART 0x00040000
+
+/*
+ * CRC16_PART_T
+ *
+ * A single thread's share of the work in "crc16_parallel".
+ */
+
+typedef struct CRC16_PART_T {
+	uint16_t  mask;  // Starting value
+	uint16_t  crc;   // Result
+	size_t    size;  // Bytes in this part
+	uint8_t  *bytes; // Start of this part
+} crc16_part_t;
+
+uint16_t crc16         (uint16_t, size_t, uint8_t *);
+uint16_t crc16_combine (uint16_t, uint16_t, uint16_t, size_t);
+uint16_t crc16_parallel(uint16_t, size_t, uint8_t *, size_t);
+
+size_t   firmware_trim (const uint8_t *, size_t);
+int      firmware_load (const char *, uint8_t **, size_t *, uint32_t *);
+
+// Internal
+uint16_t __gf2_times   (const uint16_t *, uint16_t);
+void     __gf2_square  (uint16_t *, const uint16_t *);
+void    *__crc16_worker(void *);
 
 #endif
@@ -20,12 +20,30 @@
 #include <stdlib.h>
 #include <string.h>
 #include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+// Bytes at the start of the ROM that the Game ID covers
+#define GAMEID_HEADER_SZ 0x200
 
 // Utility
 uint32_t reverse(uint32_t);
 uint32_t crc32  (const char *, size_t);
 
+// Streaming CRC-32
+uint32_t crc32_init  ();
+uint32_t crc32_update(uint32_t, const void *, size_t);
+uint32_t crc32_final (uint32_t);
+
+// CRC-32 implementations "crc32_update" picks from
+uint32_t crc32_update_table(uint32_t, const void *, size_t);
+uint32_t crc32_update_clmul(uint32_t, const void *, size_t);
+int      crc32_has_clmul   ();
+
 // Convenience
-void get_gameid(const char *, char *);
+void get_gameid_from_header(const uint8_t *, char *);
+int  get_gameid_fd         (int, uint8_t *, char *);
+int  get_gameid            (const char *, char *);
 
 #endif
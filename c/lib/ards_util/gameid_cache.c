@@ -0,0 +1,315 @@
+/*
+ * ARDS Utils - Game ID Cache
+ *
+ * Description:
+ *     Provides an on-disk cache of Game IDs, keyed by the identity of the
+ *     file they came from. See "gameid_cache.h" for the file layout.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include "gameid_cache.h"
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __cache_cmp
+ *
+ * qsort/bsearch comparator. Orders entries by device, then inode.
+ */
+
+int __cache_cmp(const void *a, const void *b) {
+	const ar_gameid_cache_entry_t *x, *y;
+
+	x = (const ar_gameid_cache_entry_t *) a;
+	y = (const ar_gameid_cache_entry_t *) b;
+
+	if (x->dev != y->dev)
+		return (x->dev < y->dev) ? -1 : 1;
+
+	if (x->ino != y->ino)
+		return (x->ino < y->ino) ? -1 : 1;
+
+	return 0;
+}
+
+/*
+ * __cache_key
+ *
+ * Fills in everything but the Game ID of "entry" from "st".
+ */
+
+void __cache_key(ar_gameid_cache_entry_t *entry, const struct stat *st) {
+	memset(entry, 0, sizeof(ar_gameid_cache_entry_t));
+
+	entry->dev        = st->st_dev;
+	entry->ino        = st->st_ino;
+	entry->size       = st->st_size;
+	entry->mtime_sec  = st->st_mtim.tv_sec;
+	entry->mtime_nsec = st->st_mtim.tv_nsec;
+}
+
+/*
+ * __cache_find
+ *
+ * Binary searches the loaded entries for the file in "key" (by device and
+ * inode only). Returns NULL if there isn't one. Entries added since loading
+ * aren't searched.
+ */
+
+ar_gameid_cache_entry_t *__cache_find(
+	GAMEID_CACHE             cache,
+	ar_gameid_cache_entry_t *key
+) {
+	if (cn_vec_size(cache->entries) == 0)
+		return NULL;
+
+	return (ar_gameid_cache_entry_t *) bsearch(
+		key,
+		cn_vec_data(cache->entries),
+		cn_vec_size(cache->entries),
+		sizeof(ar_gameid_cache_entry_t),
+		__cache_cmp
+	);
+}
+
+// ----------------------------------------------------------------------------
+// Game ID Cache Functions                                                 {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * gameid_cache_load
+ *
+ * Loads the cache at "path". If it doesn't exist, or isn't a valid cache,
+ * an empty one is returned instead. Never returns NULL. The entry count in
+ * the header is checked against the file size before anything is allocated,
+ * and entries that aren't in order are sorted, since lookups binary search
+ * them.
+ */
+
+GAMEID_CACHE gameid_cache_load(const char *path) {
+	GAMEID_CACHE             cache;
+	ar_gameid_cache_entry_t *data;
+	FILE                    *fp;
+	struct stat              st;
+	uint32_t                 header[4];
+	size_t                   i, num;
+
+	cache = (GAMEID_CACHE) malloc(sizeof(ar_gameid_cache_t));
+
+	cache->entries = cn_vec_init(ar_gameid_cache_entry_t);
+	cache->added   = cn_vec_init(ar_gameid_cache_entry_t);
+	cache->dirty   = 0;
+
+	fp = fopen(path, "rb");
+
+	if (fp == NULL)
+		return cache;
+
+	if (
+		fstat(fileno(fp), &st) == 0                  &&
+		fread(header, sizeof(uint32_t), 4, fp) == 4 &&
+		header[0] == GAMEID_CACHE_MAGIC             &&
+		header[1] == GAMEID_CACHE_VERSION           &&
+		header[2] <= (st.st_size - sizeof(header)) /
+		             sizeof(ar_gameid_cache_entry_t)
+	) {
+		num = header[2];
+		cn_vec_resize(cache->entries, num);
+
+		// A short read means it's truncated. Don't trust any of it.
+		if (
+			fread(
+				cn_vec_data(cache->entries),
+				sizeof(ar_gameid_cache_entry_t),
+				num,
+				fp
+			) != num
+		) {
+			cn_vec_clear(cache->entries);
+		}
+	}
+
+	fclose(fp);
+
+	// Lookups need it sorted. Only an edited cache wouldn't be.
+	data = (ar_gameid_cache_entry_t *) cn_vec_data(cache->entries);
+	num  = cn_vec_size(cache->entries);
+
+	for (i = 1; i < num; i++) {
+		if (__cache_cmp(&data[i - 1], &data[i]) > 0) {
+			qsort(data, num, sizeof(ar_gameid_cache_entry_t), __cache_cmp);
+			break;
+		}
+	}
+
+	return cache;
+}
+
+/*
+ * gameid_cache_lookup
+ *
+ * If the file described by "st" is in the cache, and hasn't changed size or
+ * modification time, copy its Game ID into "out_buffer" (at least 14 bytes)
+ * and its header flags into "flags", and return 1. Otherwise, return 0.
+ */
+
+int gameid_cache_lookup(
+	GAMEID_CACHE       cache,
+	const struct stat *st,
+	char              *out_buffer,
+	uint16_t          *flags
+) {
+	ar_gameid_cache_entry_t  key, *entry;
+
+	__cache_key(&key, st);
+	entry = __cache_find(cache, &key);
+
+	if (
+		entry == NULL                      ||
+		entry->size       != key.size      ||
+		entry->mtime_sec  != key.mtime_sec ||
+		entry->mtime_nsec != key.mtime_nsec
+	) {
+		return 0;
+	}
+
+	memcpy(out_buffer, entry->gameid, 14);
+	*flags = entry->flags;
+
+	return 1;
+}
+
+/*
+ * gameid_cache_store
+ *
+ * Records "gameid" and header "flags" for the file described by "st",
+ * replacing whatever was there for that file before.
+ */
+
+void gameid_cache_store(
+	GAMEID_CACHE       cache,
+	const struct stat *st,
+	const char        *gameid,
+	uint16_t           flags
+) {
+	ar_gameid_cache_entry_t  key, *entry;
+
+	__cache_key(&key, st);
+	strncpy(key.gameid, gameid, 13);
+	key.flags = flags;
+
+	entry = __cache_find(cache, &key);
+
+	if (entry != NULL) {
+		if (memcmp(entry, &key, sizeof(ar_gameid_cache_entry_t)) == 0)
+			return;
+
+		// File changed. Replace in place, which keeps the order intact.
+		memcpy(entry, &key, sizeof(ar_gameid_cache_entry_t));
+	}
+	else
+		cn_vec_push_back(cache->added, &key);
+
+	cache->dirty = 1;
+}
+
+/*
+ * gameid_cache_save
+ *
+ * Writes the cache to "path", if anything changed. It is written to a
+ * temporary file first and then renamed over "path", so a cache that is
+ * being read is never half-written.
+ *
+ * Returns 0 on success, or -1 if the cache couldn't be written.
+ */
+
+int gameid_cache_save(GAMEID_CACHE cache, const char *path) {
+	ar_gameid_cache_entry_t *data;
+	FILE                    *fp;
+	char                    *tmp;
+	uint32_t                 header[4];
+	size_t                   i, j, num;
+	int                      status;
+
+	if (!cache->dirty)
+		return 0;
+
+	// Merge in everything that was added, and sort it all again
+	for (i = 0; i < cn_vec_size(cache->added); i++)
+		cn_vec_push_back(cache->entries, cn_vec_at(cache->added, i));
+
+	cn_vec_clear(cache->added);
+
+	data = (ar_gameid_cache_entry_t *) cn_vec_data(cache->entries);
+	num  = cn_vec_size(cache->entries);
+
+	qsort(data, num, sizeof(ar_gameid_cache_entry_t), __cache_cmp);
+
+	// A file seen twice in one run was added twice. Keep one of each.
+	if (num > 1) {
+		for (i = 1, j = 0; i < num; i++) {
+			if (__cache_cmp(&data[j], &data[i]) != 0)
+				memcpy(&data[++j], &data[i], sizeof(ar_gameid_cache_entry_t));
+		}
+
+		num = j + 1;
+	}
+
+	cn_vec_resize(cache->entries, num);
+
+	header[0] = GAMEID_CACHE_MAGIC;
+	header[1] = GAMEID_CACHE_VERSION;
+	header[2] = num;
+	header[3] = 0;
+
+	// Write to "path.tmp" first
+	tmp = (char *) malloc(strlen(path) + 5);
+	sprintf(tmp, "%s.tmp", path);
+
+	fp = fopen(tmp, "wb");
+
+	if (fp == NULL) {
+		free(tmp);
+		return -1;
+	}
+
+	status = (
+		fwrite(header, sizeof(uint32_t), 4, fp) == 4 &&
+		fwrite(
+			cn_vec_data(cache->entries),
+			sizeof(ar_gameid_cache_entry_t),
+			num,
+			fp
+		) == num
+	) ? 0 : -1;
+
+	if (fclose(fp) != 0)
+		status = -1;
+
+	if (status == 0 && rename(tmp, path) != 0)
+		status = -1;
+
+	if (status != 0)
+		remove(tmp);
+	else
+		cache->dirty = 0;
+
+	free(tmp);
+	return status;
+}
+
+/*
+ * gameid_cache_free
+ *
+ * Frees the cache. Doesn't save it.
+ */
+
+void gameid_cache_free(GAMEID_CACHE cache) {
+	cn_vec_free(cache->entries);
+	cn_vec_free(cache->added);
+	free(cache);
+}
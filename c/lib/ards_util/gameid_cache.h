@@ -0,0 +1,85 @@
+/*
+ * ARDS Utils - Game ID Cache
+ *
+ * Description:
+ *     Provides an on-disk cache of Game IDs, keyed by the identity of the
+ *     file they came from: device, inode, size and modification time. If a
+ *     file's stat matches an entry, the Game ID (and what header validation
+ *     found) can be used without opening the file at all.
+ *
+ *     The cache file is a 16 byte header, followed by entries sorted by
+ *     device and inode:
+ *
+ *         u32 x 4   Magic ("ARGC"), version, number of entries, padding
+ *         entry x N ar_gameid_cache_entry_t, native byte order
+ *
+ *     It is only meant to be read back on the same machine. A cache that is
+ *     missing, or doesn't look right, is treated as empty.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_GAME_ID_CACHE__
+#define __ARDS_UTILS_GAME_ID_CACHE__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <sys/stat.h>
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Game ID Cache Data Structs                                              {{{1
+// ----------------------------------------------------------------------------
+
+#define GAMEID_CACHE_MAGIC   0x43475241 // "ARGC"
+#define GAMEID_CACHE_VERSION 2
+
+/*
+ * AR_GAMEID_CACHE_ENTRY_T
+ *
+ * A single file, its Game ID, and its NDS_HEADER_* flags. 56 bytes.
+ */
+
+typedef struct AR_GAMEID_CACHE_ENTRY_T {
+	uint64_t dev;        // st_dev
+	uint64_t ino;        // st_ino
+	uint64_t size;       // st_size
+	int64_t  mtime_sec;  // st_mtim.tv_sec
+	int64_t  mtime_nsec; // st_mtim.tv_nsec
+	char     gameid[14]; // XXXX-XXXXXXXX + NULL
+	uint16_t flags;      // From nds_header_validate
+} ar_gameid_cache_entry_t;
+
+/*
+ * AR_GAMEID_CACHE_T
+ *
+ * Entries loaded from disk are kept sorted in "entries" so they can be
+ * binary searched. Entries for files that weren't in it yet go in "added",
+ * and are merged in (and de-duplicated) when saved.
+ */
+
+typedef struct AR_GAMEID_CACHE_T {
+	CN_VEC  entries; // Sorted by (dev, ino)
+	CN_VEC  added;   // Unsorted, merged into "entries" on save
+	uint8_t dirty;   // Whether anything changed since loading
+} ar_gameid_cache_t, *GAMEID_CACHE;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+GAMEID_CACHE gameid_cache_load  (const char *);
+int          gameid_cache_lookup(GAMEID_CACHE, const struct stat *, char *,
+                                 uint16_t *);
+void         gameid_cache_store (GAMEID_CACHE, const struct stat *,
+                                 const char *, uint16_t);
+int          gameid_cache_save  (GAMEID_CACHE, const char *);
+void         gameid_cache_free  (GAMEID_CACHE);
+
+#endif
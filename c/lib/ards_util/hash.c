@@ -0,0 +1,47 @@
+/*
+ * hash.c
+ */
+
+#include "hash.h"
+
+/*
+ * ards_hash64
+ *
+ * Fast 64-bit hash of "len" bytes at "bytes". Four lanes are mixed
+ * separately so they don't wait on each other, then folded together at the
+ * end. Bytes past the last multiple of 32 go into the first lane.
+ */
+
+uint64_t ards_hash64(const uint8_t *bytes, size_t len) {
+	uint64_t lane[4], w, h;
+	size_t   i, j;
+
+	lane[0] = HASH_P1;
+	lane[1] = HASH_P2;
+	lane[2] = HASH_P1 ^ HASH_P2;
+	lane[3] = ~HASH_P1;
+
+	for (i = 0; i + 32 <= len; i += 32) {
+		for (j = 0; j < 4; j++) {
+			memcpy(&w, &bytes[i + j * 8], 8);
+
+			lane[j] = (lane[j] ^ w) * HASH_P1;
+			lane[j] = (lane[j] << 31) | (lane[j] >> 33);
+		}
+	}
+
+	for (; i < len; i++)
+		lane[0] = (lane[0] ^ bytes[i]) * HASH_P1;
+
+	// Fold the lanes, then avalanche
+	h = len;
+
+	for (j = 0; j < 4; j++)
+		h = (h ^ (lane[j] * HASH_P2)) * HASH_P1;
+
+	h ^= h >> 33;
+	h *= HASH_P2;
+	h ^= h >> 29;
+
+	return h;
+}
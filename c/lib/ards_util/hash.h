@@ -0,0 +1,31 @@
+/*
+ * ARDS Utils - Hash
+ *
+ * Description:
+ *     Provides a fast 64-bit hash for telling blocks of a dump apart. It is
+ *     not cryptographic. It is meant for catching bad reads and bit rot, not
+ *     someone tampering with a dump on purpose.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_HASH__
+#define __ARDS_UTILS_HASH__
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+// Multipliers for "ards_hash64"
+#define HASH_P1 0x9E3779B185EBCA87ULL
+#define HASH_P2 0xC2B2AE3D27D4EB4FULL
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+uint64_t ards_hash64(const uint8_t *, size_t);
+
+#endif
@@ -47,6 +47,28 @@ char *file_read_string(FILE *fp) {
 	return str;
 }
 
+// ----------------------------------------------------------------------------
+// File Writing Helpers                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * Inverse of the reading helpers above.
+ */
+
+/*
+ * file_write_string                                                       {{{2
+ *
+ * Writes "str" to "fp", including the null-terminator. A NULL "str" is written
+ * as an empty string.
+ */
+
+void file_write_string(FILE *fp, const char *str) {
+	if (str == NULL)
+		str = "";
+
+	fwrite(str, sizeof(char), strlen(str) + 1, fp);
+}
+
 // ----------------------------------------------------------------------------
 // Internal Functions                                                      {{{1
 // ----------------------------------------------------------------------------
@@ -70,6 +92,114 @@ void __tabs(FILE *out, size_t num) {
 		fprintf(out, "\t");
 }
 
+/*
+ * __json_string                                                           {{{2
+ *
+ * Writes "str" to "out" as a quoted JSON string. Quotes, backslashes and
+ * control characters are escaped, so the result never spans multiple lines.
+ * Bytes above 0x7F are written as-is, same as the XML export does.
+ */
+
+void __json_string(FILE *out, const char *str) {
+	const unsigned char *c;
+
+	fputc('"', out);
+
+	for (c = (const unsigned char *) str; *c != 0; c++) {
+		switch (*c) {
+			case '"' : fputs("\\\"", out); break;
+			case '\\': fputs("\\\\", out); break;
+			case '\n': fputs("\\n" , out); break;
+			case '\r': fputs("\\r" , out); break;
+			case '\t': fputs("\\t" , out); break;
+
+			default:
+				if (*c < 0x20)
+					fprintf(out, "\\u%04x", *c);
+				else
+					fputc(*c, out);
+
+				break;
+		}
+	}
+
+	fputc('"', out);
+}
+
+/*
+ * __json_break                                                            {{{2
+ *
+ * Starts a new line indented "depth" tabs deep. Does nothing if "compact" is
+ * set, which is how NDJSON output keeps each game on a single line.
+ */
+
+void __json_break(FILE *out, size_t depth, uint8_t compact) {
+	if (compact)
+		return;
+
+	fprintf(out, "\n");
+	__tabs(out, depth);
+}
+
+/*
+ * __columns_string                                                        {{{2
+ *
+ * Appends "str" to the string table of "cols" and returns its string ID.
+ */
+
+uint32_t __columns_string(ar_columns_t *cols, const char *str) {
+	file_write_type(cols->fp[AR_COL_STR_IDX], uint32_t, cols->strings_sz);
+	file_write_string(cols->fp[AR_COL_STR_DAT], str);
+
+	cols->strings_sz += strlen(str) + 1;
+
+	return cols->num_strings++;
+}
+
+/*
+ * __library_kept                                                          {{{2
+ *
+ * Whether "it" makes it into the byte format. Folders with nothing in them
+ * are dropped by "file_read_cheats_and_folders", along with their names, so
+ * they are never written. That includes folders with only those in them.
+ */
+
+uint8_t __library_kept(ar_data_t *it) {
+	ar_data_t *c;
+
+	if (it->data == NULL)
+		return 0;
+
+	if (((ar_flag_t) it->flag & 0x03) != AR_FLAG_FOLDER)
+		return 1;
+
+	cn_vec_traverse(it->data, c) {
+		if (__library_kept(c))
+			return 1;
+	}
+
+	return 0;
+}
+
+/*
+ * __library_num                                                           {{{2
+ *
+ * Returns how many entries of "root" are kept. This is what a folder's block
+ * says it has in it.
+ */
+
+uint16_t __library_num(CN_VEC root) {
+	ar_data_t *it;
+	uint16_t   num;
+
+	num = 0;
+
+	cn_vec_traverse(root, it)
+		num += __library_kept(it);
+
+	return num;
+}
+
 // ----------------------------------------------------------------------------
 // ARDS Read Functions                                                     {{{1
 // ----------------------------------------------------------------------------
@@ -212,6 +342,196 @@ void ards_game_read(ar_game_t *obj, FILE *fp, uint32_t offset) {
 	file_read_names(fp, obj->library);
 }
 
+// ----------------------------------------------------------------------------
+// ARDS Write Functions                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * Inverse of the read functions. These write out the byte format that the
+ * read functions above expect, in the same order they read it.
+ */
+
+/*
+ * file_write_cheats_and_folders                                           {{{2
+ *
+ * Writes the flag/count-prefixed blocks of every code and folder in "root".
+ * Folders are written recursively, and empty ones are left out (see
+ * "__library_kept"). The terminating block is not written here, since only
+ * the top level has one.
+ */
+
+void file_write_cheats_and_folders(FILE *fp, CN_VEC root) {
+	ar_data_t *it;
+	uint16_t   num;
+
+	cn_vec_traverse(root, it) {
+		if (!__library_kept(it))
+			continue;
+
+		num = (((ar_flag_t) it->flag & 0x03) == AR_FLAG_FOLDER)
+			? __library_num(it->data)
+			: cn_vec_size(it->data);
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				// Header, then (8 * num) bytes of lines in one go
+				file_write_type(fp, uint16_t, it->flag);
+				file_write_type(fp, uint16_t, num);
+				fwrite(cn_vec_data(it->data), sizeof(ar_line_t), num, fp);
+				break;
+
+			case AR_FLAG_FOLDER:
+				file_write_type(fp, uint16_t, it->flag);
+				file_write_type(fp, uint16_t, num);
+				file_write_cheats_and_folders(fp, it->data);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+}
+
+/*
+ * file_write_names                                                        {{{2
+ *
+ * Writes the name and description of every code and folder in "root", in the
+ * order "file_read_names" reads them back.
+ */
+
+void file_write_names(FILE *fp, CN_VEC root) {
+	ar_data_t *it;
+
+	cn_vec_traverse(root, it) {
+		if (!__library_kept(it))
+			continue;
+
+		file_write_string(fp, it->name);
+		file_write_string(fp, it->desc);
+
+		if (((ar_flag_t) it->flag & 0x03) == AR_FLAG_FOLDER)
+			file_write_names(fp, it->data);
+	}
+}
+
+/*
+ * library_count_codes                                                     {{{2
+ *
+ * Returns the number of codes in "root", including ones inside of folders.
+ * This is what goes into "num_codes" of the game header.
+ */
+
+uint16_t library_count_codes(CN_VEC root) {
+	ar_data_t *it;
+	uint16_t   num;
+
+	num = 0;
+
+	cn_vec_traverse(root, it) {
+		if (!__library_kept(it))
+			continue;
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				num++;
+				break;
+
+			case AR_FLAG_FOLDER:
+				num += library_count_codes(it->data);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+
+	return num;
+}
+
+/*
+ * library_size_codes                                                      {{{2
+ *
+ * Returns the number of bytes "file_write_cheats_and_folders" will write.
+ */
+
+size_t library_size_codes(CN_VEC root) {
+	ar_data_t *it;
+	size_t     sz;
+
+	sz = 0;
+
+	cn_vec_traverse(root, it) {
+		if (!__library_kept(it))
+			continue;
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				sz += 4 + sizeof(ar_line_t) * cn_vec_size(it->data);
+				break;
+
+			case AR_FLAG_FOLDER:
+				sz += 4 + library_size_codes(it->data);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+
+	return sz;
+}
+
+/*
+ * library_size_names                                                      {{{2
+ *
+ * Returns the number of bytes "file_write_names" will write.
+ */
+
+size_t library_size_names(CN_VEC root) {
+	ar_data_t *it;
+	size_t     sz;
+
+	sz = 0;
+
+	cn_vec_traverse(root, it) {
+		if (!__library_kept(it))
+			continue;
+
+		sz += strlen((it->name != NULL) ? it->name : "") + 1;
+		sz += strlen((it->desc != NULL) ? it->desc : "") + 1;
+
+		if (((ar_flag_t) it->flag & 0x03) == AR_FLAG_FOLDER)
+			sz += library_size_names(it->data);
+	}
+
+	return sz;
+}
+
+/*
+ * library_reverse                                                         {{{2
+ *
+ * Reverses the order of "root" (not recursive). Libraries are stored back to
+ * front compared to how they are shown (see the XML export). Formats that
+ * store them in the order they are shown use this to flip them around.
+ */
+
+void library_reverse(CN_VEC root) {
+	ar_data_t *arr, tmp;
+	size_t     i, n;
+
+	n   = cn_vec_size(root);
+	arr = cn_vec_array(root, ar_data_t);
+
+	for (i = 0; i < n / 2; i++) {
+		tmp            = arr[i];
+		arr[i]         = arr[n - 1 - i];
+		arr[n - 1 - i] = tmp;
+	}
+}
+
 // ----------------------------------------------------------------------------
 // ARDS Output Functions                                                   {{{1
 // ----------------------------------------------------------------------------
@@ -394,6 +714,424 @@ void ards_game_export_as_xml_rec(FILE *out, CN_VEC root, size_t depth) {
 	}
 }
 
+/*
+ * ards_game_export_as_json                                                {{{2
+ *
+ * Exports an array of ar_game_t objects as a single JSON document. Mirrors
+ * the layout of the XML export, with "items" holding folders and cheats.
+ */
+
+void ards_game_export_as_json(CN_VEC game_arr, FILE *out) {
+	ARDS_GAME *it;    // Iterator
+	size_t     i;     // Game counter
+
+	// JSON Begin
+	fprintf(out, "{\n");
+	fprintf(
+		out,
+		"\t\"name\": \"%s\",\n",
+		"Extracted via CN_ARDS - ards_game_to_json"
+	);
+	fprintf(out, "\t\"games\": [");
+
+	i = 0;
+	cn_vec_traverse(game_arr, it) {
+		fprintf(out, (i++ == 0) ? "\n\t\t" : ",\n\t\t");
+		ards_game_export_as_json_game(out, *it, 2, 0);
+	}
+
+	// Closing
+	fprintf(out, (i == 0) ? "]\n" : "\n\t]\n");
+	fprintf(out, "}\n");
+}
+
+/*
+ * ards_game_export_as_ndjson                                              {{{2
+ *
+ * Exports an array of ar_game_t objects as NDJSON. Every game is a complete
+ * JSON object on its own line, so the output can be split at any newline and
+ * each piece ingested separately.
+ */
+
+void ards_game_export_as_ndjson(CN_VEC game_arr, FILE *out) {
+	ARDS_GAME *it;
+
+	cn_vec_traverse(game_arr, it) {
+		ards_game_export_as_json_game(out, *it, 0, 1);
+		fprintf(out, "\n");
+	}
+}
+
+/*
+ * ards_game_export_as_json_game                                           {{{2
+ *
+ * Exports a single game as a JSON object, starting at the current position in
+ * "out". No trailing newline is written. If "compact" is set, the object is
+ * written on a single line.
+ */
+
+void ards_game_export_as_json_game(
+	FILE     *out,
+	ARDS_GAME game,
+	size_t    depth,
+	uint8_t   compact
+) {
+	// Game Header
+	fprintf(out, "{");
+
+	__json_break(out, depth + 1, compact);
+	fprintf(out, "\"name\": ");
+	__json_string(out, game->name);
+	fprintf(out, ",");
+
+	__json_break(out, depth + 1, compact);
+	fprintf(
+		out,
+		"\"gameid\": \"%.4s %08X\",",
+		game->header.ID,
+		game->header.N_CRC32
+	);
+
+	// Date, if possible
+	if (game->header.wDosDate != 0 && game->header.wDosTime != 0) {
+		__json_break(out, depth + 1, compact);
+		fprintf(
+			out,
+			"\"date\": \"%04d/%02d/%02d %02d:%02d\",",
+			(game->header.wDosDate >>  9) + 1980,
+			(game->header.wDosDate >>  5) & 0xF,
+			(game->header.wDosDate      ) & 0x1F,
+			(game->header.wDosTime >> 11),
+			(game->header.wDosTime >>  5) & 0x3F
+		);
+	}
+
+	// Recursion
+	__json_break(out, depth + 1, compact);
+	fprintf(out, "\"items\": ");
+	ards_game_export_as_json_rec(out, game->library, depth + 1, compact);
+
+	__json_break(out, depth, compact);
+	fprintf(out, "}");
+}
+
+/*
+ * ards_game_export_as_json_rec                                            {{{2
+ *
+ * Recursive helper to "ards_game_export_as_json_game". Goes through the
+ * code/folder tree in the same order as the XML export and writes it out as a
+ * JSON array.
+ */
+
+void ards_game_export_as_json_rec(
+	FILE   *out,
+	CN_VEC  root,
+	size_t  depth,
+	uint8_t compact
+) {
+	ar_data_t *it;
+	ar_line_t *lt;
+	ar_flag_t  flag;
+	size_t     n;
+
+	fprintf(out, "[");
+	n = 0;
+
+	cn_vec_rtraverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		flag = (ar_flag_t) it->flag;
+
+		if ((flag & 0x03) != AR_FLAG_CODE && (flag & 0x03) != AR_FLAG_FOLDER)
+			continue;
+
+		// Separator from the previous entry
+		if (n++ > 0)
+			fprintf(out, ",");
+
+		__json_break(out, depth + 1, compact);
+		fprintf(out, "{");
+
+		__json_break(out, depth + 2, compact);
+		fprintf(
+			out,
+			"\"type\": \"%s\",",
+			((flag & 0x03) == AR_FLAG_CODE) ? "cheat" : "folder"
+		);
+
+		__json_break(out, depth + 2, compact);
+		fprintf(out, "\"name\": ");
+		__json_string(out, it->name);
+		fprintf(out, ",");
+
+		// If there is a note, add that too
+		if (strlen(it->desc) > 0) {
+			__json_break(out, depth + 2, compact);
+			fprintf(out, "\"note\": ");
+			__json_string(out, it->desc);
+			fprintf(out, ",");
+		}
+
+		switch (flag & 0x03) {
+			case AR_FLAG_CODE:
+				// Same flags the XML export puts in front of the code hex
+				if (flag & AR_FLAG_MASTER) {
+					__json_break(out, depth + 2, compact);
+					fprintf(out, "\"master\": true,");
+				}
+
+				if (flag & AR_FLAG_ON_DEFAULT) {
+					__json_break(out, depth + 2, compact);
+					fprintf(
+						out,
+						"\"%s\": true,",
+						(flag & AR_FLAG_ON_ALWAYS) ? "always_on" : "on"
+					);
+				}
+
+				// Print out all lines of the AR code
+				__json_break(out, depth + 2, compact);
+				fprintf(out, "\"codes\": [");
+
+				cn_vec_traverse(it->data, lt) {
+					fprintf(
+						out,
+						"%s\"%08X %08X\"",
+						(lt == cn_vec_data(it->data)) ? "" : ", ",
+						lt->memory_location,
+						lt->value
+					);
+				}
+
+				fprintf(out, "]");
+				break;
+
+			case AR_FLAG_FOLDER:
+				// Radio Button Folder (only 1 code allowed on at once)
+				if (flag & AR_FLAG_ONLYONE) {
+					__json_break(out, depth + 2, compact);
+					fprintf(out, "\"allowedon\": 1,");
+				}
+
+				// AR Folders are recursive
+				__json_break(out, depth + 2, compact);
+				fprintf(out, "\"items\": ");
+				ards_game_export_as_json_rec(
+					out,
+					it->data,
+					depth + 2,
+					compact
+				);
+
+				break;
+		}
+
+		__json_break(out, depth + 1, compact);
+		fprintf(out, "}");
+	}
+
+	if (n > 0)
+		__json_break(out, depth, compact);
+
+	fprintf(out, "]");
+}
+
+/*
+ * ards_game_export_as_columns                                             {{{2
+ *
+ * Exports every code line of every game in "game_arr" as flat column files in
+ * directory "dir". Row N of each column describes the same line:
+ *
+ *     game.u32     Index of the game in "game_arr"
+ *     cheat.u32    Index of the cheat within its game (XML export order)
+ *     folder.u32   String ID of the folder path the cheat is in
+ *     address.u32  Left side of the AR code
+ *     value.u32    Right side of the AR code
+ *     flag.u16     Flags of the cheat the line belongs to
+ *
+ * Folder paths are "XXXX-XXXXXXXX" for codes at the top of a game, and
+ * "XXXX-XXXXXXXX/Folder Name" for codes inside a folder. They are stored
+ * null-terminated back-to-back in "strings.dat", with the byte offset of each
+ * string ID in "strings.idx" (u32).
+ *
+ * Columns are fixed-width little-endian, written straight from memory like
+ * the rest of the ARDS byte format is read. Returns 0 on success, or 1 if any
+ * file in "dir" couldn't be opened.
+ */
+
+int ards_game_export_as_columns(CN_VEC game_arr, const char *dir) {
+	static const char *names[AR_COL_COUNT] = {
+		"game.u32", "cheat.u32", "folder.u32", "address.u32", "value.u32",
+		"flag.u16", "strings.dat", "strings.idx"
+	};
+
+	ar_columns_t cols;
+	ARDS_GAME   *it;
+	char        *path;
+	uint32_t     game_i, folder_id;
+	size_t       i;
+	int          status;
+
+	status = 0;
+	path   = (char *) malloc(strlen(dir) + 16);
+
+	// Open all of the column files
+	for (i = 0; i < AR_COL_COUNT; i++) {
+		sprintf(path, "%s/%s", dir, names[i]);
+		cols.fp[i] = fopen(path, "wb");
+
+		if (!cols.fp[i])
+			status = 1;
+	}
+
+	free(path);
+
+	if (status == 0) {
+		cols.num_strings = 0;
+		cols.strings_sz  = 0;
+
+		game_i = 0;
+		cn_vec_traverse(game_arr, it) {
+			// Top level of the game gets a path of just the Game ID
+			path = (char *) calloc(14, sizeof(char));
+			sprintf(
+				path, "%.4s-%08X", (*it)->header.ID, (*it)->header.N_CRC32
+			);
+
+			folder_id  = __columns_string(&cols, path);
+			cols.cheat = 0;
+
+			ards_game_export_as_columns_rec(
+				&cols, (*it)->library, game_i, folder_id, path
+			);
+
+			free(path);
+			game_i++;
+		}
+	}
+
+	// Clean up
+	for (i = 0; i < AR_COL_COUNT; i++)
+		if (cols.fp[i])
+			fclose(cols.fp[i]);
+
+	return status;
+}
+
+/*
+ * ards_game_export_as_columns_rec                                         {{{2
+ *
+ * Recursive helper to "ards_game_export_as_columns". Writes a row for every
+ * line of every code in "root". "path" is the folder path of "root", which
+ * already has the string ID "folder_id".
+ */
+
+void ards_game_export_as_columns_rec(
+	ar_columns_t *cols,
+	CN_VEC        root,
+	uint32_t      game_i,
+	uint32_t      folder_id,
+	const char   *path
+) {
+	ar_data_t *it;
+	ar_line_t *lt;
+	char      *sub_path;
+	FILE     **fp;
+
+	fp = cols->fp;
+
+	cn_vec_rtraverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				cn_vec_traverse(it->data, lt) {
+					file_write_type(fp[AR_COL_GAME   ], uint32_t, game_i     );
+					file_write_type(fp[AR_COL_CHEAT  ], uint32_t, cols->cheat);
+					file_write_type(fp[AR_COL_FOLDER ], uint32_t, folder_id  );
+					file_write_type(
+						fp[AR_COL_ADDRESS], uint32_t, lt->memory_location
+					);
+					file_write_type(fp[AR_COL_VALUE  ], uint32_t, lt->value  );
+					file_write_type(fp[AR_COL_FLAG   ], uint16_t, it->flag   );
+				}
+
+				cols->cheat++;
+				break;
+
+			case AR_FLAG_FOLDER:
+				// AR Folders are recursive. Give this one its own path
+				sub_path = (char *) malloc(strlen(path) + strlen(it->name) + 2);
+				sprintf(sub_path, "%s/%s", path, it->name);
+
+				ards_game_export_as_columns_rec(
+					cols,
+					it->data,
+					game_i,
+					__columns_string(cols, sub_path),
+					sub_path
+				);
+
+				free(sub_path);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+}
+
+/*
+ * ards_game_export_as_binary                                              {{{2
+ *
+ * Exports a single ar_game_t object in the same byte format that
+ * "ards_game_read" reads. That is, the 32-byte ar_game_info_t, the code and
+ * folder blocks followed by a terminating block, and then the text section.
+ *
+ * The text section is prefixed by a 32-bit length at "offset_strlen", which
+ * sits directly after the code blocks. Text itself starts at
+ * "offset_text + 1". Both offsets, as well as "num_codes", are recomputed from
+ * the library. Every other header field is written back as it was read.
+ *
+ * Nothing is padded. Returns the number of bytes written.
+ */
+
+size_t ards_game_export_as_binary(ARDS_GAME game, FILE *out) {
+	ar_game_info_t header;
+	uint32_t       text_sz, zero;
+	size_t         code_sz;
+
+	// Size up the code blocks (plus 4 byte terminator) and the text section
+	code_sz = library_size_codes(game->library) + 4;
+	text_sz = library_size_names(game->library)
+		+ strlen((game->name != NULL) ? game->name : "") + 1
+		+ strlen((game->desc != NULL) ? game->desc : "") + 1;
+
+	// Fix up the header
+	header               = game->header;
+	header.num_codes     = library_count_codes(game->library);
+	header.offset_strlen = sizeof(ar_game_info_t) + code_sz;
+	header.offset_text   = header.offset_strlen + sizeof(uint32_t) - 1;
+
+	fwrite(&header, sizeof(ar_game_info_t), 1, out);
+
+	// Code blocks, then the terminator
+	file_write_cheats_and_folders(out, game->library);
+	zero = 0;
+	file_write_type(out, uint32_t, zero);
+
+	// Text section. Game information is first
+	file_write_type(out, uint32_t, text_sz);
+	file_write_string(out, game->name);
+	file_write_string(out, game->desc);
+	file_write_names(out, game->library);
+
+	return header.offset_strlen + sizeof(uint32_t) + text_sz;
+}
+
 // ----------------------------------------------------------------------------
 // Cleanup Functions                                                       {{{1
 // ----------------------------------------------------------------------------
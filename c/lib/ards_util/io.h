@@ -151,6 +151,32 @@ typedef struct AR_GAME_T {
 	uint32_t       offset;  // Offset of game location in ROM memory
 } ar_game_t, *ARDS_GAME;
 
+/*
+ * AR_COLUMNS_T
+ *
+ * State for exporting code lines as column files. Each file in "fp" is one
+ * column (or the string table), indexed by AR_COL_*.
+ */
+
+typedef enum AR_COL_T {
+	AR_COL_GAME    = 0,
+	AR_COL_CHEAT   = 1,
+	AR_COL_FOLDER  = 2,
+	AR_COL_ADDRESS = 3,
+	AR_COL_VALUE   = 4,
+	AR_COL_FLAG    = 5,
+	AR_COL_STR_DAT = 6,
+	AR_COL_STR_IDX = 7,
+	AR_COL_COUNT   = 8
+} ar_col_t;
+
+typedef struct AR_COLUMNS_T {
+	FILE     *fp[AR_COL_COUNT]; // Column files
+	uint32_t  cheat;            // Cheat index within the current game
+	uint32_t  num_strings;      // Strings in the string table so far
+	uint32_t  strings_sz;       // Bytes written to "strings.dat" so far
+} ar_columns_t;
+
 // ----------------------------------------------------------------------------
 // File Reading Helpers                                                    {{{1
 // ----------------------------------------------------------------------------
@@ -166,6 +192,20 @@ typedef struct AR_GAME_T {
 
 char *file_read_string(FILE *);
 
+// ----------------------------------------------------------------------------
+// File Writing Helpers                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * Inverse of the reading helpers above.
+ */
+
+// Write data as specific type
+#define file_write_type(fp, type, var) \
+	fwrite(&var, sizeof(type), 1, fp)
+
+void file_write_string(FILE *, const char *);
+
 // ----------------------------------------------------------------------------
 // Internal Functions                                                      {{{1
 // ----------------------------------------------------------------------------
@@ -176,6 +216,13 @@ char *file_read_string(FILE *);
  */
 
 void __tabs(FILE *, size_t);
+void __json_string(FILE *, const char *);
+void __json_break (FILE *, size_t, uint8_t);
+
+uint32_t __columns_string(ar_columns_t *, const char *);
+
+uint8_t  __library_kept(ar_data_t *);
+uint16_t __library_num (CN_VEC);
 
 // ----------------------------------------------------------------------------
 // ARDS Read Functions                                                     {{{1
@@ -187,6 +234,23 @@ void file_read_names(FILE *, CN_VEC);
 ARDS_GAME ards_game_init();
 void ards_game_read(ARDS_GAME, FILE *, uint32_t);
 
+// ----------------------------------------------------------------------------
+// ARDS Write Functions                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * Inverse of the read functions. These write out the byte format that the
+ * read functions above expect, in the same order they read it.
+ */
+
+void file_write_cheats_and_folders(FILE *, CN_VEC);
+void file_write_names(FILE *, CN_VEC);
+
+uint16_t library_count_codes(CN_VEC);
+size_t   library_size_codes (CN_VEC);
+size_t   library_size_names (CN_VEC);
+void     library_reverse    (CN_VEC);
+
 // ----------------------------------------------------------------------------
 // ARDS Output Functions                                                   {{{1
 // ----------------------------------------------------------------------------
@@ -200,6 +264,21 @@ void ards_game_read(ARDS_GAME, FILE *, uint32_t);
 void ards_game_export_as_xml    (CN_VEC, FILE *);
 void ards_game_export_as_xml_rec(FILE *, CN_VEC, size_t);
 
+// JSON Export Functionality (NDJSON = one game per line, no pretty printing)
+void ards_game_export_as_json     (CN_VEC, FILE *);
+void ards_game_export_as_ndjson   (CN_VEC, FILE *);
+void ards_game_export_as_json_game(FILE *, ARDS_GAME, size_t, uint8_t);
+void ards_game_export_as_json_rec (FILE *, CN_VEC, size_t, uint8_t);
+
+// Columnar Export Functionality
+int  ards_game_export_as_columns    (CN_VEC, const char *);
+void ards_game_export_as_columns_rec(
+	ar_columns_t *, CN_VEC, uint32_t, uint32_t, const char *
+);
+
+// ARDS Byte Format Export Functionality (single game)
+size_t ards_game_export_as_binary(ARDS_GAME, FILE *);
+
 // ----------------------------------------------------------------------------
 // Cleanup Functions                                                       {{{1
 // ----------------------------------------------------------------------------
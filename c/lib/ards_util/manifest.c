@@ -0,0 +1,536 @@
+/*
+ * ARDS Utils - Manifest
+ *
+ * Description:
+ *     Provides integrity manifests for dumps. See "manifest.h" for how they
+ *     are laid out.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include "manifest.h"
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __manifest_levels
+ *
+ * Works out where each level of a tree over "leaves" leaves starts ("off"),
+ * and how many nodes are in it ("size"). Level 0 is the leaves. Returns the
+ * number of levels. The last one is just the root.
+ */
+
+size_t __manifest_levels(uint32_t leaves, uint32_t *off, uint32_t *size) {
+	size_t   num;
+	uint32_t n, o;
+
+	for (num = 0, n = leaves, o = 0; ; num++) {
+		off[num]  = o;
+		size[num] = n;
+		o        += n;
+
+		if (n <= 1)
+			break;
+
+		n = (n + 1) / 2;
+	}
+
+	return num + 1;
+}
+
+/*
+ * __manifest_nodes
+ *
+ * Number of nodes in a tree over "leaves" leaves.
+ */
+
+uint32_t __manifest_nodes(uint32_t leaves) {
+	uint32_t off[MANIFEST_MAX_LEVELS], size[MANIFEST_MAX_LEVELS];
+	size_t   num;
+
+	num = __manifest_levels(leaves, off, size);
+
+	return off[num - 1] + 1;
+}
+
+/*
+ * __manifest_build
+ *
+ * Fills in every level of the tree in "nodes" above its "leaves" leaves. If
+ * "check" is set, nothing is written, and the nodes that are already there
+ * are checked instead. Returns how many of them were wrong.
+ */
+
+int __manifest_build(uint64_t *nodes, uint32_t leaves, int check) {
+	uint32_t off[MANIFEST_MAX_LEVELS], size[MANIFEST_MAX_LEVELS];
+	uint64_t pair[2], h;
+	size_t   num, l;
+	uint32_t i;
+	int      wrong;
+
+	num = __manifest_levels(leaves, off, size);
+
+	for (l = 1, wrong = 0; l < num; l++) {
+		for (i = 0; i < size[l]; i++) {
+			pair[0] = nodes[off[l - 1] + 2 * i];
+
+			// A node without a partner is carried up as it is
+			if (2 * i + 1 < size[l - 1]) {
+				pair[1] = nodes[off[l - 1] + 2 * i + 1];
+				h       = ards_hash64((const uint8_t *) pair, sizeof(pair));
+			}
+			else {
+				h = pair[0];
+			}
+
+			if (!check)
+				nodes[off[l] + i] = h;
+			else
+			if (nodes[off[l] + i] != h)
+				wrong++;
+		}
+	}
+
+	return wrong;
+}
+
+/*
+ * __manifest_descend
+ *
+ * Compares node "i" of level "l" in trees "a" and "b", which are laid out by
+ * "off" and "size". If they differ, so do the nodes under it. Follows them
+ * down, and pushes every leaf that differs onto "out" (a CN_VEC of
+ * uint32_t), in order.
+ */
+
+void __manifest_descend(
+	const uint64_t *a,
+	const uint64_t *b,
+	uint32_t       *off,
+	uint32_t       *size,
+	size_t          l,
+	uint32_t        i,
+	CN_VEC          out
+) {
+	if (a[off[l] + i] == b[off[l] + i])
+		return;
+
+	if (l == 0) {
+		cn_vec_push_back(out, &i);
+		return;
+	}
+
+	__manifest_descend(a, b, off, size, l - 1, 2 * i, out);
+
+	if (2 * i + 1 < size[l - 1])
+		__manifest_descend(a, b, off, size, l - 1, 2 * i + 1, out);
+}
+
+/*
+ * __manifest_worker
+ *
+ * Hashes every page in a part. Pages of the same bank are read in
+ * MANIFEST_READ_PAGES at a time.
+ */
+
+void *__manifest_worker(void *arg) {
+	ar_manifest_part_t   *part;
+	ar_manifest_header_t *h;
+	uint8_t              *buffer;
+	uint64_t              g, b, p, count, off, bytes, len;
+	ssize_t               got;
+	size_t                k, done, buffer_sz;
+
+	part = (ar_manifest_part_t *) arg;
+	h    = &part->manifest->header;
+
+	// Never more than the rest of a bank is read at once
+	buffer_sz = (size_t) MANIFEST_READ_PAGES * h->page_sz;
+
+	if (buffer_sz > h->bank_sz)
+		buffer_sz = h->bank_sz;
+
+	buffer = (uint8_t *) malloc(buffer_sz);
+
+	for (g = part->start; g < part->end; g += count) {
+		b     = g / h->pages;
+		p     = g % h->pages;
+		count = h->pages - p;
+
+		if (count > MANIFEST_READ_PAGES)
+			count = MANIFEST_READ_PAGES;
+
+		if (count > part->end - g)
+			count = part->end - g;
+
+		off   = p * h->page_sz;
+		bytes = count * h->page_sz;
+
+		if (bytes > h->bank_sz - off)
+			bytes = h->bank_sz - off;
+
+		// pread can come back short. Keep going until it's all there.
+		for (done = 0; done < bytes; done += got) {
+			got = pread(
+				part->fd,
+				buffer + done,
+				bytes - done,
+				b * h->bank_sz + off + done
+			);
+
+			if (got <= 0)
+				break;
+		}
+
+		if (done < bytes) {
+			part->status = AR_MANIFEST_READ;
+			break;
+		}
+
+		for (k = 0; k < count; k++) {
+			len = bytes - k * h->page_sz;
+
+			if (len > h->page_sz)
+				len = h->page_sz;
+
+			part->manifest->tree[b * h->nodes + p + k] = ards_hash64(
+				buffer + k * h->page_sz, len
+			);
+		}
+	}
+
+	free(buffer);
+	return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Manifest Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * manifest_init
+ *
+ * Sets up an empty manifest for "banks" banks of "bank_sz" bytes each, split
+ * into pages of "page_sz" bytes.
+ */
+
+void manifest_init(
+	ar_manifest_t *manifest,
+	uint64_t       bank_sz,
+	uint32_t       banks,
+	uint32_t       page_sz
+) {
+	ar_manifest_header_t *h;
+
+	h = &manifest->header;
+
+	memset(h, 0, sizeof(ar_manifest_header_t));
+	memcpy(h->magic, MANIFEST_MAGIC, 4);
+
+	h->version   = MANIFEST_VERSION;
+	h->page_sz   = page_sz;
+	h->banks     = banks;
+	h->bank_sz   = bank_sz;
+	h->pages     = (bank_sz + page_sz - 1) / page_sz;
+	h->nodes     = __manifest_nodes(h->pages);
+	h->top_nodes = __manifest_nodes(banks);
+
+	manifest->tree = (uint64_t *) calloc(
+		(size_t) banks * h->nodes, sizeof(uint64_t)
+	);
+
+	manifest->top = (uint64_t *) calloc(h->top_nodes, sizeof(uint64_t));
+}
+
+/*
+ * manifest_hash_fd
+ *
+ * Hashes every page of the dump open as "fd" on "threads" threads (0 means
+ * one per online CPU), then builds the trees over them. Each page is read
+ * once. Returns AR_MANIFEST_OK, or AR_MANIFEST_READ if the dump ended early
+ * or couldn't be read.
+ */
+
+int manifest_hash_fd(ar_manifest_t *manifest, int fd, size_t threads) {
+	ar_manifest_part_t *parts;
+	pthread_t          *tids;
+	uint64_t            total;
+	size_t              num, i;
+	int                 status;
+
+	total = (uint64_t) manifest->header.banks * manifest->header.pages;
+
+	if (threads == 0)
+		threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	// Not worth a thread for less than a single read
+	num = total / MANIFEST_READ_PAGES;
+
+	if (num > threads)
+		num = threads;
+
+	if (num == 0)
+		num = 1;
+
+	parts = (ar_manifest_part_t *) calloc(num, sizeof(ar_manifest_part_t));
+	tids  = (pthread_t *) malloc(num * sizeof(pthread_t));
+
+	for (i = 0; i < num; i++) {
+		parts[i].manifest = manifest;
+		parts[i].fd       = fd;
+		parts[i].start    = total * i / num;
+		parts[i].end      = total * (i + 1) / num;
+		parts[i].status   = AR_MANIFEST_OK;
+	}
+
+	if (num == 1) {
+		__manifest_worker(&parts[0]);
+	}
+	else {
+		for (i = 0; i < num; i++)
+			pthread_create(&tids[i], NULL, __manifest_worker, &parts[i]);
+
+		for (i = 0; i < num; i++)
+			pthread_join(tids[i], NULL);
+	}
+
+	for (i = 0, status = AR_MANIFEST_OK; i < num; i++)
+		if (parts[i].status != AR_MANIFEST_OK)
+			status = parts[i].status;
+
+	free(parts);
+	free(tids);
+
+	if (status == AR_MANIFEST_OK)
+		manifest_build(manifest);
+
+	return status;
+}
+
+/*
+ * manifest_build
+ *
+ * Builds every bank's tree over its page hashes, then the tree over the
+ * banks' roots.
+ */
+
+void manifest_build(ar_manifest_t *manifest) {
+	ar_manifest_header_t *h;
+	uint32_t              b;
+
+	h = &manifest->header;
+
+	for (b = 0; b < h->banks; b++) {
+		__manifest_build(&manifest->tree[b * h->nodes], h->pages, 0);
+		manifest->top[b] = manifest->tree[b * h->nodes + h->nodes - 1];
+	}
+
+	__manifest_build(manifest->top, h->banks, 0);
+}
+
+/*
+ * manifest_write
+ *
+ * Writes "manifest" out to "fp". Returns AR_MANIFEST_OK, or
+ * AR_MANIFEST_WRITE.
+ */
+
+int manifest_write(FILE *fp, ar_manifest_t *manifest) {
+	ar_manifest_header_t *h;
+	size_t                nodes;
+
+	h     = &manifest->header;
+	nodes = (size_t) h->banks * h->nodes;
+
+	if (
+		fwrite(h, sizeof(ar_manifest_header_t), 1, fp) != 1 ||
+		fwrite(manifest->tree, sizeof(uint64_t), nodes, fp) != nodes ||
+		fwrite(manifest->top, sizeof(uint64_t), h->top_nodes, fp) !=
+			h->top_nodes
+	) {
+		return AR_MANIFEST_WRITE;
+	}
+
+	return AR_MANIFEST_OK;
+}
+
+/*
+ * manifest_read
+ *
+ * Reads a manifest from "fp", and checks that every tree in it adds up, so a
+ * damaged manifest isn't mistaken for a damaged dump. On anything but
+ * AR_MANIFEST_OK, there is nothing to free.
+ */
+
+int manifest_read(FILE *fp, ar_manifest_t *manifest) {
+	ar_manifest_header_t  h;
+	uint32_t              b;
+	size_t                nodes;
+	int                   status;
+
+	if (fread(&h, sizeof(ar_manifest_header_t), 1, fp) != 1)
+		return AR_MANIFEST_BAD_HEADER;
+
+	if (
+		memcmp(h.magic, MANIFEST_MAGIC, 4) != 0 ||
+		h.version != MANIFEST_VERSION
+	) {
+		return AR_MANIFEST_BAD_HEADER;
+	}
+
+	// The geometry has to agree with itself before anything is allocated
+	if (
+		h.page_sz == 0 || h.banks == 0 || h.bank_sz == 0 ||
+		h.page_sz > MANIFEST_MAX_PAGE_SZ || h.page_sz > h.bank_sz ||
+		h.pages != (h.bank_sz + h.page_sz - 1) / h.page_sz ||
+		h.nodes != __manifest_nodes(h.pages) ||
+		h.top_nodes != __manifest_nodes(h.banks)
+	) {
+		return AR_MANIFEST_CORRUPT;
+	}
+
+	manifest_init(manifest, h.bank_sz, h.banks, h.page_sz);
+
+	nodes  = (size_t) h.banks * h.nodes;
+	status = AR_MANIFEST_OK;
+
+	if (
+		manifest->tree == NULL || manifest->top == NULL ||
+		fread(manifest->tree, sizeof(uint64_t), nodes, fp) != nodes ||
+		fread(manifest->top, sizeof(uint64_t), h.top_nodes, fp) !=
+			h.top_nodes
+	) {
+		status = AR_MANIFEST_CORRUPT;
+	}
+
+	// Every tree has to add up, and the banks' roots have to be the leaves
+	for (b = 0; b < h.banks && status == AR_MANIFEST_OK; b++) {
+		if (
+			__manifest_build(&manifest->tree[b * h.nodes], h.pages, 1) != 0 ||
+			manifest->top[b] != manifest->tree[b * h.nodes + h.nodes - 1]
+		) {
+			status = AR_MANIFEST_CORRUPT;
+		}
+	}
+
+	if (
+		status == AR_MANIFEST_OK &&
+		__manifest_build(manifest->top, h.banks, 1) != 0
+	) {
+		status = AR_MANIFEST_CORRUPT;
+	}
+
+	if (status != AR_MANIFEST_OK)
+		manifest_free(manifest);
+
+	return status;
+}
+
+/*
+ * manifest_diff
+ *
+ * Compares manifests "a" and "b" from the top down, and pushes every page
+ * that differs onto "out" (a CN_VEC of uint32_t), counting across banks.
+ * Returns AR_MANIFEST_OK, or AR_MANIFEST_GEOMETRY if they can't be compared.
+ */
+
+int manifest_diff(ar_manifest_t *a, ar_manifest_t *b, CN_VEC out) {
+	uint32_t  off[MANIFEST_MAX_LEVELS], size[MANIFEST_MAX_LEVELS];
+	uint32_t *bank, *page;
+	size_t    num, i;
+	CN_VEC    banks;
+
+	if (
+		a->header.page_sz != b->header.page_sz ||
+		a->header.banks   != b->header.banks   ||
+		a->header.bank_sz != b->header.bank_sz
+	) {
+		return AR_MANIFEST_GEOMETRY;
+	}
+
+	// Banks first
+	banks = cn_vec_init(uint32_t);
+	num   = __manifest_levels(a->header.banks, off, size);
+
+	__manifest_descend(a->top, b->top, off, size, num - 1, 0, banks);
+
+	// Then the pages of every bank that differs
+	num = __manifest_levels(a->header.pages, off, size);
+
+	cn_vec_traverse(banks, bank) {
+		i = cn_vec_size(out);
+
+		__manifest_descend(
+			&a->tree[*bank * a->header.nodes],
+			&b->tree[*bank * a->header.nodes],
+			off,
+			size,
+			num - 1,
+			0,
+			out
+		);
+
+		// Pages are numbered across banks
+		for (; i < cn_vec_size(out); i++) {
+			page  = (uint32_t *) cn_vec_at(out, i);
+			*page += *bank * a->header.pages;
+		}
+	}
+
+	cn_vec_free(banks);
+
+	return AR_MANIFEST_OK;
+}
+
+/*
+ * manifest_root
+ *
+ * The hash that stands for the whole dump.
+ */
+
+uint64_t manifest_root(ar_manifest_t *manifest) {
+	return manifest->top[manifest->header.top_nodes - 1];
+}
+
+/*
+ * manifest_free
+ */
+
+void manifest_free(ar_manifest_t *manifest) {
+	free(manifest->tree);
+	free(manifest->top);
+
+	manifest->tree = NULL;
+	manifest->top  = NULL;
+}
+
+/*
+ * manifest_strerror
+ */
+
+const char *manifest_strerror(int status) {
+	switch (status) {
+		case AR_MANIFEST_OK:
+			return "Success";
+
+		case AR_MANIFEST_BAD_HEADER:
+			return "Not a manifest file";
+
+		case AR_MANIFEST_CORRUPT:
+			return "Manifest is corrupt";
+
+		case AR_MANIFEST_READ:
+			return "Failed to read the dump";
+
+		case AR_MANIFEST_WRITE:
+			return "Failed to write the manifest";
+
+		case AR_MANIFEST_GEOMETRY:
+			return "Manifests split their dumps into different banks or pages";
+	}
+
+	return "Unknown error";
+}
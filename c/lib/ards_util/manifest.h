@@ -0,0 +1,139 @@
+/*
+ * ARDS Utils - Manifest
+ *
+ * Description:
+ *     Provides integrity manifests for dumps. A dump is split into banks, and
+ *     each bank into pages (4 KiB by default). Every page is hashed with
+ *     "ards_hash64", and the page hashes of each bank are the leaves of a
+ *     Merkle tree. The roots of those trees are then the leaves of one more
+ *     tree over the banks, whose root stands for the whole dump.
+ *
+ *     Each level of a tree is half the size of the one below it. A node's
+ *     hash is "ards_hash64" of its two children's hashes. A node left
+ *     without a partner at the end of a level is carried up as it is.
+ *
+ *     Two manifests of the same geometry are compared from the top down. Only
+ *     the children of nodes that differ are looked at, so a few bad pages are
+ *     found in logarithmic time, without going near the dumps.
+ *
+ *     Written to disk, a manifest is a 40 byte header, followed by the nodes
+ *     of every bank's tree (bank 0 first), then the nodes of the tree over
+ *     the banks. Each tree is stored a level at a time, starting with its
+ *     leaves and ending with its root. Every hash is a little-endian uint64.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_MANIFEST__
+#define __ARDS_UTILS_MANIFEST__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// ARDS Utils
+#include "hash.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Manifest Data Structs                                                   {{{1
+// ----------------------------------------------------------------------------
+
+#define MANIFEST_MAGIC       "ARDM"
+#define MANIFEST_VERSION     1
+#define MANIFEST_PAGE_SZ     0x1000
+#define MANIFEST_MAX_PAGE_SZ 0x100000 // Largest page, and never past a bank
+#define MANIFEST_MAX_LEVELS  33
+#define MANIFEST_READ_PAGES  64       // Pages a thread reads in at once
+
+/*
+ * AR_MANIFEST_HEADER_T
+ *
+ * First 40 bytes of a manifest file.
+ */
+
+typedef struct AR_MANIFEST_HEADER_T {
+	                    // Bytes    Description
+	                    // ---      ---
+	char     magic[4];  // 00 - 03. "ARDM"
+	uint32_t version;   // 04 - 07. MANIFEST_VERSION
+	uint32_t page_sz;   // 08 - 11. Bytes in a page
+	uint32_t banks;     // 12 - 15. Number of banks
+	uint64_t bank_sz;   // 16 - 23. Bytes in a bank
+	uint32_t pages;     // 24 - 27. Pages in each bank. The last can be short.
+	uint32_t nodes;     // 28 - 31. Nodes in each bank's tree
+	uint32_t top_nodes; // 32 - 35. Nodes in the tree over the banks
+	uint32_t pad;       // 36 - 39. Always 0
+} ar_manifest_header_t;
+
+/*
+ * AR_MANIFEST_T
+ *
+ * A manifest in memory. "tree" holds "banks" trees of "nodes" hashes each,
+ * back to back.
+ */
+
+typedef struct AR_MANIFEST_T {
+	ar_manifest_header_t  header;
+	uint64_t             *tree; // Every bank's tree
+	uint64_t             *top;  // Tree over the banks
+} ar_manifest_t;
+
+/*
+ * AR_MANIFEST_PART_T
+ *
+ * A single thread's share of the pages in "manifest_hash_fd".
+ */
+
+typedef struct AR_MANIFEST_PART_T {
+	ar_manifest_t *manifest;
+	int            fd;
+	uint64_t       start;  // First page, counting across banks
+	uint64_t       end;    // Page after the last
+	int            status; // AR_MANIFEST_OK, or AR_MANIFEST_READ
+} ar_manifest_part_t;
+
+/*
+ * AR_MANIFEST_STATUS_T
+ */
+
+typedef enum AR_MANIFEST_STATUS_T {
+	AR_MANIFEST_OK = 0,
+	AR_MANIFEST_BAD_HEADER, // Not a manifest
+	AR_MANIFEST_CORRUPT,    // Trees don't add up, or file ended early
+	AR_MANIFEST_READ,       // Couldn't read the dump or the manifest
+	AR_MANIFEST_WRITE,      // Couldn't write the manifest
+	AR_MANIFEST_GEOMETRY    // Manifests split their dumps differently
+} ar_manifest_status_t;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+size_t    __manifest_levels (uint32_t, uint32_t *, uint32_t *);
+uint32_t  __manifest_nodes  (uint32_t);
+int       __manifest_build  (uint64_t *, uint32_t, int);
+void      __manifest_descend(const uint64_t *, const uint64_t *, uint32_t *,
+                             uint32_t *, size_t, uint32_t, CN_VEC);
+void     *__manifest_worker (void *);
+
+// Manifest Functions
+void        manifest_init    (ar_manifest_t *, uint64_t, uint32_t, uint32_t);
+int         manifest_hash_fd (ar_manifest_t *, int, size_t);
+void        manifest_build   (ar_manifest_t *);
+int         manifest_write   (FILE *, ar_manifest_t *);
+int         manifest_read    (FILE *, ar_manifest_t *);
+int         manifest_diff    (ar_manifest_t *, ar_manifest_t *, CN_VEC);
+uint64_t    manifest_root    (ar_manifest_t *);
+void        manifest_free    (ar_manifest_t *);
+const char *manifest_strerror(int);
+
+#endif
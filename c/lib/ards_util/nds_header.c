@@ -0,0 +1,103 @@
+/*
+ * ARDS Utils - NDS Header
+ *
+ * Description:
+ *     Provides parsing and validation of the 0x200 byte header at the start
+ *     of an NDS ROM. See "nds_header.h" for what is checked.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include "nds_header.h"
+
+// Names for each flag, in bit order, for printing
+static const char *nds_header_flag_names[NDS_HEADER_FLAG_COUNT] = {
+	"BAD_CRC",
+	"BAD_LOGO_CRC",
+	"BAD_LOGO",
+	"TRIMMED",
+	"BAD_BINARY",
+	"OVERSIZED"
+};
+
+/*
+ * nds_header_validate
+ *
+ * Given the first 0x200 bytes of an NDS ROM in "bytes", and the size of the
+ * whole file in "file_size", checks the header and returns a mask of
+ * NDS_HEADER_* flags. NDS_HEADER_OK (0) means nothing is wrong.
+ */
+
+uint16_t nds_header_validate(const uint8_t *bytes, uint64_t file_size) {
+	const nds_header_t *header;
+	uint16_t            flags;
+	uint64_t            end;
+
+	header = (const nds_header_t *) bytes;
+	flags  = NDS_HEADER_OK;
+
+	// Checksums
+	if (
+		crc16(NDS_HEADER_CRC_INIT, 0x15E, (uint8_t *) bytes) !=
+		header->header_crc
+	) {
+		flags |= NDS_HEADER_BAD_CRC;
+	}
+
+	if (
+		crc16(NDS_HEADER_CRC_INIT, 0x9C, (uint8_t *) header->logo) !=
+		header->logo_crc
+	) {
+		flags |= NDS_HEADER_BAD_LOGO_CRC;
+	}
+
+	if (header->logo_crc != NDS_LOGO_CRC)
+		flags |= NDS_HEADER_BAD_LOGO;
+
+	// Is the file long enough to hold what the header says it uses?
+	if (file_size < header->rom_size)
+		flags |= NDS_HEADER_TRIMMED;
+
+	end = (uint64_t) header->arm9_offset + header->arm9_size;
+
+	if (file_size < end)
+		flags |= NDS_HEADER_BAD_BINARY;
+
+	end = (uint64_t) header->arm7_offset + header->arm7_size;
+
+	if (file_size < end)
+		flags |= NDS_HEADER_BAD_BINARY;
+
+	// Anything past the chip's capacity couldn't have come from a cartridge.
+	// Capacities past 4 GiB don't exist, so don't trust big values.
+	if (header->capacity < 16 && file_size > (0x20000ULL << header->capacity))
+		flags |= NDS_HEADER_OVERSIZED;
+
+	return flags;
+}
+
+/*
+ * nds_header_print_flags
+ *
+ * Prints "flags" to "fp" as a comma-separated list of names, or "OK" if none
+ * are set.
+ */
+
+void nds_header_print_flags(FILE *fp, uint16_t flags) {
+	size_t i;
+	int    first;
+
+	if (flags == NDS_HEADER_OK) {
+		fprintf(fp, "OK");
+		return;
+	}
+
+	for (i = 0, first = 1; i < NDS_HEADER_FLAG_COUNT; i++) {
+		if (!(flags & (1 << i)))
+			continue;
+
+		fprintf(fp, "%s%s", first ? "" : ",", nds_header_flag_names[i]);
+		first = 0;
+	}
+}
@@ -0,0 +1,122 @@
+/*
+ * ARDS Utils - NDS Header
+ *
+ * Description:
+ *     Provides parsing and validation of the 0x200 byte header at the start
+ *     of an NDS ROM. This is the same 0x200 bytes the Game ID is made from,
+ *     so a ROM can be validated from the same read.
+ *
+ *     The header holds two CRC16s. One at 0x15C over the Nintendo logo
+ *     (0x0C0 - 0x15B), which is always 0xCF56 for a real logo, and one at
+ *     0x15E over everything before it (0x000 - 0x15D). Both use the same
+ *     CRC16 as the firmware, starting from 0xFFFF.
+ *
+ *     The header also says how much of the ROM is actually used, and where
+ *     the ARM9 and ARM7 binaries are. If the file doesn't cover those, it was
+ *     cut short (over-trimmed, or a bad dump).
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_NDS_HEADER__
+#define __ARDS_UTILS_NDS_HEADER__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "firmware.h"
+
+// ----------------------------------------------------------------------------
+// NDS Header Data Structs                                                 {{{1
+// ----------------------------------------------------------------------------
+
+#define NDS_HEADER_SZ       0x200
+#define NDS_HEADER_CRC_INIT 0xFFFF
+#define NDS_LOGO_CRC        0xCF56
+
+/*
+ * NDS_HEADER_T
+ *
+ * The first 0x200 bytes of an NDS ROM. Every field is naturally aligned, so
+ * this can be laid right over the bytes read from the file.
+ */
+
+typedef struct NDS_HEADER_T {
+	                                 // Bytes      Description
+	                                 // ---        ---
+	char     title[12];              // 000 - 00B. Game title, ASCII
+	char     game_code[4];           // 00C - 00F. 4 characters on cartridge
+	char     maker_code[2];          // 010 - 011. Licensee
+	uint8_t  unit_code;              // 012 - 012. 0 = NDS, 2 = NDS + DSi
+	uint8_t  seed_select;            // 013 - 013. Encryption seed select
+	uint8_t  capacity;               // 014 - 014. Chip size is 128 KiB << n
+	uint8_t  reserved_a[8];          // 015 - 01C.
+	uint8_t  region;                 // 01D - 01D. 0x80 = China, 0x40 = Korea
+	uint8_t  version;                // 01E - 01E. ROM version
+	uint8_t  autostart;              // 01F - 01F.
+	uint32_t arm9_offset;            // 020 - 023. ARM9 binary in ROM
+	uint32_t arm9_entry;             // 024 - 027.
+	uint32_t arm9_ram;               // 028 - 02B.
+	uint32_t arm9_size;              // 02C - 02F.
+	uint32_t arm7_offset;            // 030 - 033. ARM7 binary in ROM
+	uint32_t arm7_entry;             // 034 - 037.
+	uint32_t arm7_ram;               // 038 - 03B.
+	uint32_t arm7_size;              // 03C - 03F.
+	uint32_t fnt_offset;             // 040 - 043. File name table
+	uint32_t fnt_size;               // 044 - 047.
+	uint32_t fat_offset;             // 048 - 04B. File allocation table
+	uint32_t fat_size;               // 04C - 04F.
+	uint32_t arm9_overlay_offset;    // 050 - 053.
+	uint32_t arm9_overlay_size;      // 054 - 057.
+	uint32_t arm7_overlay_offset;    // 058 - 05B.
+	uint32_t arm7_overlay_size;      // 05C - 05F.
+	uint32_t rom_ctrl_normal;        // 060 - 063. Port 40001A4h settings
+	uint32_t rom_ctrl_key1;          // 064 - 067.
+	uint32_t icon_offset;            // 068 - 06B. Icon/title
+	uint16_t secure_crc;             // 06C - 06D. CRC16 of 0x4000 - 0x7FFF
+	uint16_t secure_delay;           // 06E - 06F.
+	uint32_t arm9_autoload;          // 070 - 073.
+	uint32_t arm7_autoload;          // 074 - 077.
+	uint8_t  secure_disable[8];      // 078 - 07F.
+	uint32_t rom_size;               // 080 - 083. Used ROM size, in bytes
+	uint32_t header_size;            // 084 - 087. Always 0x4000
+	uint8_t  reserved_b[0x38];       // 088 - 0BF.
+	uint8_t  logo[0x9C];             // 0C0 - 15B. Nintendo logo
+	uint16_t logo_crc;               // 15C - 15D. CRC16 of 0C0 - 15B
+	uint16_t header_crc;             // 15E - 15F. CRC16 of 000 - 15D
+	uint32_t debug_offset;           // 160 - 163.
+	uint32_t debug_size;             // 164 - 167.
+	uint32_t debug_ram;              // 168 - 16B.
+	uint8_t  reserved_c[0x94];       // 16C - 1FF.
+} nds_header_t;
+
+/*
+ * NDS_HEADER_FLAG_T
+ *
+ * Problems "nds_header_validate" can find. More than one can be set.
+ */
+
+typedef enum NDS_HEADER_FLAG_T {
+	NDS_HEADER_OK           = 0x00, // Nothing wrong
+	NDS_HEADER_BAD_CRC      = 0x01, // Header CRC16 doesn't match
+	NDS_HEADER_BAD_LOGO_CRC = 0x02, // Logo CRC16 doesn't match
+	NDS_HEADER_BAD_LOGO     = 0x04, // Logo CRC16 isn't Nintendo's
+	NDS_HEADER_TRIMMED      = 0x08, // File is smaller than the used ROM size
+	NDS_HEADER_BAD_BINARY   = 0x10, // ARM9/ARM7 go past the end of the file
+	NDS_HEADER_OVERSIZED    = 0x20  // File is bigger than the chip
+} nds_header_flag_t;
+
+#define NDS_HEADER_FLAG_COUNT 6
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+uint16_t nds_header_validate  (const uint8_t *, uint64_t);
+void     nds_header_print_flags(FILE *, uint16_t);
+
+#endif
@@ -0,0 +1,513 @@
+/*
+ * r4.c
+ */
+
+#include "r4.h"
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __r4_write                                                              {{{2
+ *
+ * Writes "len" bytes of "data" to "out" and returns "len". If "out" is NULL,
+ * nothing is written. This lets the same functions size up a game block
+ * before it is written, which is needed to fill out the index first.
+ */
+
+size_t __r4_write(FILE *out, const void *data, size_t len) {
+	if (out != NULL)
+		fwrite(data, sizeof(uint8_t), len, out);
+
+	return len;
+}
+
+size_t __r4_write_u32(FILE *out, uint32_t v) {
+	return __r4_write(out, &v, sizeof(uint32_t));
+}
+
+/*
+ * __r4_write_text                                                         {{{2
+ *
+ * Writes "name" and "desc" as C-Strings, then pads with zeroes to a 4 byte
+ * boundary. If "desc" is NULL, only "name" is written. Returns bytes written.
+ */
+
+size_t __r4_write_text(FILE *out, const char *name, const char *desc) {
+	static const uint8_t zero[4] = { 0, 0, 0, 0 };
+	size_t len, padded;
+
+	if (name == NULL)
+		name = "";
+
+	len = __r4_write(out, name, strlen(name) + 1);
+
+	if (desc != NULL)
+		len += __r4_write(out, desc, strlen(desc) + 1);
+
+	padded = (len + 3) & ~((size_t) 3);
+
+	return len + __r4_write(out, zero, padded - len);
+}
+
+/*
+ * __r4_count_items                                                        {{{2
+ *
+ * Counts folders and cheats the way the game block header wants them. Since
+ * R4 can't nest folders, anything deeper than the top is flattened into its
+ * top-level folder, so only its cheats are counted.
+ */
+
+uint32_t __r4_count_items(CN_VEC root, uint8_t depth) {
+	ar_data_t *it;
+	uint32_t   num;
+
+	num = 0;
+
+	cn_vec_traverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				num++;
+				break;
+
+			case AR_FLAG_FOLDER:
+				num += (depth == 0) + __r4_count_items(it->data, depth + 1);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+
+	return num;
+}
+
+/*
+ * __r4_write_items                                                        {{{2
+ *
+ * Writes every folder and cheat in "root", in the order they are shown. Nested
+ * folders are flattened into their top-level folder. Returns bytes written.
+ */
+
+size_t __r4_write_items(FILE *out, CN_VEC root, size_t depth) {
+	ar_data_t *it;
+	uint32_t   hdr, num;
+	size_t     sz, text_sz;
+
+	sz = 0;
+
+	cn_vec_rtraverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		switch ((ar_flag_t) it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				// Header holds the number of u32s that follow it
+				num     = 2 * cn_vec_size(it->data);
+				text_sz = __r4_write_text(NULL, it->name, it->desc);
+				hdr     = (text_sz / 4) + 1 + num;
+
+				if (it->flag & AR_FLAG_ON_DEFAULT)
+					hdr |= R4_FLAG_ON;
+
+				sz += __r4_write_u32 (out, hdr);
+				sz += __r4_write_text(out, it->name, it->desc);
+				sz += __r4_write_u32 (out, num);
+				sz += __r4_write(
+					out, cn_vec_data(it->data), num * sizeof(uint32_t)
+				);
+
+				break;
+
+			case AR_FLAG_FOLDER:
+				if (depth == 0) {
+					hdr = R4_FLAG_FOLDER | __r4_count_items(it->data, 1);
+
+					// Radio Button Folder (only 1 code allowed on at once)
+					if (it->flag & AR_FLAG_ONLYONE)
+						hdr |= R4_FLAG_ON;
+
+					sz += __r4_write_u32 (out, hdr);
+					sz += __r4_write_text(out, it->name, it->desc);
+				}
+
+				sz += __r4_write_items(out, it->data, depth + 1);
+				break;
+
+			case AR_FLAG_TERMINATE:
+			default:
+				break;
+		}
+	}
+
+	return sz;
+}
+
+/*
+ * __r4_write_game                                                         {{{2
+ *
+ * Writes a game block. Returns bytes written.
+ */
+
+size_t __r4_write_game(FILE *out, ARDS_GAME game) {
+	static const uint32_t master[8] = { 0, 0, 0, 0, 0, 0, 0, 0 };
+	size_t sz;
+
+	sz  = __r4_write_text (out, game->name, NULL);
+	sz += __r4_write_u32  (out, __r4_count_items(game->library, 0));
+	sz += __r4_write      (out, master, sizeof(master));
+	sz += __r4_write_items(out, game->library, 0);
+
+	return sz;
+}
+
+/*
+ * __r4_read_index                                                         {{{2
+ *
+ * Reads the "i"th entry of the game index into "entry". The size of the game
+ * block is figured out from where the next one starts (or the end of the
+ * file) and stored in "size". Returns 0 if past the end of the index.
+ */
+
+int __r4_read_index(FILE *fp, size_t i, r4_index_t *entry, uint32_t *size) {
+	r4_index_t next;
+
+	fseek(fp, R4_INDEX_START + i * sizeof(r4_index_t), SEEK_SET);
+
+	if (fread(entry, sizeof(r4_index_t), 1, fp) != 1 || entry->offset == 0)
+		return 0;
+
+	if (fread(&next, sizeof(r4_index_t), 1, fp) != 1 || next.offset == 0) {
+		fseek(fp, 0, SEEK_END);
+		next.offset = ftell(fp);
+	}
+
+	if (next.offset < entry->offset)
+		return 0;
+
+	*size = next.offset - entry->offset;
+	return 1;
+}
+
+/*
+ * __r4_read_text                                                          {{{2
+ *
+ * Reads a name and note starting at "pos" in "buf" (of size "len"). Returns
+ * the 4 byte aligned position after them, or 0 if they run off the end.
+ */
+
+size_t __r4_read_text(
+	uint8_t *buf,
+	size_t   len,
+	size_t   pos,
+	char   **name,
+	char   **desc
+) {
+	uint8_t *end;
+
+	// Name
+	end = memchr(&buf[pos], 0, len - pos);
+
+	if (end == NULL)
+		return 0;
+
+	*name = strdup((char *) &buf[pos]);
+	pos   = end - buf + 1;
+
+	// Note
+	end = (pos < len) ? memchr(&buf[pos], 0, len - pos) : NULL;
+
+	if (end == NULL)
+		return 0;
+
+	*desc = strdup((char *) &buf[pos]);
+
+	// Padding
+	return ((end - buf) + 4) & ~((size_t) 3);
+}
+
+/*
+ * __r4_read_game                                                          {{{2
+ *
+ * Parses a game block in "buf" (of size "len") into "game". Returns 0 on
+ * success. On failure, whatever was read in is left in "game" so it can be
+ * cleaned up as usual.
+ */
+
+int __r4_read_game(ARDS_GAME game, uint8_t *buf, size_t len) {
+	ar_data_t  tmp_data;
+	ar_data_t *folder, *cheat;
+	ar_line_t *lines;
+	CN_VEC     root;
+	uint8_t   *end;
+	uint32_t   hdr, num_items, items, count, num, i, j;
+	size_t     pos, next;
+
+	// Game name, padded to 4 bytes
+	end = memchr(buf, 0, len);
+
+	if (end == NULL)
+		return 1;
+
+	game->name = strdup((char *) buf);
+	game->desc = strdup("");
+
+	pos = ((end - buf) + 4) & ~((size_t) 3);
+
+	// Number of items, then skip over the master code
+	if (pos + 36 > len)
+		return 1;
+
+	num_items = *(uint32_t *) &buf[pos] & 0x0FFFFFFF;
+	pos += 36;
+
+	tmp_data.name = NULL;
+	tmp_data.desc = NULL;
+
+	for (items = 0; items < num_items; ) {
+		if (pos + 4 > len)
+			return 1;
+
+		hdr    = *(uint32_t *) &buf[pos];
+		root   = game->library;
+		folder = NULL;
+		count  = 1;
+
+		// Folders hold "count" cheats right after them
+		if ((hdr & R4_MASK_TYPE) == R4_FLAG_FOLDER) {
+			tmp_data.flag = AR_FLAG_FOLDER;
+			tmp_data.data = cn_vec_init(ar_data_t);
+
+			if (hdr & R4_FLAG_ON)
+				tmp_data.flag |= AR_FLAG_ONLYONE;
+
+			cn_vec_push_back(game->library, &tmp_data);
+			folder = cn_vec_at(
+				game->library, cn_vec_size(game->library) - 1
+			);
+
+			pos = __r4_read_text(
+				buf, len, pos + 4, &folder->name, &folder->desc
+			);
+
+			if (pos == 0)
+				return 1;
+
+			root  = folder->data;
+			count = hdr & R4_MASK_COUNT;
+			items++;
+		}
+
+		for (i = 0; i < count; i++, items++) {
+			if (pos + 4 > len)
+				return 1;
+
+			hdr  = *(uint32_t *) &buf[pos];
+			next = pos + 4 + 4 * (size_t) (hdr & R4_MASK_COUNT);
+
+			if (next > len)
+				return 1;
+
+			tmp_data.flag = AR_FLAG_CODE;
+			tmp_data.data = cn_vec_init(ar_line_t);
+
+			if (hdr & R4_FLAG_ON)
+				tmp_data.flag |= AR_FLAG_ON_DEFAULT;
+
+			cn_vec_push_back(root, &tmp_data);
+			cheat = cn_vec_at(root, cn_vec_size(root) - 1);
+
+			pos = __r4_read_text(
+				buf, next, pos + 4, &cheat->name, &cheat->desc
+			);
+
+			if (pos == 0 || pos + 4 > next)
+				return 1;
+
+			// Code words. Two per line.
+			num  = *(uint32_t *) &buf[pos] / 2;
+			pos += 4;
+
+			if (pos + num * sizeof(ar_line_t) > next)
+				return 1;
+
+			cn_vec_resize(cheat->data, num);
+			lines = cn_vec_array(cheat->data, ar_line_t);
+
+			for (j = 0; j < num; j++, pos += sizeof(ar_line_t)) {
+				lines[j].memory_location = *(uint32_t *) &buf[pos    ];
+				lines[j].value           = *(uint32_t *) &buf[pos + 4];
+			}
+
+			cheat->num_entries = num;
+			pos = next;
+		}
+
+		if (folder != NULL) {
+			library_reverse(folder->data);
+			folder->num_entries = cn_vec_size(folder->data);
+		}
+	}
+
+	// Stored in the order they are shown. Flip back to how ARDS stores them.
+	library_reverse(game->library);
+	game->header.num_codes = library_count_codes(game->library);
+
+	return 0;
+}
+
+/*
+ * __r4_load_game                                                          {{{2
+ *
+ * Reads the game block that "entry" points to. Returns NULL if it's broken.
+ */
+
+ARDS_GAME __r4_load_game(FILE *fp, r4_index_t *entry, uint32_t size) {
+	ARDS_GAME game;
+	uint8_t  *buf;
+	int       status;
+
+	// Same defaults as a game read from a ROM
+	game = ards_game_init();
+	memset(&game->header, 0, sizeof(ar_game_info_t));
+
+	game->header.magic   = 0x001C0001;
+	game->header.nx20    = 0x0020;
+	game->header.N_CRC32 = entry->N_CRC32;
+	game->library        = cn_vec_init(ar_data_t);
+	game->offset         = entry->offset;
+
+	memcpy(game->header.ID, entry->ID, 4);
+
+	// Pull in the whole block and parse it from memory
+	buf = (uint8_t *) malloc(size);
+
+	fseek(fp, entry->offset, SEEK_SET);
+	status = fread(buf, sizeof(uint8_t), size, fp) != size;
+
+	if (status == 0)
+		status = __r4_read_game(game, buf, size);
+
+	free(buf);
+
+	if (status != 0) {
+		ards_game_free(game);
+		return NULL;
+	}
+
+	return game;
+}
+
+// ----------------------------------------------------------------------------
+// R4 Read Functions                                                       {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * ards_game_import_from_r4                                                {{{2
+ *
+ * Finds the game with ID "id" (4 chars) and ~CRC32 "N_CRC32" in the index of
+ * an R4 usrcheat.dat and reads only that game. Returns NULL if it isn't in
+ * the index or its block is broken.
+ */
+
+ARDS_GAME ards_game_import_from_r4(
+	FILE       *fp,
+	const char *id,
+	uint32_t    N_CRC32
+) {
+	r4_index_t entry;
+	uint32_t   size;
+	size_t     i;
+
+	for (i = 0; __r4_read_index(fp, i, &entry, &size); i++) {
+		if (entry.N_CRC32 == N_CRC32 && memcmp(entry.ID, id, 4) == 0)
+			return __r4_load_game(fp, &entry, size);
+	}
+
+	return NULL;
+}
+
+/*
+ * ards_game_import_all_from_r4                                            {{{2
+ *
+ * Reads every game in an R4 usrcheat.dat. Broken games are skipped. Returns a
+ * vector<ARDS_GAME>.
+ */
+
+CN_VEC ards_game_import_all_from_r4(FILE *fp) {
+	r4_index_t entry;
+	uint32_t   size;
+	size_t     i;
+	CN_VEC     games;
+	ARDS_GAME  game;
+
+	games = cn_vec_init(ARDS_GAME);
+
+	for (i = 0; __r4_read_index(fp, i, &entry, &size); i++) {
+		game = __r4_load_game(fp, &entry, size);
+
+		if (game != NULL)
+			cn_vec_push_back(games, &game);
+	}
+
+	return games;
+}
+
+// ----------------------------------------------------------------------------
+// R4 Output Functions                                                     {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * ards_game_export_as_r4                                                  {{{2
+ *
+ * Writes every game in "game_arr" out as an R4 usrcheat.dat named "name".
+ * Game blocks are sized up first so the index can be written before them.
+ * "out" doesn't have to be seekable.
+ */
+
+void ards_game_export_as_r4(CN_VEC game_arr, FILE *out, const char *name) {
+	r4_header_t header;
+	r4_index_t  entry;
+	ARDS_GAME  *it;
+	uint32_t    offset;
+
+	// File header
+	memset(&header, 0, sizeof(r4_header_t));
+	memcpy(header.magic, "R4 CheatCode", 12);
+	strncpy(header.name, name, R4_NAME_MAX);
+
+	header.version     = 0x00000100;
+	header.encoding[0] = 0xD5;
+	header.encoding[1] = 0x53;
+	header.encoding[2] = 0x41;
+	header.encoding[3] = 0x59;
+	header.enabled     = 1;
+
+	fwrite(&header, sizeof(r4_header_t), 1, out);
+
+	// Index. Game blocks start right after it and the terminating entry.
+	offset = R4_INDEX_START
+		+ (cn_vec_size(game_arr) + 1) * sizeof(r4_index_t);
+
+	cn_vec_traverse(game_arr, it) {
+		memcpy(entry.ID, (*it)->header.ID, 4);
+		entry.N_CRC32 = (*it)->header.N_CRC32;
+		entry.offset  = offset;
+		entry.pad     = 0;
+
+		fwrite(&entry, sizeof(r4_index_t), 1, out);
+		offset += __r4_write_game(NULL, *it);
+	}
+
+	memset(&entry, 0, sizeof(r4_index_t));
+	fwrite(&entry, sizeof(r4_index_t), 1, out);
+
+	// Game blocks
+	cn_vec_traverse(game_arr, it)
+		__r4_write_game(out, *it);
+}
@@ -0,0 +1,123 @@
+/*
+ * ARDS Utils - R4
+ *
+ * Description:
+ *     Provides reading and writing of R4-style "usrcheat.dat" cheat databases,
+ *     mapped to and from the same ar_game_t/ar_data_t structs used for ARDS
+ *     dumps.
+ *
+ *     The file starts with a 0x100 byte header, followed by an index of games
+ *     at 0x100. Each index entry holds the game's 4 character ID, the same
+ *     ~CRC32 that ARDS uses, and the offset of the game's block. The index
+ *     ends with an entry that is all zeroes. Each game block is:
+ *
+ *         Game name (null-terminated, padded to 4 bytes)
+ *         u32     Number of folders and cheats (folders count themselves AND
+ *                 each cheat inside of them)
+ *         u32 x 8 Master code (not used by ARDS, written as zeroes)
+ *         Folders and cheats
+ *
+ *     A folder is a u32 of 0x10000000 | number of cheats inside, followed by
+ *     its name and note (null-terminated, padded to 4 bytes), then its
+ *     cheats. Folders can't be nested.
+ *
+ *     A cheat is a u32 holding the number of u32s that follow it in the
+ *     cheat, then its name and note (null-terminated, padded to 4 bytes), a
+ *     u32 number of code words, and the code words themselves.
+ *
+ *     Bit 0x01000000 of a folder means only one cheat can be on at once. Of a
+ *     cheat, it means it is on by default.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_R4__
+#define __ARDS_UTILS_R4__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "io.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// R4 Data Structs                                                         {{{1
+// ----------------------------------------------------------------------------
+
+#define R4_INDEX_START 0x100
+#define R4_NAME_MAX    0x3B
+
+#define R4_FLAG_FOLDER 0x10000000
+#define R4_FLAG_ON     0x01000000
+#define R4_MASK_TYPE   0xF0000000
+#define R4_MASK_COUNT  0x00FFFFFF
+
+/*
+ * R4_HEADER_T
+ *
+ * The first 0x100 bytes of the file.
+ */
+
+typedef struct R4_HEADER_T {
+	                                // Bytes      Description
+	                                // ---        ---
+	char     magic[12];             // 000 - 00B. "R4 CheatCode"
+	uint32_t version;               // 00C - 00F. Always 0x00000100
+	char     name[R4_NAME_MAX + 1]; // 010 - 04B. Name of the database
+	uint8_t  encoding[4];           // 04C - 04F. "D5 53 41 59" for UTF-8
+	uint8_t  enabled;               // 050 - 050. Cheats enabled
+	uint8_t  pad[0xAF];             // 051 - 0FF. Unused
+} r4_header_t;
+
+/*
+ * R4_INDEX_T
+ *
+ * A single entry of the game index at 0x100.
+ */
+
+typedef struct R4_INDEX_T {
+	                           // Bytes    Description
+	                           // ---      ---
+	char     ID[4];            // 00 - 03. 4 characters on cartridge
+	uint32_t N_CRC32;          // 04 - 07. ~CRC32(first 512 bytes of ROM)
+	uint32_t offset;           // 08 - 11. Offset of game block in file
+	uint32_t pad;              // 12 - 15. Always 0
+} r4_index_t;
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+size_t   __r4_write      (FILE *, const void *, size_t);
+size_t   __r4_write_u32  (FILE *, uint32_t);
+size_t   __r4_write_text (FILE *, const char *, const char *);
+uint32_t __r4_count_items(CN_VEC, uint8_t);
+size_t   __r4_write_items(FILE *, CN_VEC, size_t);
+size_t   __r4_write_game (FILE *, ARDS_GAME);
+
+int    __r4_read_index(FILE *, size_t, r4_index_t *, uint32_t *);
+size_t __r4_read_text (uint8_t *, size_t, size_t, char **, char **);
+int    __r4_read_game (ARDS_GAME, uint8_t *, size_t);
+ARDS_GAME __r4_load_game(FILE *, r4_index_t *, uint32_t);
+
+// ----------------------------------------------------------------------------
+// R4 Read Functions                                                       {{{1
+// ----------------------------------------------------------------------------
+
+ARDS_GAME ards_game_import_from_r4    (FILE *, const char *, uint32_t);
+CN_VEC    ards_game_import_all_from_r4(FILE *);
+
+// ----------------------------------------------------------------------------
+// R4 Output Functions                                                     {{{1
+// ----------------------------------------------------------------------------
+
+void ards_game_export_as_r4(CN_VEC, FILE *, const char *);
+
+#endif
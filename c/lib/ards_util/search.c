@@ -0,0 +1,312 @@
+/*
+ * search.c
+ */
+
+#include "search.h"
+
+// SSE2 is always there on x86-64
+#if defined(__GNUC__) && defined(__SSE2__)
+#define SEARCH_SSE2
+#include <emmintrin.h>
+#endif
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __search_load
+ *
+ * The "width" byte little endian value at "p".
+ */
+
+uint32_t __search_load(const uint8_t *p, uint32_t width) {
+	uint32_t v;
+
+	v = 0;
+	memcpy(&v, p, width);
+
+	return v;
+}
+
+/*
+ * __search_slot
+ *
+ * Compares a single address. "a" and "b" point at its value in the newest
+ * and previous snapshot. If "b" is NULL, "value" is compared against
+ * instead.
+ */
+
+int __search_slot(
+	const uint8_t *a,
+	const uint8_t *b,
+	uint32_t       value,
+	uint32_t       width,
+	int            cmp
+) {
+	uint32_t x, y;
+
+	x = __search_load(a, width);
+	y = (b != NULL) ? __search_load(b, width) : value;
+
+	switch (cmp) {
+		case AR_SEARCH_EQ: return x == y;
+		case AR_SEARCH_NE: return x != y;
+		case AR_SEARCH_GT: return x >  y;
+		case AR_SEARCH_LT: return x <  y;
+	}
+
+	return 0;
+}
+
+#ifdef SEARCH_SSE2
+/*
+ * __search_cmpeq / __search_cmpgt / __search_movemask
+ *
+ * SSE2 only has signed compares, so values are flipped around their middle
+ * before "cmpgt" to compare them unsigned. "movemask" gives 1 bit per lane.
+ */
+
+static __m128i __search_cmpeq(__m128i x, __m128i y, uint32_t width) {
+	switch (width) {
+		case 1:  return _mm_cmpeq_epi8(x, y);
+		case 2:  return _mm_cmpeq_epi16(x, y);
+		default: return _mm_cmpeq_epi32(x, y);
+	}
+}
+
+static __m128i __search_cmpgt(__m128i x, __m128i y, uint32_t width) {
+	__m128i bias;
+
+	switch (width) {
+		case 1:
+			bias = _mm_set1_epi8((char) 0x80);
+			return _mm_cmpgt_epi8(
+				_mm_xor_si128(x, bias),
+				_mm_xor_si128(y, bias)
+			);
+
+		case 2:
+			bias = _mm_set1_epi16((short) 0x8000);
+			return _mm_cmpgt_epi16(
+				_mm_xor_si128(x, bias),
+				_mm_xor_si128(y, bias)
+			);
+
+		default:
+			bias = _mm_set1_epi32((int) 0x80000000);
+			return _mm_cmpgt_epi32(
+				_mm_xor_si128(x, bias),
+				_mm_xor_si128(y, bias)
+			);
+	}
+}
+
+static uint32_t __search_movemask(__m128i r, uint32_t width) {
+	switch (width) {
+		case 1:
+			return _mm_movemask_epi8(r);
+
+		case 2:
+			return _mm_movemask_epi8(_mm_packs_epi16(r, _mm_setzero_si128()));
+
+		default:
+			return _mm_movemask_ps(_mm_castsi128_ps(r));
+	}
+}
+#endif
+
+/*
+ * __search_block
+ *
+ * Compares the 64 addresses starting at "a" (and "b"), which must all be in
+ * RAM. Bit "k" of the result is set if address "k" passes.
+ */
+
+uint64_t __search_block(
+	const uint8_t *a,
+	const uint8_t *b,
+	uint32_t       value,
+	uint32_t       width,
+	int            cmp
+) {
+	uint64_t mask;
+	uint32_t k;
+#ifdef SEARCH_SSE2
+	__m128i  x, y, v, r;
+	uint32_t m, per;
+
+	// 16 bytes at a time, which is "per" addresses
+	per = 16 / width;
+
+	switch (width) {
+		case 1:  v = _mm_set1_epi8((char) value);   break;
+		case 2:  v = _mm_set1_epi16((short) value); break;
+		default: v = _mm_set1_epi32((int) value);   break;
+	}
+
+	mask = 0;
+
+	for (k = 0; k < 64; k += per) {
+		x = _mm_loadu_si128((const __m128i *) (a + k * width));
+		y = (b != NULL)
+			? _mm_loadu_si128((const __m128i *) (b + k * width))
+			: v;
+
+		switch (cmp) {
+			case AR_SEARCH_GT: r = __search_cmpgt(x, y, width); break;
+			case AR_SEARCH_LT: r = __search_cmpgt(y, x, width); break;
+			default:           r = __search_cmpeq(x, y, width); break;
+		}
+
+		m = __search_movemask(r, width);
+
+		if (cmp == AR_SEARCH_NE)
+			m = ~m & ((1U << per) - 1);
+
+		mask |= (uint64_t) m << k;
+	}
+#else
+	// One address at a time
+	mask = 0;
+
+	for (k = 0; k < 64; k++) {
+		if (
+			__search_slot(
+				a + k * width,
+				(b != NULL) ? b + k * width : NULL,
+				value,
+				width,
+				cmp
+			)
+		)
+			mask |= 1ULL << k;
+	}
+#endif
+
+	return mask;
+}
+
+// ----------------------------------------------------------------------------
+// Search Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * search_init
+ *
+ * Sets up a search of "size" bytes of RAM, "width" bytes at a time. Every
+ * aligned address starts out as a candidate.
+ */
+
+void search_init(ar_search_t *s, uint32_t size, uint32_t width) {
+	s->size  = size;
+	s->width = width;
+	s->slots = size / width;
+	s->words = (s->slots + 63) / 64;
+	s->bits  = (uint64_t *) malloc((s->words + 1) * sizeof(uint64_t));
+	s->count = s->slots;
+
+	memset(s->bits, 0xFF, s->words * sizeof(uint64_t));
+
+	// Addresses past the end of RAM were never candidates
+	if (s->slots % 64 != 0)
+		s->bits[s->words - 1] = (1ULL << (s->slots % 64)) - 1;
+}
+
+/*
+ * search_filter
+ *
+ * Rules out every candidate whose value in "cur" doesn't compare "cmp" to
+ * its value in "prev", or to "value" if "prev" is NULL. Both snapshots are
+ * "size" bytes. Returns how many candidates are left.
+ */
+
+size_t search_filter(
+	ar_search_t   *s,
+	const uint8_t *cur,
+	const uint8_t *prev,
+	int            cmp,
+	uint32_t       value
+) {
+	size_t   w, k, off, span;
+	uint64_t keep;
+
+	span     = 64 * s->width;
+	s->count = 0;
+
+	for (w = 0; w < s->words; w++) {
+		if (s->bits[w] == 0)
+			continue;
+
+		off = w * span;
+
+		if (off + span <= s->size) {
+			keep = __search_block(
+				cur + off,
+				(prev != NULL) ? prev + off : NULL,
+				value,
+				s->width,
+				cmp
+			);
+		}
+		else {
+			// Last word, with addresses past the end of RAM
+			keep = 0;
+
+			for (k = 0; w * 64 + k < s->slots; k++) {
+				if (
+					__search_slot(
+						cur + off + k * s->width,
+						(prev != NULL) ? prev + off + k * s->width : NULL,
+						value,
+						s->width,
+						cmp
+					)
+				)
+					keep |= 1ULL << k;
+			}
+		}
+
+		s->bits[w] &= keep;
+		s->count   += __builtin_popcountll(s->bits[w]);
+	}
+
+	return s->count;
+}
+
+/*
+ * search_next
+ *
+ * The first candidate at or after address "slot" (in units of "width"), or
+ * "slots" if there are none left.
+ */
+
+size_t search_next(const ar_search_t *s, size_t slot) {
+	size_t   w;
+	uint64_t word;
+
+	if (slot >= s->slots)
+		return s->slots;
+
+	w    = slot / 64;
+	word = s->bits[w] & (~0ULL << (slot % 64));
+
+	while (word == 0) {
+		if (++w >= s->words)
+			return s->slots;
+
+		word = s->bits[w];
+	}
+
+	return w * 64 + __builtin_ctzll(word);
+}
+
+/*
+ * search_free
+ */
+
+void search_free(ar_search_t *s) {
+	free(s->bits);
+	s->bits  = NULL;
+	s->count = 0;
+}
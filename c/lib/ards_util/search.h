@@ -0,0 +1,86 @@
+/*
+ * ARDS Utils - Search
+ *
+ * Description:
+ *     Provides a code finder, like the one on the Action Replay itself. It
+ *     narrows down which addresses of RAM hold a value by comparing
+ *     snapshots of RAM taken as the value changes in game.
+ *
+ *     Every 1, 2 or 4 byte aligned address starts out as a candidate. Each
+ *     filter keeps only the candidates whose value is equal to, not equal
+ *     to, greater than or less than either a given value, or their value in
+ *     the previous snapshot ("unchanged", "changed", "increased" and
+ *     "decreased").
+ *
+ *     Candidates are kept as a bitmap, one bit per address. A 64-bit word of
+ *     it is filtered at once, comparing 16 bytes at a time with SSE2 (or one
+ *     address at a time without it). Words with no candidates left are
+ *     skipped, so each filter gets faster as candidates are ruled out.
+ *
+ *     Comparisons are unsigned.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_SEARCH__
+#define __ARDS_UTILS_SEARCH__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ----------------------------------------------------------------------------
+// Search Data Structs                                                     {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * AR_SEARCH_CMP_T
+ *
+ * How the value at a candidate address is compared. The left side is the
+ * value in the newest snapshot.
+ */
+
+typedef enum AR_SEARCH_CMP_T {
+	AR_SEARCH_EQ = 0,
+	AR_SEARCH_NE,
+	AR_SEARCH_GT,
+	AR_SEARCH_LT
+} ar_search_cmp_t;
+
+/*
+ * AR_SEARCH_T
+ *
+ * The candidates of a search. Bit "k" of "bits" is address "k * width".
+ */
+
+typedef struct AR_SEARCH_T {
+	uint32_t  size;  // Bytes of RAM searched
+	uint32_t  width; // 1, 2 or 4 bytes per address
+	size_t    slots; // Addresses searched, or "size / width"
+	size_t    words; // 64-bit words in "bits"
+	uint64_t *bits;
+	size_t    count; // Candidates left
+} ar_search_t;
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+uint32_t __search_load (const uint8_t *, uint32_t);
+int      __search_slot (const uint8_t *, const uint8_t *, uint32_t, uint32_t,
+                        int);
+uint64_t __search_block(const uint8_t *, const uint8_t *, uint32_t, uint32_t,
+                        int);
+
+// Search Functions
+void   search_init  (ar_search_t *, uint32_t, uint32_t);
+size_t search_filter(ar_search_t *, const uint8_t *, const uint8_t *, int,
+                     uint32_t);
+size_t search_next  (const ar_search_t *, size_t);
+void   search_free  (ar_search_t *);
+
+#endif
@@ -0,0 +1,658 @@
+/*
+ * ARDS Utils - VM
+ *
+ * Description:
+ *     Provides an interpreter for Action Replay DS codes. See "vm.h" for how
+ *     it works.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include "vm.h"
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __vm_map
+ *
+ * Where "size" bytes at DS address "addr" are in the RAM image, or NULL if
+ * any of them aren't in RAM. RAM is mirrored all the way up to 0x02FFFFFF.
+ */
+
+uint8_t *__vm_map(ar_vm_t *vm, uint32_t addr, uint32_t size) {
+	uint32_t off;
+
+	if ((addr >> 24) != (VM_RAM_START >> 24))
+		return NULL;
+
+	off = (addr - VM_RAM_START) % vm->ram_sz;
+
+	if (off + size > vm->ram_sz)
+		return NULL;
+
+	return vm->ram + off;
+}
+
+/*
+ * __vm_read
+ *
+ * Reads "size" (1, 2 or 4) bytes at "addr", aligned down. Gives 0 for
+ * anything outside of RAM.
+ */
+
+uint32_t __vm_read(ar_vm_t *vm, uint32_t addr, uint32_t size) {
+	uint8_t  *p;
+	uint32_t  v;
+
+	p = __vm_map(vm, addr & ~(size - 1), size);
+
+	if (p == NULL) {
+		vm->faults++;
+		return 0;
+	}
+
+	v = 0;
+	memcpy(&v, p, size);
+
+	return v;
+}
+
+/*
+ * __vm_write
+ *
+ * Writes the low "size" (1, 2 or 4) bytes of "value" to "addr", aligned
+ * down, and remembers the page it was in.
+ */
+
+void __vm_write(ar_vm_t *vm, uint32_t addr, uint32_t value, uint32_t size) {
+	uint8_t  *p;
+	uint32_t  page;
+
+	p = __vm_map(vm, addr & ~(size - 1), size);
+
+	if (p == NULL) {
+		vm->faults++;
+		return;
+	}
+
+	memcpy(p, &value, size);
+	vm->writes += size;
+
+	page = (p - vm->ram) >> VM_PAGE_SHIFT;
+
+	if (!vm->dirty[page]) {
+		vm->dirty[page] = 1;
+		vm->dirty_list[vm->dirty_num++] = page;
+	}
+}
+
+/*
+ * __vm_span
+ *
+ * How many of "len" bytes from "addr" are before the next 16 MiB boundary.
+ * Copies and patches are done a region at a time, so that bytes outside of
+ * RAM can be counted as faults all at once instead of one by one.
+ */
+
+uint32_t __vm_span(uint32_t addr, uint32_t len) {
+	uint32_t room;
+
+	room = 0x01000000 - (addr & 0x00FFFFFF);
+
+	return (len < room) ? len : room;
+}
+
+/*
+ * __vm_push
+ *
+ * Pushes the result of a conditional code onto the execution status. If
+ * codes already aren't running, it fails no matter what "pass" is.
+ */
+
+void __vm_push(ar_vm_t *vm, int pass) {
+	vm->status = (vm->status << 1) | (pass ? 0 : 1);
+}
+
+/*
+ * __vm_repeat
+ *
+ * Jumps back to the start of the C0 loop if it has repeats left. Returns 1
+ * if it did.
+ */
+
+int __vm_repeat(ar_vm_t *vm) {
+	if (!vm->loop_active || vm->loop_count == 0)
+		return 0;
+
+	vm->loop_count--;
+	vm->pc     = vm->loop_pc;
+	vm->status = vm->loop_status;
+
+	return 1;
+}
+
+// ----------------------------------------------------------------------------
+// Code Handlers                                                           {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * One per AR_VM_* op. Everything but conditionals and D0 - D2 only gets
+ * called while the execution status is 0.
+ */
+
+// 0 - 2: Writes
+static int __vm_op_write32(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->addr + vm->offset, in->value, 4);
+	return AR_VM_OK;
+}
+
+static int __vm_op_write16(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->addr + vm->offset, in->value, 2);
+	return AR_VM_OK;
+}
+
+static int __vm_op_write8(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->addr + vm->offset, in->value, 1);
+	return AR_VM_OK;
+}
+
+// 3 - A: Conditionals. An address of 0 means the offset.
+static int __vm_op_if32(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	uint32_t v;
+	int      pass;
+
+	if (vm->status != 0) {
+		__vm_push(vm, 0);
+		return AR_VM_OK;
+	}
+
+	v = __vm_read(vm, (in->addr == 0) ? vm->offset : in->addr, 4);
+
+	switch (in->op) {
+		case AR_VM_IF32_GT: pass = in->value >  v; break;
+		case AR_VM_IF32_LT: pass = in->value <  v; break;
+		case AR_VM_IF32_EQ: pass = in->value == v; break;
+		default:            pass = in->value != v; break;
+	}
+
+	__vm_push(vm, pass);
+	return AR_VM_OK;
+}
+
+static int __vm_op_if16(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	uint32_t v;
+	int      pass;
+
+	if (vm->status != 0) {
+		__vm_push(vm, 0);
+		return AR_VM_OK;
+	}
+
+	v = __vm_read(vm, (in->addr == 0) ? vm->offset : in->addr, 2);
+	v &= in->extra;
+
+	switch (in->op) {
+		case AR_VM_IF16_GT: pass = in->value >  v; break;
+		case AR_VM_IF16_LT: pass = in->value <  v; break;
+		case AR_VM_IF16_EQ: pass = in->value == v; break;
+		default:            pass = in->value != v; break;
+	}
+
+	__vm_push(vm, pass);
+	return AR_VM_OK;
+}
+
+// B: Load offset
+static int __vm_op_load_offset(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->offset = __vm_read(vm, in->addr + vm->offset, 4);
+	return AR_VM_OK;
+}
+
+// C0: Loop
+static int __vm_op_loop(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->loop_active = 1;
+	vm->loop_pc     = vm->pc;
+	vm->loop_count  = in->value;
+	vm->loop_status = vm->status;
+
+	return AR_VM_OK;
+}
+
+// C5: Counter. "addr" is the value to compare, "extra" the mask.
+static int __vm_op_counter(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	if (vm->status != 0) {
+		__vm_push(vm, 0);
+		return AR_VM_OK;
+	}
+
+	vm->counter++;
+	__vm_push(vm, (vm->counter & in->extra) == in->addr);
+
+	return AR_VM_OK;
+}
+
+// C6: Save offset
+static int __vm_op_save_offset(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->value, vm->offset, 4);
+	return AR_VM_OK;
+}
+
+// D0: End if
+static int __vm_op_end_if(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->status >>= 1;
+	return AR_VM_OK;
+}
+
+// D1: End loop
+static int __vm_op_end_loop(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	if (!__vm_repeat(vm) && vm->loop_active) {
+		vm->status      = vm->loop_status;
+		vm->loop_active = 0;
+	}
+
+	return AR_VM_OK;
+}
+
+// D2: End loop, then everything
+static int __vm_op_end_all(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	if (!__vm_repeat(vm)) {
+		vm->status      = 0;
+		vm->offset      = 0;
+		vm->stored      = 0;
+		vm->loop_active = 0;
+	}
+
+	return AR_VM_OK;
+}
+
+// D3 - D5, DC: Registers
+static int __vm_op_set_offset(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->offset = in->value;
+	return AR_VM_OK;
+}
+
+static int __vm_op_add_stored(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->stored += in->value;
+	return AR_VM_OK;
+}
+
+static int __vm_op_set_stored(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->stored = in->value;
+	return AR_VM_OK;
+}
+
+static int __vm_op_add_offset(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->offset += in->value;
+	return AR_VM_OK;
+}
+
+// D6 - D8: Write stored, then move the offset past it
+static int __vm_op_put32(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->value + vm->offset, vm->stored, 4);
+	vm->offset += 4;
+	return AR_VM_OK;
+}
+
+static int __vm_op_put16(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->value + vm->offset, vm->stored, 2);
+	vm->offset += 2;
+	return AR_VM_OK;
+}
+
+static int __vm_op_put8(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	__vm_write(vm, in->value + vm->offset, vm->stored, 1);
+	vm->offset += 1;
+	return AR_VM_OK;
+}
+
+// D9 - DB: Read into stored
+static int __vm_op_get32(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->stored = __vm_read(vm, in->value + vm->offset, 4);
+	return AR_VM_OK;
+}
+
+static int __vm_op_get16(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->stored = __vm_read(vm, in->value + vm->offset, 2);
+	return AR_VM_OK;
+}
+
+static int __vm_op_get8(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	vm->stored = __vm_read(vm, in->value + vm->offset, 1);
+	return AR_VM_OK;
+}
+
+// E: Patch
+static int __vm_op_patch(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	uint32_t dst, left, n, i;
+	uint8_t *src;
+
+	dst  = in->addr + vm->offset;
+	src  = &vm->data[in->extra];
+	left = in->value;
+
+	while (left > 0) {
+		n = __vm_span(dst, left);
+
+		if ((dst >> 24) != (VM_RAM_START >> 24))
+			vm->faults += n;
+		else
+			for (i = 0; i < n; i++)
+				__vm_write(vm, dst + i, src[i], 1);
+
+		dst  += n;
+		src  += n;
+		left -= n;
+	}
+
+	return AR_VM_OK;
+}
+
+// F: Memory copy
+static int __vm_op_copy(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	uint32_t src, dst, left, n, i;
+
+	src  = vm->offset;
+	dst  = in->addr;
+	left = in->value;
+
+	while (left > 0) {
+		n = __vm_span(dst, __vm_span(src, left));
+
+		if ((dst >> 24) != (VM_RAM_START >> 24))
+			vm->faults += n * (((src >> 24) != (VM_RAM_START >> 24)) + 1);
+		else
+			for (i = 0; i < n; i++)
+				__vm_write(vm, dst + i, __vm_read(vm, src + i, 1), 1);
+
+		src  += n;
+		dst  += n;
+		left -= n;
+	}
+
+	return AR_VM_OK;
+}
+
+// Anything else
+static int __vm_op_bad(ar_vm_t *vm, const ar_vm_insn_t *in) {
+	return AR_VM_BAD_CODE;
+}
+
+/*
+ * Jump table. Indexed by AR_VM_*, in the same order as the enum.
+ */
+
+static const ar_vm_handler_t __vm_handlers[AR_VM_OP_COUNT] = {
+	__vm_op_write32,     __vm_op_write16,     __vm_op_write8,
+	__vm_op_if32,        __vm_op_if32,        __vm_op_if32,
+	__vm_op_if32,        __vm_op_if16,        __vm_op_if16,
+	__vm_op_if16,        __vm_op_if16,        __vm_op_load_offset,
+	__vm_op_loop,        __vm_op_counter,     __vm_op_save_offset,
+	__vm_op_end_if,      __vm_op_end_loop,    __vm_op_end_all,
+	__vm_op_set_offset,  __vm_op_add_stored,  __vm_op_set_stored,
+	__vm_op_put32,       __vm_op_put16,       __vm_op_put8,
+	__vm_op_get32,       __vm_op_get16,       __vm_op_get8,
+	__vm_op_add_offset,  __vm_op_patch,       __vm_op_copy,
+	__vm_op_bad
+};
+
+// ----------------------------------------------------------------------------
+// VM Functions                                                            {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * vm_decode
+ *
+ * Decodes "num" lines of a cheat into "prog". The lines holding an E code's
+ * data are moved into the data pool, and don't become instructions. Returns
+ * AR_VM_OK, or AR_VM_TRUNCATED (and nothing to free) if an E code needs more
+ * lines than there are.
+ */
+
+int vm_decode(ar_vm_prog_t *prog, const ar_line_t *lines, size_t num) {
+	ar_vm_insn_t *in;
+	uint32_t      l, r, type;
+	size_t        i, n;
+
+	prog->insns   = (ar_vm_insn_t *) malloc((num + 1) * sizeof(ar_vm_insn_t));
+	prog->data    = (uint8_t *) malloc(num * sizeof(ar_line_t) + 1);
+	prog->num     = 0;
+	prog->data_sz = 0;
+
+	for (i = 0; i < num; i++) {
+		l  = lines[i].memory_location;
+		r  = lines[i].value;
+		in = &prog->insns[prog->num++];
+
+		in->op    = AR_VM_BAD;
+		in->flags = 0;
+		in->line  = i;
+		in->addr  = l & 0x0FFFFFFF;
+		in->value = r;
+		in->extra = 0;
+
+		type = l >> 28;
+
+		switch (type) {
+			case 0x0: in->op = AR_VM_WRITE32;                   break;
+			case 0x1: in->op = AR_VM_WRITE16; in->value &= 0xFFFF; break;
+			case 0x2: in->op = AR_VM_WRITE8;  in->value &= 0xFF;   break;
+
+			case 0x3:
+			case 0x4:
+			case 0x5:
+			case 0x6:
+				in->op    = AR_VM_IF32_GT + (type - 0x3);
+				in->flags = AR_VM_FLOW;
+				break;
+
+			case 0x7:
+			case 0x8:
+			case 0x9:
+			case 0xA:
+				in->op    = AR_VM_IF16_GT + (type - 0x7);
+				in->flags = AR_VM_FLOW;
+				in->value = r & 0xFFFF;
+				in->extra = ~(r >> 16) & 0xFFFF;
+				break;
+
+			case 0xB:
+				in->op = AR_VM_LOAD_OFFSET;
+				break;
+
+			case 0xC:
+				switch (l >> 24) {
+					case 0xC0: in->op = AR_VM_LOOP;        break;
+					case 0xC6: in->op = AR_VM_SAVE_OFFSET; break;
+
+					case 0xC5:
+						in->op    = AR_VM_COUNTER;
+						in->flags = AR_VM_FLOW;
+						in->addr  = r >> 16;
+						in->extra = r & 0xFFFF;
+						break;
+				}
+
+				break;
+
+			case 0xD:
+				// D0 - DC line up with AR_VM_END_IF onwards
+				if ((l >> 24) <= 0xDC)
+					in->op = AR_VM_END_IF + ((l >> 24) - 0xD0);
+
+				if ((l >> 24) <= 0xD2)
+					in->flags = AR_VM_FLOW;
+
+				break;
+
+			case 0xE:
+				// Data follows in the next lines, 8 bytes per line
+				n = r / 8 + (r % 8 != 0);
+
+				if (n > num - i - 1) {
+					vm_prog_free(prog);
+					return AR_VM_TRUNCATED;
+				}
+
+				in->op    = AR_VM_PATCH;
+				in->extra = prog->data_sz;
+
+				memcpy(&prog->data[prog->data_sz], &lines[i + 1], n * 8);
+				prog->data_sz += n * 8;
+				i             += n;
+				break;
+
+			case 0xF:
+				in->op = AR_VM_COPY;
+				break;
+		}
+	}
+
+	return AR_VM_OK;
+}
+
+/*
+ * vm_prog_free
+ */
+
+void vm_prog_free(ar_vm_prog_t *prog) {
+	free(prog->insns);
+	free(prog->data);
+
+	prog->insns = NULL;
+	prog->data  = NULL;
+	prog->num   = 0;
+}
+
+/*
+ * vm_init
+ *
+ * Sets up "vm" to run against a copy of the "size" byte RAM image at
+ * "image". "size" has to be a multiple of the page size.
+ */
+
+void vm_init(ar_vm_t *vm, const uint8_t *image, uint32_t size) {
+	uint32_t pages;
+
+	memset(vm, 0, sizeof(ar_vm_t));
+
+	pages = size >> VM_PAGE_SHIFT;
+
+	vm->ram_sz     = size;
+	vm->ram        = (uint8_t *) malloc(size);
+	vm->base       = (uint8_t *) malloc(size);
+	vm->dirty      = (uint8_t *) calloc(pages, 1);
+	vm->dirty_list = (uint32_t *) malloc(pages * sizeof(uint32_t));
+	vm->max_steps  = VM_MAX_STEPS;
+
+	memcpy(vm->ram, image, size);
+	memcpy(vm->base, image, size);
+}
+
+/*
+ * vm_run
+ *
+ * Runs "prog" once, like the ARDS does every frame. Registers start at 0,
+ * but RAM and the C5 counter carry over from the last run. Returns AR_VM_OK,
+ * or why it stopped early.
+ */
+
+int vm_run(ar_vm_t *vm, const ar_vm_prog_t *prog) {
+	const ar_vm_insn_t *in;
+	size_t              steps;
+	int                 status;
+
+	vm->offset      = 0;
+	vm->stored      = 0;
+	vm->status      = 0;
+	vm->loop_active = 0;
+	vm->pc          = 0;
+	vm->data        = prog->data;
+
+	for (
+		steps = 0, status = AR_VM_OK;
+		vm->pc < prog->num && status == AR_VM_OK;
+		steps++
+	) {
+		if (steps == vm->max_steps) {
+			status = AR_VM_STEP_LIMIT;
+			break;
+		}
+
+		in = &prog->insns[vm->pc++];
+
+		// Skipped, unless it changes the execution status
+		if (vm->status != 0 && !(in->flags & AR_VM_FLOW))
+			continue;
+
+		status = __vm_handlers[in->op](vm, in);
+	}
+
+	vm->steps += steps;
+
+	return status;
+}
+
+/*
+ * vm_reset
+ *
+ * Puts back every page written to since the last reset, and clears the C5
+ * counter and statistics, ready for the next cheat.
+ */
+
+void vm_reset(ar_vm_t *vm) {
+	uint32_t i, page;
+
+	for (i = 0; i < vm->dirty_num; i++) {
+		page = vm->dirty_list[i];
+
+		memcpy(
+			vm->ram  + (page << VM_PAGE_SHIFT),
+			vm->base + (page << VM_PAGE_SHIFT),
+			1 << VM_PAGE_SHIFT
+		);
+
+		vm->dirty[page] = 0;
+	}
+
+	vm->dirty_num = 0;
+	vm->counter   = 0;
+	vm->steps     = 0;
+	vm->writes    = 0;
+	vm->faults    = 0;
+}
+
+/*
+ * vm_free
+ */
+
+void vm_free(ar_vm_t *vm) {
+	free(vm->ram);
+	free(vm->base);
+	free(vm->dirty);
+	free(vm->dirty_list);
+}
+
+/*
+ * vm_strerror
+ */
+
+const char *vm_strerror(int status) {
+	switch (status) {
+		case AR_VM_OK:
+			return "Success";
+
+		case AR_VM_BAD_CODE:
+			return "Unsupported code type";
+
+		case AR_VM_TRUNCATED:
+			return "E code is missing data lines";
+
+		case AR_VM_STEP_LIMIT:
+			return "Ran too long (endless loop?)";
+	}
+
+	return "Unknown error";
+}
@@ -0,0 +1,205 @@
+/*
+ * ARDS Utils - VM
+ *
+ * Description:
+ *     Provides an interpreter for Action Replay DS codes, run against an
+ *     image of the NDS's main RAM (0x02000000) instead of a real DS. Every
+ *     code type the ARDS engine has is supported except for C4, which needs
+ *     the code list to be in memory.
+ *
+ *     A cheat's lines are decoded once into an array of ar_vm_insn_t. Each
+ *     one holds an AR_VM_* op and its operands, already pulled apart, and
+ *     the data of E codes is moved to a separate pool. Running it is then a
+ *     loop over that array, calling each instruction's handler through a
+ *     table indexed by its op.
+ *
+ *     Like the ARDS, conditional codes push onto an execution status, one
+ *     bit per level. Codes only run while it's 0. While it isn't, only the
+ *     codes that change it (marked AR_VM_FLOW) are looked at. D0 pops a
+ *     level. D1 and D2 repeat a C0 loop until its count runs out, putting
+ *     the execution status back to how it was at the C0 each time. Once it
+ *     runs out (or there wasn't one), D2 clears everything.
+ *
+ *     Word and halfword accesses are aligned down, like the ARM9's. Accesses
+ *     outside of RAM don't happen, and are counted as faults. Reads of them
+ *     give 0.
+ *
+ *     Every page of RAM that gets written to is remembered, so that only
+ *     those pages have to be copied back to run the next cheat on a clean
+ *     image.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_VM__
+#define __ARDS_UTILS_VM__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "io.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// VM Data Structs                                                         {{{1
+// ----------------------------------------------------------------------------
+
+#define VM_RAM_START  0x02000000
+#define VM_RAM_SZ     0x00400000 // 4 MiB
+#define VM_PAGE_SHIFT 12         // 4 KiB pages for undoing writes
+#define VM_MAX_STEPS  0x00100000 // Default instructions per run
+
+/*
+ * AR_VM_OP_T
+ *
+ * What a decoded instruction does. The comments are the codes they come
+ * from.
+ */
+
+typedef enum AR_VM_OP_T {
+	AR_VM_WRITE32 = 0,  // 0XXXXXXX YYYYYYYY
+	AR_VM_WRITE16,      // 1XXXXXXX 0000YYYY
+	AR_VM_WRITE8,       // 2XXXXXXX 000000YY
+	AR_VM_IF32_GT,      // 3XXXXXXX YYYYYYYY  Y >  word[X]
+	AR_VM_IF32_LT,      // 4XXXXXXX YYYYYYYY  Y <  word[X]
+	AR_VM_IF32_EQ,      // 5XXXXXXX YYYYYYYY  Y == word[X]
+	AR_VM_IF32_NE,      // 6XXXXXXX YYYYYYYY  Y != word[X]
+	AR_VM_IF16_GT,      // 7XXXXXXX ZZZZYYYY  Y >  (~Z & half[X])
+	AR_VM_IF16_LT,      // 8XXXXXXX ZZZZYYYY  Y <  (~Z & half[X])
+	AR_VM_IF16_EQ,      // 9XXXXXXX ZZZZYYYY  Y == (~Z & half[X])
+	AR_VM_IF16_NE,      // AXXXXXXX ZZZZYYYY  Y != (~Z & half[X])
+	AR_VM_LOAD_OFFSET,  // BXXXXXXX 00000000  offset = word[X + offset]
+	AR_VM_LOOP,         // C0000000 YYYYYYYY  Repeat Y more times
+	AR_VM_COUNTER,      // C5000000 XXXXYYYY  If (++counter & Y) == X
+	AR_VM_SAVE_OFFSET,  // C6000000 XXXXXXXX  word[X] = offset
+	AR_VM_END_IF,       // D0000000 00000000
+	AR_VM_END_LOOP,     // D1000000 00000000
+	AR_VM_END_ALL,      // D2000000 00000000
+	AR_VM_SET_OFFSET,   // D3000000 XXXXXXXX  offset = X
+	AR_VM_ADD_STORED,   // D4000000 XXXXXXXX  stored += X
+	AR_VM_SET_STORED,   // D5000000 XXXXXXXX  stored = X
+	AR_VM_PUT32,        // D6000000 XXXXXXXX  word[X + offset] = stored
+	AR_VM_PUT16,        // D7000000 XXXXXXXX  half[X + offset] = stored
+	AR_VM_PUT8,         // D8000000 XXXXXXXX  byte[X + offset] = stored
+	AR_VM_GET32,        // D9000000 XXXXXXXX  stored = word[X + offset]
+	AR_VM_GET16,        // DA000000 XXXXXXXX  stored = half[X + offset]
+	AR_VM_GET8,         // DB000000 XXXXXXXX  stored = byte[X + offset]
+	AR_VM_ADD_OFFSET,   // DC000000 XXXXXXXX  offset += X
+	AR_VM_PATCH,        // EXXXXXXX YYYYYYYY  Y bytes of data to X + offset
+	AR_VM_COPY,         // FXXXXXXX YYYYYYYY  Y bytes from offset to X
+	AR_VM_BAD,          // Anything else
+	AR_VM_OP_COUNT
+} ar_vm_op_t;
+
+// Instruction flags
+#define AR_VM_FLOW 0x01 // Looked at even while the execution status isn't 0
+
+/*
+ * AR_VM_INSN_T
+ *
+ * A single decoded code line. "extra" is the mask of 16-bit conditionals,
+ * and where the data of a patch starts in the data pool.
+ */
+
+typedef struct AR_VM_INSN_T {
+	uint8_t  op;    // AR_VM_*
+	uint8_t  flags; // AR_VM_FLOW
+	uint16_t line;  // Line of the cheat it came from
+	uint32_t addr;  // X
+	uint32_t value; // Y
+	uint32_t extra;
+} ar_vm_insn_t;
+
+/*
+ * AR_VM_PROG_T
+ *
+ * A decoded cheat.
+ */
+
+typedef struct AR_VM_PROG_T {
+	ar_vm_insn_t *insns;
+	size_t        num;
+	uint8_t      *data;    // Data of every E code, back to back
+	size_t        data_sz;
+} ar_vm_prog_t;
+
+/*
+ * AR_VM_T
+ *
+ * The state of the ARDS engine, and the RAM it runs against. "base" is the
+ * clean image that "ram" is reset to.
+ */
+
+typedef struct AR_VM_T {
+	uint8_t  *ram;
+	uint8_t  *base;
+	uint32_t  ram_sz;
+
+	// Registers
+	uint32_t  offset;
+	uint32_t  stored;
+	uint32_t  status;      // Execution status. Codes only run while 0.
+	uint32_t  counter;     // C5
+	size_t    pc;          // Next instruction
+	uint8_t  *data;        // Data pool of the program being run
+
+	// C0 loop
+	uint8_t   loop_active;
+	size_t    loop_pc;     // First instruction of the loop
+	uint32_t  loop_count;  // Repeats left
+	uint32_t  loop_status; // Execution status at the C0
+
+	// Pages written to since the last reset
+	uint8_t  *dirty;
+	uint32_t *dirty_list;
+	uint32_t  dirty_num;
+
+	// Statistics
+	size_t    max_steps;
+	size_t    steps;       // Instructions looked at
+	size_t    writes;      // Bytes written
+	size_t    faults;      // Accesses outside of RAM
+} ar_vm_t;
+
+/*
+ * AR_VM_STATUS_T
+ */
+
+typedef enum AR_VM_STATUS_T {
+	AR_VM_OK = 0,
+	AR_VM_BAD_CODE,   // Code type that isn't supported
+	AR_VM_TRUNCATED,  // E code with fewer data lines than it needs
+	AR_VM_STEP_LIMIT  // Ran for more than "max_steps" instructions
+} ar_vm_status_t;
+
+typedef int (*ar_vm_handler_t)(ar_vm_t *, const ar_vm_insn_t *);
+
+// ----------------------------------------------------------------------------
+// Function Prototypes                                                     {{{1
+// ----------------------------------------------------------------------------
+
+// Internal
+uint8_t  *__vm_map   (ar_vm_t *, uint32_t, uint32_t);
+uint32_t  __vm_read  (ar_vm_t *, uint32_t, uint32_t);
+void      __vm_write (ar_vm_t *, uint32_t, uint32_t, uint32_t);
+uint32_t  __vm_span  (uint32_t, uint32_t);
+void      __vm_push  (ar_vm_t *, int);
+int       __vm_repeat(ar_vm_t *);
+
+// VM Functions
+int         vm_decode   (ar_vm_prog_t *, const ar_line_t *, size_t);
+void        vm_prog_free(ar_vm_prog_t *);
+void        vm_init     (ar_vm_t *, const uint8_t *, uint32_t);
+int         vm_run      (ar_vm_t *, const ar_vm_prog_t *);
+void        vm_reset    (ar_vm_t *);
+void        vm_free     (ar_vm_t *);
+const char *vm_strerror (int);
+
+#endif
@@ -0,0 +1,787 @@
+/*
+ * xml.c
+ */
+
+#include "xml.h"
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * __xml_fill                                                              {{{2
+ *
+ * Refills the read buffer if everything in it has been consumed. Returns 0 if
+ * there is nothing left to read.
+ */
+
+int __xml_fill(ar_xml_reader_t *r) {
+	if (r->pos < r->len)
+		return 1;
+
+	r->len = fread(r->buf, sizeof(char), AR_XML_BUF_SZ, r->fp);
+	r->pos = 0;
+
+	return r->len != 0;
+}
+
+/*
+ * __xml_peek / __xml_getc                                                 {{{2
+ *
+ * Returns the next character without/with consuming it. EOF if at the end.
+ */
+
+int __xml_peek(ar_xml_reader_t *r) {
+	if (!__xml_fill(r))
+		return EOF;
+
+	return (unsigned char) r->buf[r->pos];
+}
+
+int __xml_getc(ar_xml_reader_t *r) {
+	int c;
+
+	if (!__xml_fill(r))
+		return EOF;
+
+	c = (unsigned char) r->buf[r->pos++];
+
+	if (c == '\n')
+		r->line++;
+
+	return c;
+}
+
+/*
+ * __xml_append                                                            {{{2
+ *
+ * Appends "len" bytes of "str" to the reader's text buffer, growing it if it
+ * has to. The buffer is always kept null-terminated.
+ */
+
+void __xml_append(ar_xml_reader_t *r, const char *str, size_t len) {
+	if (r->text_len + len + 1 > r->text_cap) {
+		while (r->text_len + len + 1 > r->text_cap)
+			r->text_cap = (r->text_cap == 0) ? 256 : r->text_cap * 2;
+
+		r->text = (char *) realloc(r->text, r->text_cap);
+	}
+
+	memcpy(&r->text[r->text_len], str, len);
+	r->text_len += len;
+	r->text[r->text_len] = 0;
+}
+
+/*
+ * __xml_entity                                                            {{{2
+ *
+ * Given the name of an entity (without the "&" and ";"), store the character
+ * it stands for in "cp". Returns 0 if it isn't a known entity.
+ */
+
+int __xml_entity(const char *ent, uint32_t *cp) {
+	char *end;
+
+	if (ent[0] == '#') {
+		// Numeric character reference
+		if (ent[1] == 'x' || ent[1] == 'X')
+			*cp = strtoul(&ent[2], &end, 16);
+		else
+			*cp = strtoul(&ent[1], &end, 10);
+
+		return end != &ent[1] && *end == 0 && *cp > 0 && *cp <= 0x10FFFF;
+	}
+
+	if (strcmp(ent, "amp" ) == 0) { *cp = '&';  return 1; }
+	if (strcmp(ent, "lt"  ) == 0) { *cp = '<';  return 1; }
+	if (strcmp(ent, "gt"  ) == 0) { *cp = '>';  return 1; }
+	if (strcmp(ent, "quot") == 0) { *cp = '"';  return 1; }
+	if (strcmp(ent, "apos") == 0) { *cp = '\''; return 1; }
+
+	return 0;
+}
+
+/*
+ * __xml_next_tag                                                          {{{2
+ *
+ * Skips ahead to the next tag and reads it. The tag's name goes in "r->tag".
+ * Attributes are skipped. So are "<?...?>", "<!...>" and comments.
+ */
+
+ar_xml_tag_t __xml_next_tag(ar_xml_reader_t *r) {
+	ar_xml_tag_t type;
+	int          c, prev, quote;
+	size_t       n;
+
+	while (1) {
+		// Skip any text up to the next tag
+		do {
+			c = __xml_getc(r);
+
+			if (c == EOF)
+				return AR_XML_EOF;
+		}
+		while (c != '<');
+
+		c = __xml_peek(r);
+
+		if (c != '?' && c != '!')
+			break;
+
+		__xml_getc(r);
+
+		// Comments end with "-->". Everything else here ends with ">".
+		if (c == '!' && __xml_peek(r) == '-') {
+			for (n = 0; (c = __xml_getc(r)) != '>' || n < 2; ) {
+				if (c == EOF)
+					return AR_XML_ERROR;
+
+				n = (c == '-') ? n + 1 : 0;
+			}
+		}
+		else {
+			while ((c = __xml_getc(r)) != '>') {
+				if (c == EOF)
+					return AR_XML_ERROR;
+			}
+		}
+	}
+
+	// Opening or closing?
+	type = AR_XML_OPEN;
+
+	if (c == '/') {
+		__xml_getc(r);
+		type = AR_XML_CLOSE;
+	}
+
+	// Tag name. Anything too long is truncated and won't match the schema.
+	n = 0;
+
+	while (1) {
+		c = __xml_peek(r);
+
+		if (
+			c == EOF || c == '>' || c == '/' ||
+			c == ' ' || c == '\t' || c == '\r' || c == '\n'
+		)
+			break;
+
+		if (n < AR_XML_TAG_SZ - 1)
+			r->tag[n++] = c;
+
+		__xml_getc(r);
+	}
+
+	r->tag[n] = 0;
+
+	if (n == 0)
+		return AR_XML_ERROR;
+
+	// Skip attributes. "/>" means there is no closing tag.
+	prev  = 0;
+	quote = 0;
+
+	while ((c = __xml_getc(r)) != '>' || quote) {
+		if (c == EOF)
+			return AR_XML_ERROR;
+
+		if (quote && c == quote)
+			quote = 0;
+		else
+		if (!quote && (c == '"' || c == '\''))
+			quote = c;
+
+		prev = c;
+	}
+
+	if (prev == '/' && type == AR_XML_OPEN)
+		type = AR_XML_EMPTY;
+
+	return type;
+}
+
+/*
+ * __xml_read_text                                                         {{{2
+ *
+ * Reads the text of the element "tag", which was just opened, along with its
+ * closing tag. Entities are decoded. A "&" that isn't part of a known entity
+ * is kept as-is, since the XML export doesn't escape anything. Returns the
+ * text, which is only valid until the next read, or NULL on error.
+ */
+
+char *__xml_read_text(ar_xml_reader_t *r, const char *tag) {
+	char     ent[12], utf8[4];
+	uint32_t cp;
+	size_t   start, n;
+	int      c;
+
+	r->text_len = 0;
+	__xml_append(r, "", 0);
+
+	while (1) {
+		if (!__xml_fill(r))
+			return NULL;
+
+		// Copy everything up to the next "<" or "&" straight out of the buffer
+		start = r->pos;
+
+		while (r->pos < r->len) {
+			c = r->buf[r->pos];
+
+			if (c == '<' || c == '&')
+				break;
+
+			if (c == '\n')
+				r->line++;
+
+			r->pos++;
+		}
+
+		__xml_append(r, &r->buf[start], r->pos - start);
+
+		if (r->pos == r->len)
+			continue;
+
+		if (c == '<')
+			break;
+
+		// Entity. Read up to the ";", but give up on anything unreasonable.
+		__xml_getc(r);
+
+		for (n = 0; n < sizeof(ent) - 1; n++) {
+			c = __xml_peek(r);
+
+			if (
+				c == EOF || c == ';' || c == '<' || c == '&' ||
+				c == ' ' || c == '\t' || c == '\r' || c == '\n'
+			)
+				break;
+
+			ent[n] = __xml_getc(r);
+		}
+
+		ent[n] = 0;
+
+		if (c == ';' && __xml_entity(ent, &cp)) {
+			__xml_getc(r);
+
+			// Store as UTF-8
+			if (cp < 0x80) {
+				utf8[0] = cp;
+				n = 1;
+			}
+			else
+			if (cp < 0x800) {
+				utf8[0] = 0xC0 | (cp >> 6);
+				utf8[1] = 0x80 | (cp & 0x3F);
+				n = 2;
+			}
+			else
+			if (cp < 0x10000) {
+				utf8[0] = 0xE0 | (cp >> 12);
+				utf8[1] = 0x80 | ((cp >> 6) & 0x3F);
+				utf8[2] = 0x80 | (cp & 0x3F);
+				n = 3;
+			}
+			else {
+				utf8[0] = 0xF0 | (cp >> 18);
+				utf8[1] = 0x80 | ((cp >> 12) & 0x3F);
+				utf8[2] = 0x80 | ((cp >> 6) & 0x3F);
+				utf8[3] = 0x80 | (cp & 0x3F);
+				n = 4;
+			}
+
+			__xml_append(r, utf8, n);
+		}
+		else {
+			__xml_append(r, "&", 1);
+			__xml_append(r, ent, n);
+		}
+	}
+
+	// Text elements can't have children. The next tag must close this one.
+	if (__xml_next_tag(r) != AR_XML_CLOSE || strcmp(r->tag, tag) != 0)
+		return NULL;
+
+	return r->text;
+}
+
+/*
+ * __xml_skip_element                                                      {{{2
+ *
+ * Skips past the closing tag of the element that was just opened, along with
+ * everything inside of it. Returns 0 on success.
+ */
+
+int __xml_skip_element(ar_xml_reader_t *r) {
+	size_t depth;
+
+	for (depth = 1; depth > 0; ) {
+		switch (__xml_next_tag(r)) {
+			case AR_XML_OPEN : depth++; break;
+			case AR_XML_CLOSE: depth--; break;
+			case AR_XML_EMPTY:          break;
+
+			case AR_XML_EOF:
+			case AR_XML_ERROR:
+			default:
+				return 1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * __xml_parse_hex                                                         {{{2
+ *
+ * Parses "len" hex digits of "str" into "out" via a lookup table. Returns 0 on
+ * success, or 1 if it isn't a 32-bit hex number.
+ */
+
+int __xml_parse_hex(const char *str, size_t len, uint32_t *out) {
+	static const int8_t hextable[256] = {
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		 0,  1,  2,  3,  4,  5,  6,  7,  8,  9, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, 10, 11, 12, 13, 14, 15, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1,
+		-1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1, -1
+	};
+
+	uint32_t v;
+	int8_t   d;
+	size_t   i;
+
+	if (len == 0 || len > 8)
+		return 1;
+
+	for (v = 0, i = 0; i < len; i++) {
+		d = hextable[(uint8_t) str[i]];
+
+		if (d < 0)
+			return 1;
+
+		v = (v << 4) | d;
+	}
+
+	*out = v;
+	return 0;
+}
+
+/*
+ * __xml_read_codes                                                        {{{2
+ *
+ * Reads the contents of "<codes>". These are "master", "on" or "always_on",
+ * followed by pairs of hex words. Returns 0 on success.
+ */
+
+int __xml_read_codes(ar_xml_reader_t *r, ar_data_t *cheat) {
+	ar_line_t  line;
+	uint32_t   word;
+	uint8_t    half;
+	char      *p, *tok;
+	size_t     len;
+
+	p = __xml_read_text(r, "codes");
+
+	if (p == NULL)
+		return 1;
+
+	half = 0;
+
+	while (1) {
+		// Find the next token
+		while (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+			p++;
+
+		if (*p == 0)
+			break;
+
+		for (tok = p; *p != 0; p++)
+			if (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\n')
+				break;
+
+		len = p - tok;
+
+		// Flags the XML export puts in front of the code hex
+		if (len == 6 && memcmp(tok, "master", 6) == 0)
+			cheat->flag |= AR_FLAG_MASTER;
+		else
+		if (len == 2 && memcmp(tok, "on", 2) == 0)
+			cheat->flag |= AR_FLAG_ON_DEFAULT;
+		else
+		if (len == 9 && memcmp(tok, "always_on", 9) == 0)
+			cheat->flag |= AR_FLAG_ON_DEFAULT | AR_FLAG_ON_ALWAYS;
+		else {
+			if (__xml_parse_hex(tok, len, &word) != 0)
+				return 1;
+
+			// Left side, then right side
+			if (half == 0)
+				line.memory_location = word;
+			else {
+				line.value = word;
+				cn_vec_push_back(cheat->data, &line);
+			}
+
+			half ^= 1;
+		}
+	}
+
+	// A code without a right side is no code at all
+	return half != 0;
+}
+
+/*
+ * __xml_read_entry                                                        {{{2
+ *
+ * A "<cheat>" or "<folder>" was just opened. Adds an entry for it to "root"
+ * and reads it in. Returns 0 on success. On failure, the entry is left in
+ * "root" so it gets cleaned up along with everything else.
+ */
+
+int __xml_read_entry(ar_xml_reader_t *r, CN_VEC root) {
+	ar_data_t  tmp_data;
+	ar_data_t *entry;
+	int        status;
+
+	tmp_data.name        = NULL;
+	tmp_data.desc        = NULL;
+	tmp_data.num_entries = 0;
+
+	if (strcmp(r->tag, "cheat") == 0) {
+		tmp_data.flag = AR_FLAG_CODE;
+		tmp_data.data = cn_vec_init(ar_line_t);
+	}
+	else {
+		tmp_data.flag = AR_FLAG_FOLDER;
+		tmp_data.data = cn_vec_init(ar_data_t);
+	}
+
+	// Add to vector and get a pointer
+	cn_vec_push_back(root, &tmp_data);
+	entry = cn_vec_at(root, cn_vec_size(root) - 1);
+
+	if ((entry->flag & 0x03) == AR_FLAG_CODE)
+		status = __xml_read_cheat(r, entry);
+	else
+		status = __xml_read_folder(r, entry);
+
+	// Everything in the library has a name and description, even if blank
+	if (entry->name == NULL) entry->name = strdup("");
+	if (entry->desc == NULL) entry->desc = strdup("");
+
+	entry->num_entries = cn_vec_size(entry->data);
+
+	return status;
+}
+
+/*
+ * __xml_read_cheat                                                        {{{2
+ *
+ * Reads everything up to and including "</cheat>". Returns 0 on success.
+ */
+
+int __xml_read_cheat(ar_xml_reader_t *r, ar_data_t *cheat) {
+	char *text;
+
+	while (1) {
+		switch (__xml_next_tag(r)) {
+			case AR_XML_OPEN:
+				if (strcmp(r->tag, "name") == 0) {
+					if ((text = __xml_read_text(r, "name")) == NULL)
+						return 1;
+
+					free(cheat->name);
+					cheat->name = strdup(text);
+				}
+				else
+				if (strcmp(r->tag, "note") == 0) {
+					if ((text = __xml_read_text(r, "note")) == NULL)
+						return 1;
+
+					free(cheat->desc);
+					cheat->desc = strdup(text);
+				}
+				else
+				if (strcmp(r->tag, "codes") == 0) {
+					if (__xml_read_codes(r, cheat) != 0)
+						return 1;
+				}
+				else
+				if (__xml_skip_element(r) != 0)
+					return 1;
+
+				break;
+
+			case AR_XML_CLOSE:
+				return strcmp(r->tag, "cheat") != 0;
+
+			case AR_XML_EMPTY:
+				break;
+
+			case AR_XML_EOF:
+			case AR_XML_ERROR:
+			default:
+				return 1;
+		}
+	}
+}
+
+/*
+ * __xml_read_folder                                                       {{{2
+ *
+ * Reads everything up to and including "</folder>". Returns 0 on success.
+ */
+
+int __xml_read_folder(ar_xml_reader_t *r, ar_data_t *folder) {
+	char *text;
+
+	while (1) {
+		switch (__xml_next_tag(r)) {
+			case AR_XML_OPEN:
+				if (strcmp(r->tag, "name") == 0) {
+					if ((text = __xml_read_text(r, "name")) == NULL)
+						return 1;
+
+					free(folder->name);
+					folder->name = strdup(text);
+				}
+				else
+				if (strcmp(r->tag, "note") == 0) {
+					if ((text = __xml_read_text(r, "note")) == NULL)
+						return 1;
+
+					free(folder->desc);
+					folder->desc = strdup(text);
+				}
+				else
+				if (strcmp(r->tag, "allowedon") == 0) {
+					if ((text = __xml_read_text(r, "allowedon")) == NULL)
+						return 1;
+
+					// Radio Button Folder (only 1 code allowed on at once)
+					if (atoi(text) == 1)
+						folder->flag |= AR_FLAG_ONLYONE;
+				}
+				else
+				if (
+					strcmp(r->tag, "cheat" ) == 0 ||
+					strcmp(r->tag, "folder") == 0
+				) {
+					if (__xml_read_entry(r, folder->data) != 0)
+						return 1;
+				}
+				else
+				if (__xml_skip_element(r) != 0)
+					return 1;
+
+				break;
+
+			case AR_XML_CLOSE:
+				if (strcmp(r->tag, "folder") != 0)
+					return 1;
+
+				library_reverse(folder->data);
+				return 0;
+
+			case AR_XML_EMPTY:
+				break;
+
+			case AR_XML_EOF:
+			case AR_XML_ERROR:
+			default:
+				return 1;
+		}
+	}
+}
+
+/*
+ * __xml_read_game                                                         {{{2
+ *
+ * Reads everything up to and including "</game>". Returns 0 on success.
+ */
+
+int __xml_read_game(ar_xml_reader_t *r, ARDS_GAME game) {
+	char     *text;
+	unsigned  y, mo, d, h, mi;
+
+	while (1) {
+		switch (__xml_next_tag(r)) {
+			case AR_XML_OPEN:
+				if (strcmp(r->tag, "name") == 0) {
+					if ((text = __xml_read_text(r, "name")) == NULL)
+						return 1;
+
+					free(game->name);
+					game->name = strdup(text);
+				}
+				else
+				if (strcmp(r->tag, "gameid") == 0) {
+					if ((text = __xml_read_text(r, "gameid")) == NULL)
+						return 1;
+
+					// "XXXX YYYYYYYY"
+					if (
+						strlen(text) != 13 || text[4] != ' ' ||
+						__xml_parse_hex(&text[5], 8, &game->header.N_CRC32)
+					)
+						return 1;
+
+					memcpy(game->header.ID, text, 4);
+				}
+				else
+				if (strcmp(r->tag, "date") == 0) {
+					if ((text = __xml_read_text(r, "date")) == NULL)
+						return 1;
+
+					// "YYYY/MM/DD HH:MM" back into DOS date and time
+					if (
+						sscanf(text, "%u/%u/%u %u:%u", &y, &mo, &d, &h, &mi)
+						== 5 && y >= 1980
+					) {
+						game->header.wDosDate =
+							((y - 1980) << 9) | (mo << 5) | d;
+						game->header.wDosTime = (h << 11) | (mi << 5);
+					}
+				}
+				else
+				if (
+					strcmp(r->tag, "cheat" ) == 0 ||
+					strcmp(r->tag, "folder") == 0
+				) {
+					if (__xml_read_entry(r, game->library) != 0)
+						return 1;
+				}
+				else
+				if (__xml_skip_element(r) != 0)
+					return 1;
+
+				break;
+
+			case AR_XML_CLOSE:
+				if (strcmp(r->tag, "game") != 0)
+					return 1;
+
+				library_reverse(game->library);
+				return 0;
+
+			case AR_XML_EMPTY:
+				break;
+
+			case AR_XML_EOF:
+			case AR_XML_ERROR:
+			default:
+				return 1;
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ARDS Input Functions                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * ards_game_import_from_xml                                               {{{2
+ *
+ * Reads an XML codelist from "fp" and returns a vector<ARDS_GAME> of every
+ * game in it. Games are built the same way "ards_game_read" builds them, so
+ * they can be exported to any format, including the ARDS byte format.
+ *
+ * On malformed input, NULL is returned and the line the parser stopped at is
+ * stored in "err_line".
+ */
+
+CN_VEC ards_game_import_from_xml(FILE *fp, size_t *err_line) {
+	ar_xml_reader_t *r;
+	CN_VEC           games;
+	ARDS_GAME        game, *it;
+	int              status;
+
+	// Setup reader
+	r = (ar_xml_reader_t *) malloc(sizeof(ar_xml_reader_t));
+
+	r->fp       = fp;
+	r->pos      = 0;
+	r->len      = 0;
+	r->line     = 1;
+	r->text     = NULL;
+	r->text_len = 0;
+	r->text_cap = 0;
+
+	games  = cn_vec_init(ARDS_GAME);
+	status = 0;
+
+	// "<codelist>" is walked into. Every "<game>" in it is read.
+	while (status == 0) {
+		switch (__xml_next_tag(r)) {
+			case AR_XML_OPEN:
+				if (strcmp(r->tag, "codelist") == 0)
+					break;
+
+				if (strcmp(r->tag, "game") != 0) {
+					status = __xml_skip_element(r);
+					break;
+				}
+
+				// Same defaults as a game read from a ROM
+				game = ards_game_init();
+				memset(&game->header, 0, sizeof(ar_game_info_t));
+
+				game->header.magic = 0x001C0001;
+				game->header.nx20  = 0x0020;
+				game->library      = cn_vec_init(ar_data_t);
+
+				cn_vec_push_back(games, &game);
+				status = __xml_read_game(r, game);
+
+				if (game->name == NULL) game->name = strdup("");
+				if (game->desc == NULL) game->desc = strdup("");
+
+				game->header.num_codes = library_count_codes(game->library);
+				break;
+
+			case AR_XML_CLOSE:
+			case AR_XML_EMPTY:
+				break;
+
+			case AR_XML_EOF:
+				status = -1;
+				break;
+
+			case AR_XML_ERROR:
+			default:
+				status = 1;
+				break;
+		}
+	}
+
+	// Bail out
+	if (status > 0) {
+		*err_line = r->line;
+
+		cn_vec_traverse(games, it)
+			ards_game_free(*it);
+
+		cn_vec_free(games);
+		games = NULL;
+	}
+
+	// Clean up
+	free(r->text);
+	free(r);
+
+	return games;
+}
@@ -0,0 +1,96 @@
+/*
+ * ARDS Utils - XML
+ *
+ * Description:
+ *     Provides importing of XML codelists, as written by
+ *     "ards_game_export_as_xml", back into ar_game_t objects.
+ *
+ *     The parser reads the file through a fixed-size buffer and only keeps
+ *     one element's text in memory at a time, so codelists of any size can be
+ *     imported. It is not a general XML parser. It knows the codelist schema,
+ *     skips anything else, and does not support CDATA or DTDs.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#ifndef __ARDS_UTILS_XML__
+#define __ARDS_UTILS_XML__
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+// ARDS Utils
+#include "io.h"
+
+// CNDS
+#include "../CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// XML Data Structs                                                        {{{1
+// ----------------------------------------------------------------------------
+
+#define AR_XML_BUF_SZ 0x10000
+#define AR_XML_TAG_SZ 32
+
+/*
+ * AR_XML_TAG_T
+ *
+ * What "__xml_next_tag" found.
+ */
+
+typedef enum AR_XML_TAG_T {
+	AR_XML_ERROR = -1, // Malformed input
+	AR_XML_EOF   =  0, // Nothing left to read
+	AR_XML_OPEN  =  1, // <tag>
+	AR_XML_CLOSE =  2, // </tag>
+	AR_XML_EMPTY =  3  // <tag/>
+} ar_xml_tag_t;
+
+/*
+ * AR_XML_READER_T
+ *
+ * Buffered reader state. "text" is reused for the contents of every element,
+ * so reading text doesn't allocate once it has grown large enough.
+ */
+
+typedef struct AR_XML_READER_T {
+	FILE   *fp;                  // File being read
+	size_t  pos, len;            // Position and valid bytes in "buf"
+	size_t  line;                // Current line, for error reporting
+	char   *text;                // Text of the last element read
+	size_t  text_len, text_cap;  // Length and capacity of "text"
+	char    tag[AR_XML_TAG_SZ];  // Name of the last tag read
+	char    buf[AR_XML_BUF_SZ];  // Read buffer
+} ar_xml_reader_t;
+
+// ----------------------------------------------------------------------------
+// Internal Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+int          __xml_fill        (ar_xml_reader_t *);
+int          __xml_peek        (ar_xml_reader_t *);
+int          __xml_getc        (ar_xml_reader_t *);
+void         __xml_append      (ar_xml_reader_t *, const char *, size_t);
+int          __xml_entity      (const char *, uint32_t *);
+ar_xml_tag_t __xml_next_tag    (ar_xml_reader_t *);
+char        *__xml_read_text   (ar_xml_reader_t *, const char *);
+int          __xml_skip_element(ar_xml_reader_t *);
+int          __xml_parse_hex   (const char *, size_t, uint32_t *);
+
+int __xml_read_codes (ar_xml_reader_t *, ar_data_t *);
+int __xml_read_entry (ar_xml_reader_t *, CN_VEC);
+int __xml_read_cheat (ar_xml_reader_t *, ar_data_t *);
+int __xml_read_folder(ar_xml_reader_t *, ar_data_t *);
+int __xml_read_game  (ar_xml_reader_t *, ARDS_GAME);
+
+// ----------------------------------------------------------------------------
+// ARDS Input Functions                                                    {{{1
+// ----------------------------------------------------------------------------
+
+CN_VEC ards_game_import_from_xml(FILE *, size_t *);
+
+#endif
@@ -0,0 +1,387 @@
+/*
+ * ARDS Code Conflicts
+ *
+ * Description:
+ *     Given an Action Replay DS ROM dump, find the cheats of each game that
+ *     write to the same addresses. When several of them are on at once,
+ *     they silently fight over those bytes. See
+ *     "lib/ards_util/conflict.h" for how the writes are worked out.
+ *
+ *     Every game in the dump's game list (at 0x00044000) is checked, or just
+ *     the ones at the hex positions given. Games are read first, then
+ *     checked on several threads, and reported in order.
+ *
+ *     Conflicts between cheats in the same folder that only allows one of
+ *     them on are expected, and are marked as such.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <time.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/conflict.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// Exit statuses
+#define CF_EXIT_OK    0
+#define CF_EXIT_USAGE 1
+#define CF_EXIT_READ  2
+
+/*
+ * POOL_T
+ *
+ * Every game to check, and the worker pool state for checking them.
+ */
+
+typedef struct POOL_T {
+	ar_conflict_game_t *jobs;
+	size_t              num;
+	size_t              next; // Next game to hand out
+	pthread_mutex_t     lock; // Protects "next"
+} pool_t;
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t   flag_unexpected;
+	size_t    threads;
+	char    **paths;
+	size_t    num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-hx] [-j THREADS] IN_ARDS.nds [IN_POS_HEX1 [...]]\n",
+		argv[0]
+	);
+
+	printf("Finds cheats of each game in an Action Replay DS ROM dump that "
+		"write to the\nsame addresses.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-j\tThreads to check games with. Defaults to the number of "
+		"CPUs.\n\n");
+
+	printf("\t-x\tOnly print conflicts that aren't expected. Cheats in a "
+		"folder that only\n\t\tallows one on at a time are expected to "
+		"conflict.\n\n");
+
+	exit(CF_EXIT_OK);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int   i, j, len;
+	char *val;
+
+	// Defaults
+	obj->flag_unexpected = 0;
+	obj->threads         = 0;
+	obj->paths           = (char **) malloc(argc * sizeof(char *));
+	obj->num_paths       = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Arguments without a "-" are the dump and positions
+		if (argv[i][0] != '-') {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'x':
+					// Leave out expected conflicts
+					obj->flag_unexpected = 1;
+					break;
+
+				case 'j':
+					// Threads. Either "-j4" or "-j 4".
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						obj->threads = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+
+	if (obj->threads == 0)
+		obj->threads = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * read_positions
+ *
+ * Adds the position of every game in the game list at 0x00044000 to
+ * "positions". The list ends at "FF FF FF FF".
+ */
+
+void read_positions(FILE *fp, CN_VEC positions) {
+	ar_game_list_node node;
+	uint32_t          pos;
+
+	fseek(fp, 0x44000, SEEK_SET);
+
+	while (fread(&node, sizeof(ar_game_list_node), 1, fp) == 1) {
+		if (node.magic == 0xFFFFFFFFU)
+			break;
+
+		// Anything other than "00 00 00 00" = not a game
+		if (node.magic != 0x00000000U)
+			continue;
+
+		pos = 0x40000 + (node.location << 8);
+		cn_vec_push_back(positions, &pos);
+	}
+}
+
+/*
+ * pool_worker
+ *
+ * Takes games from the pool until there are none left.
+ */
+
+void *pool_worker(void *arg) {
+	pool_t *pool = (pool_t *) arg;
+	size_t  i;
+
+	while (1) {
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->num)
+			break;
+
+		conflict_find(&pool->jobs[i]);
+	}
+
+	return NULL;
+}
+
+/*
+ * print_game
+ *
+ * Prints the conflicts found in a game, if there are any to print. Returns
+ * how many were printed.
+ */
+
+size_t print_game(ar_conflict_game_t *cg, args_t *args) {
+	ar_conflict_t  *it;
+	ar_cheat_ref_t *cheats;
+	size_t          num, shown;
+
+	num   = cn_vec_size(cg->conflicts);
+	shown = args->flag_unexpected ? num - cg->expected : num;
+
+	if (shown == 0)
+		return 0;
+
+	printf(
+		"%.4s-%08X - %s: %lu cheats, %lu conflicts (%lu expected), "
+		"%u unplaced writes\n",
+		cg->game->header.ID,
+		cg->game->header.N_CRC32,
+		(cg->game->name != NULL) ? cg->game->name : "",
+		(unsigned long) cn_vec_size(cg->cheats),
+		(unsigned long) num,
+		(unsigned long) cg->expected,
+		cg->dynamic
+	);
+
+	cheats = cn_vec_array(cg->cheats, ar_cheat_ref_t);
+
+	cn_vec_traverse(cg->conflicts, it) {
+		if (args->flag_unexpected && it->expected)
+			continue;
+
+		printf(
+			"\t0x%08X - 0x%08X (%u overlap%s)%s\t%s <-> %s\n",
+			it->start,
+			it->end,
+			it->overlaps,
+			(it->overlaps == 1) ? "" : "s",
+			it->expected ? " [expected]" : "",
+			cheats[it->a].path,
+			cheats[it->b].path
+		);
+	}
+
+	return shown;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t     args;
+	pool_t     pool;
+	pthread_t *tids;
+	CN_VEC     positions;
+	ARDS_GAME  game;
+	FILE      *fp;
+	uint32_t   pos, *it;
+	size_t     i, n, shown, expected;
+	double     start;
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (args.num_paths < 1) {
+		fprintf(
+			stderr,
+			"usage: %s [-hx] [-j THREADS] IN_ARDS.nds [IN_POS_HEX1 [...]]\n",
+			argv[0]
+		);
+
+		free(args.paths);
+		return CF_EXIT_USAGE;
+	}
+
+	fp = fopen(args.paths[0], "rb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			args.paths[0],
+			strerror(errno)
+		);
+
+		free(args.paths);
+		return CF_EXIT_READ;
+	}
+
+	start = now();
+
+	// Positions given, or every game in the list
+	positions = cn_vec_init(uint32_t);
+
+	if (args.num_paths > 1) {
+		for (i = 1; i < args.num_paths; i++) {
+			sscanf(args.paths[i], "%x", &pos);
+			cn_vec_push_back(positions, &pos);
+		}
+	}
+	else
+		read_positions(fp, positions);
+
+	// Read every game first. The file can't be shared between threads.
+	pool.num  = cn_vec_size(positions);
+	pool.next = 0;
+	pool.jobs = (ar_conflict_game_t *) malloc(
+		(pool.num + 1) * sizeof(ar_conflict_game_t)
+	);
+
+	i = 0;
+	cn_vec_traverse(positions, it) {
+		game = ards_game_init();
+		ards_game_read(game, fp, *it);
+		conflict_init(&pool.jobs[i++], game);
+	}
+
+	fclose(fp);
+	cn_vec_free(positions);
+
+	// Check them all
+	n = (args.threads < pool.num) ? args.threads : pool.num;
+
+	if (n > 0) {
+		tids = (pthread_t *) malloc(n * sizeof(pthread_t));
+		pthread_mutex_init(&pool.lock, NULL);
+
+		for (i = 0; i < n; i++)
+			pthread_create(&tids[i], NULL, pool_worker, &pool);
+
+		for (i = 0; i < n; i++)
+			pthread_join(tids[i], NULL);
+
+		pthread_mutex_destroy(&pool.lock);
+		free(tids);
+	}
+
+	// Report, in order
+	shown    = 0;
+	expected = 0;
+
+	for (i = 0; i < pool.num; i++) {
+		shown    += print_game(&pool.jobs[i], &args);
+		expected += pool.jobs[i].expected;
+	}
+
+	fprintf(
+		stderr,
+		"%lu games, %lu conflicts printed (%lu expected overall) in %.3f "
+		"seconds\n",
+		(unsigned long) pool.num,
+		(unsigned long) shown,
+		(unsigned long) expected,
+		now() - start
+	);
+
+	// Clean up
+	for (i = 0; i < pool.num; i++) {
+		game = pool.jobs[i].game;
+		conflict_free(&pool.jobs[i]);
+		ards_game_free(game);
+	}
+
+	free(pool.jobs);
+	free(args.paths);
+
+	return CF_EXIT_OK;
+}
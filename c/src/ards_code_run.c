@@ -0,0 +1,609 @@
+/*
+ * ARDS Code Runner
+ *
+ * Description:
+ *     Runs Action Replay DS codes against an image of the NDS's main RAM
+ *     (a 4 MiB dump of 0x02000000), and reports what they did. See
+ *     "lib/ards_util/vm.h" for the interpreter.
+ *
+ *     Given only the RAM image, a single cheat is read from stdin, one
+ *     "XXXXXXXX YYYYYYYY" line at a time. With "-o", the RAM after running
+ *     it is written out.
+ *
+ *     Given an Action Replay DS ROM dump and game positions as well, every
+ *     cheat of every game is run in batch, each against a clean copy of the
+ *     RAM image. Only pages a cheat wrote to are put back between cheats, so
+ *     thousands can be run a second.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/vm.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+#define NAME_SZ 1024 // Longest "Folder/Cheat" name printed
+
+// Exit statuses
+#define RUN_EXIT_OK    0
+#define RUN_EXIT_USAGE 1
+#define RUN_EXIT_READ  2
+#define RUN_EXIT_FAIL  3
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t   flag_verbose;
+	size_t    frames;
+	size_t    max_steps;
+	char     *out;
+	char    **paths;
+	size_t    num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-hv] [-f FRAMES] [-s MAX_STEPS] [-o OUT_RAM.bin] RAM.bin "
+		"< CHEAT.txt\n"
+		"       %s [-hv] [-f FRAMES] [-s MAX_STEPS] RAM.bin IN_ARDS.nds "
+		"IN_POS_HEX1\n"
+		"       [IN_POS_HEX2 [...]]\n",
+		argv[0],
+		argv[0]
+	);
+
+	printf("Runs Action Replay DS codes against a dump of the NDS's main "
+		"RAM.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-f\tFrames to run each cheat for. RAM and the C5 counter carry "
+		"over\n\t\tbetween frames. Defaults to 1.\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-o\tWhere to write the RAM after running the cheat on stdin."
+		"\n\n");
+
+	printf("\t-s\tInstructions a cheat can run per frame before it's "
+		"stopped. Defaults\n\t\tto %u.\n\n", VM_MAX_STEPS);
+
+	printf("\t-v\tAlso print every range of RAM each cheat changed.\n\n");
+
+	printf("Exit status is 0 if every cheat ran, 2 if a file couldn't be "
+		"read or written,\nand 3 if any cheat had an unsupported code, a "
+		"missing E code line, or didn't\nfinish.\n");
+
+	exit(RUN_EXIT_OK);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int     i, j, len;
+	char   *val, flag;
+	size_t *dst;
+
+	// Defaults
+	obj->flag_verbose = 0;
+	obj->frames       = 1;
+	obj->max_steps    = VM_MAX_STEPS;
+	obj->out          = NULL;
+	obj->paths        = (char **) malloc(argc * sizeof(char *));
+	obj->num_paths    = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Arguments without a "-" are filenames and positions
+		if (argv[i][0] != '-') {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			flag = argv[i][j];
+
+			switch (flag) {
+				case 'v':
+					// Print changed ranges of RAM
+					obj->flag_verbose = 1;
+					break;
+
+				case 'o':
+					// Output path. Either "-oOUT" or "-o OUT".
+					if (j + 1 < len)
+						obj->out = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						obj->out = argv[++i];
+
+					j = len;
+					break;
+
+				case 'f':
+				case 's':
+					// Numbers. Either "-f60" or "-f 60".
+					dst = (flag == 'f') ? &obj->frames : &obj->max_steps;
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						*dst = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct TOTALS_T {
+	size_t cheats;
+	size_t failed;
+	size_t steps;
+	size_t writes;
+	size_t faults;
+} totals_t;
+
+double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * load_ram
+ *
+ * Reads the RAM image at "path" into a new buffer. It has to be a whole
+ * number of pages, and no bigger than the 16 MiB that RAM is mirrored over.
+ * Returns NULL, after reporting why, if it can't be used.
+ */
+
+uint8_t *load_ram(const char *path, uint32_t *size) {
+	FILE    *fp;
+	uint8_t *buf;
+	long     sz;
+
+	fp = fopen(path, "rb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			path,
+			strerror(errno)
+		);
+
+		return NULL;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if (
+		sz <= 0 || sz > 0x01000000 ||
+		sz % (1 << VM_PAGE_SHIFT) != 0
+	) {
+		fprintf(
+			stderr,
+			"Error: \"%s\" (%ld bytes) is not a RAM image. Expected %u "
+			"bytes.\n",
+			path,
+			sz,
+			VM_RAM_SZ
+		);
+
+		fclose(fp);
+		return NULL;
+	}
+
+	buf = (uint8_t *) malloc(sz);
+
+	if (fread(buf, 1, sz, fp) != (size_t) sz) {
+		fprintf(stderr, "Error: Failed to read \"%s\"\n", path);
+		free(buf);
+		fclose(fp);
+		return NULL;
+	}
+
+	fclose(fp);
+
+	*size = sz;
+	return buf;
+}
+
+/*
+ * cmp_page
+ */
+
+int cmp_page(const void *a, const void *b) {
+	uint32_t x = *(const uint32_t *) a,
+	         y = *(const uint32_t *) b;
+
+	return (x > y) - (x < y);
+}
+
+/*
+ * print_changes
+ *
+ * Prints every range of bytes that differs from the clean image, looking
+ * only at pages that were written to. Ranges carry on over page boundaries.
+ */
+
+void print_changes(ar_vm_t *vm) {
+	uint32_t *pages, i, off, end, start;
+	uint8_t   open;
+
+	pages = (uint32_t *) malloc((vm->dirty_num + 1) * sizeof(uint32_t));
+	memcpy(pages, vm->dirty_list, vm->dirty_num * sizeof(uint32_t));
+	qsort(pages, vm->dirty_num, sizeof(uint32_t), cmp_page);
+
+	open  = 0;
+	start = 0;
+
+	for (i = 0; i < vm->dirty_num; i++) {
+		off = pages[i] << VM_PAGE_SHIFT;
+		end = off + (1 << VM_PAGE_SHIFT);
+
+		for (; off < end; off++) {
+			if (vm->ram[off] != vm->base[off]) {
+				if (!open) {
+					open  = 1;
+					start = off;
+				}
+
+				continue;
+			}
+
+			if (open) {
+				open = 0;
+				printf(
+					"\t0x%08X - 0x%08X (%u bytes)\n",
+					VM_RAM_START + start,
+					VM_RAM_START + off - 1,
+					off - start
+				);
+			}
+		}
+
+		// Close the run if the next page isn't right after this one
+		if (open && (i + 1 == vm->dirty_num || pages[i + 1] != pages[i] + 1)) {
+			open = 0;
+			printf(
+				"\t0x%08X - 0x%08X (%u bytes)\n",
+				VM_RAM_START + start,
+				VM_RAM_START + end - 1,
+				end - start
+			);
+		}
+	}
+
+	free(pages);
+}
+
+/*
+ * run_cheat
+ *
+ * Runs the "num" lines of a cheat against a clean image for every frame,
+ * and prints how it went. Returns an AR_VM_* status.
+ */
+
+int run_cheat(
+	ar_vm_t         *vm,
+	args_t          *args,
+	totals_t        *totals,
+	const char      *id,
+	const char      *name,
+	const ar_line_t *lines,
+	size_t           num
+) {
+	ar_vm_prog_t prog;
+	size_t       f;
+	int          status;
+
+	vm_reset(vm);
+
+	status = vm_decode(&prog, lines, num);
+
+	if (status == AR_VM_OK) {
+		for (f = 0; f < args->frames && status == AR_VM_OK; f++)
+			status = vm_run(vm, &prog);
+
+		vm_prog_free(&prog);
+	}
+
+	printf(
+		"%s\t%5lu\t%8lu\t%7lu\t%6lu\t%s\t%s\n",
+		id,
+		(unsigned long) num,
+		(unsigned long) vm->steps,
+		(unsigned long) vm->writes,
+		(unsigned long) vm->faults,
+		(status == AR_VM_OK) ? "OK" : vm_strerror(status),
+		name
+	);
+
+	if (args->flag_verbose)
+		print_changes(vm);
+
+	totals->cheats++;
+	totals->failed += (status != AR_VM_OK);
+	totals->steps  += vm->steps;
+	totals->writes += vm->writes;
+	totals->faults += vm->faults;
+
+	return status;
+}
+
+/*
+ * run_library
+ *
+ * Runs every cheat in "root" in the order the ARDS shows them, going into
+ * folders. "name" is the path of folders so far, of length "len".
+ */
+
+void run_library(
+	ar_vm_t    *vm,
+	args_t     *args,
+	totals_t   *totals,
+	const char *id,
+	CN_VEC      root,
+	char       *name,
+	size_t      len
+) {
+	ar_data_t *it;
+
+	cn_vec_rtraverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		snprintf(
+			&name[len],
+			NAME_SZ - len,
+			"%s%s",
+			(len > 0) ? "/" : "",
+			(it->name != NULL) ? it->name : ""
+		);
+
+		switch (it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				run_cheat(
+					vm,
+					args,
+					totals,
+					id,
+					name,
+					cn_vec_array(it->data, ar_line_t),
+					cn_vec_size(it->data)
+				);
+
+				break;
+
+			case AR_FLAG_FOLDER:
+				run_library(
+					vm, args, totals, id, it->data, name, strlen(name)
+				);
+
+				break;
+		}
+
+		name[len] = '\0';
+	}
+}
+
+/*
+ * read_stdin
+ *
+ * Reads "XXXXXXXX YYYYYYYY" lines from stdin into "lines". Blank lines are
+ * skipped, and anything else is warned about.
+ */
+
+void read_stdin(CN_VEC lines) {
+	char      buf[256], *p;
+	ar_line_t line;
+	size_t    n;
+
+	n = 0;
+
+	while (fgets(buf, sizeof(buf), stdin) != NULL) {
+		n++;
+
+		for (p = buf; *p == ' ' || *p == '\t'; p++);
+
+		if (*p == '\n' || *p == '\r' || *p == '\0')
+			continue;
+
+		if (sscanf(p, "%x %x", &line.memory_location, &line.value) != 2) {
+			fprintf(stderr, "WARN: Line %lu is not a code. Ignoring...\n", n);
+			continue;
+		}
+
+		cn_vec_push_back(lines, &line);
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t     args;
+	ar_vm_t    vm;
+	totals_t   totals;
+	ARDS_GAME  game;
+	CN_VEC     lines;
+	FILE      *fp;
+	uint8_t   *image;
+	uint32_t   size, pos_hex;
+	size_t     i;
+	char       id[32], name[NAME_SZ];
+	double     start;
+	int        ret;
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (args.num_paths != 1 && args.num_paths < 3) {
+		fprintf(
+			stderr,
+			"usage: %s [-hv] [-f FRAMES] [-s MAX_STEPS] [-o OUT_RAM.bin] "
+			"RAM.bin\n"
+			"       [IN_ARDS.nds IN_POS_HEX1 [IN_POS_HEX2 [...]]]\n",
+			argv[0]
+		);
+
+		free(args.paths);
+		return RUN_EXIT_USAGE;
+	}
+
+	image = load_ram(args.paths[0], &size);
+
+	if (image == NULL) {
+		free(args.paths);
+		return RUN_EXIT_READ;
+	}
+
+	vm_init(&vm, image, size);
+	vm.max_steps = args.max_steps;
+	free(image);
+
+	memset(&totals, 0, sizeof(totals_t));
+	ret   = RUN_EXIT_OK;
+	start = now();
+
+	printf("ID\t\tLINES\t   STEPS\t WRITES\tFAULTS\tSTATUS\tNAME\n");
+
+	if (args.num_paths == 1) {
+		// A single cheat from stdin
+		lines = cn_vec_init(ar_line_t);
+		read_stdin(lines);
+
+		run_cheat(
+			&vm,
+			&args,
+			&totals,
+			"stdin",
+			"",
+			cn_vec_array(lines, ar_line_t),
+			cn_vec_size(lines)
+		);
+
+		cn_vec_free(lines);
+
+		if (args.out != NULL) {
+			fp = fopen(args.out, "wb");
+
+			if (!fp || fwrite(vm.ram, 1, vm.ram_sz, fp) != vm.ram_sz) {
+				fprintf(
+					stderr,
+					"Error: Failed to write \"%s\": %s\n",
+					args.out,
+					strerror(errno)
+				);
+
+				ret = RUN_EXIT_READ;
+			}
+
+			if (fp)
+				fclose(fp);
+		}
+	}
+	else {
+		// Every cheat of every game given
+		fp = fopen(args.paths[1], "rb");
+
+		if (!fp) {
+			fprintf(
+				stderr,
+				"Error: Failed to open \"%s\": %s\n",
+				args.paths[1],
+				strerror(errno)
+			);
+
+			vm_free(&vm);
+			free(args.paths);
+			return RUN_EXIT_READ;
+		}
+
+		for (i = 2; i < args.num_paths; i++) {
+			sscanf(args.paths[i], "%x", &pos_hex);
+
+			game = ards_game_init();
+			ards_game_read(game, fp, pos_hex);
+
+			sprintf(
+				id,
+				"%.4s-%08X",
+				game->header.ID,
+				game->header.N_CRC32
+			);
+
+			name[0] = '\0';
+			run_library(&vm, &args, &totals, id, game->library, name, 0);
+
+			ards_game_free(game);
+		}
+
+		fclose(fp);
+	}
+
+	// Totals, and how quick it was
+	fprintf(
+		stderr,
+		"%lu cheats (%lu failed), %lu steps, %lu bytes written, %lu faults "
+		"in %.3f seconds\n",
+		(unsigned long) totals.cheats,
+		(unsigned long) totals.failed,
+		(unsigned long) totals.steps,
+		(unsigned long) totals.writes,
+		(unsigned long) totals.faults,
+		now() - start
+	);
+
+	vm_free(&vm);
+	free(args.paths);
+
+	if (ret == RUN_EXIT_OK && totals.failed > 0)
+		ret = RUN_EXIT_FAIL;
+
+	return ret;
+}
@@ -0,0 +1,541 @@
+/*
+ * ARDS Code Search
+ *
+ * Description:
+ *     Finds the address in RAM that holds a value, to make new codes with.
+ *     Works like the code finder on the Action Replay itself, but over
+ *     snapshots of the NDS's main RAM (4 MiB dumps of 0x02000000) taken as
+ *     the value changes in game. See "lib/ards_util/search.h".
+ *
+ *     Snapshots are given in the order they were taken, with an operator
+ *     before each one saying how the value changed since the last:
+ *
+ *         eq, ne, gt, lt    Compared to the previous snapshot. "same",
+ *                           "changed", "inc" and "dec" work too.
+ *         eq=V, ne=V, ...   Compared to the value V (decimal, or hex with
+ *                           "0x"). This can also go before the first one.
+ *
+ *     Each address still left is written out as a code that writes its
+ *     value in the last snapshot, as a codelist in the same XML format that
+ *     "ards_game_to_xml" exports.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/search.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+#define RAM_START   0x02000000
+#define RAM_MAX_SZ  0x01000000 // RAM is mirrored up to 0x02FFFFFF
+#define LIMIT       256        // Default number of codes written
+
+// Exit statuses
+#define SEARCH_EXIT_OK    0
+#define SEARCH_EXIT_USAGE 1
+#define SEARCH_EXIT_READ  2
+
+/*
+ * OP_T
+ *
+ * Operator names, and how they compare.
+ */
+
+typedef struct OP_T {
+	const char *name;
+	int         cmp;
+} op_t;
+
+const op_t ops[] = {
+	{ "eq"     , AR_SEARCH_EQ },
+	{ "ne"     , AR_SEARCH_NE },
+	{ "gt"     , AR_SEARCH_GT },
+	{ "lt"     , AR_SEARCH_LT },
+	{ "same"   , AR_SEARCH_EQ },
+	{ "changed", AR_SEARCH_NE },
+	{ "inc"    , AR_SEARCH_GT },
+	{ "dec"    , AR_SEARCH_LT },
+	{ NULL     , 0            }
+};
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	size_t    width;
+	size_t    limit;
+	char     *game_id;
+	char     *name;
+	char     *out;
+	char    **tokens;
+	size_t    num_tokens;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-h] [-w BITS] [-l LIMIT] [-g GAME_ID] [-n NAME] "
+		"[-o OUT.xml]\n"
+		"       [OP] SNAP1.bin OP SNAP2.bin [OP SNAP3.bin [...]]\n",
+		argv[0]
+	);
+
+	printf("Finds addresses in NDS RAM snapshots that changed the way given "
+		"by each OP.\n\n");
+
+	printf("OP is one of \"eq\", \"ne\", \"gt\" or \"lt\" to compare to the "
+		"previous snapshot,\nor \"eq=V\", \"ne=V\", \"gt=V\" or \"lt=V\" to "
+		"compare to a value V. \"same\",\n\"changed\", \"inc\" and \"dec\" "
+		"can be used too.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-g\tGame ID to put in the XML, as \"ABCD-12345678\".\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-l\tMost codes to write. 0 writes every address left. "
+		"Defaults to %d.\n\n", LIMIT);
+
+	printf("\t-n\tGame name to put in the XML.\n\n");
+
+	printf("\t-o\tWhere to write the XML. Defaults to stdout.\n\n");
+
+	printf("\t-w\tSize of the value in bits. 8, 16 or 32. Defaults to "
+		"32.\n\n");
+
+	exit(SEARCH_EXIT_OK);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int     i, j, len;
+	char   *val, flag, **str;
+	size_t *dst;
+
+	// Defaults
+	obj->width      = 32;
+	obj->limit      = LIMIT;
+	obj->game_id    = NULL;
+	obj->name       = NULL;
+	obj->out        = NULL;
+	obj->tokens     = (char **) malloc(argc * sizeof(char *));
+	obj->num_tokens = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Arguments without a "-" are snapshots and operators
+		if (argv[i][0] != '-') {
+			obj->tokens[obj->num_tokens++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			flag = argv[i][j];
+
+			switch (flag) {
+				case 'g':
+				case 'n':
+				case 'o':
+					// Strings. Either "-oOUT" or "-o OUT".
+					str = (flag == 'g') ? &obj->game_id
+						: (flag == 'n') ? &obj->name
+						: &obj->out;
+
+					if (j + 1 < len)
+						*str = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						*str = argv[++i];
+
+					j = len;
+					break;
+
+				case 'w':
+				case 'l':
+					// Numbers. Either "-w16" or "-w 16".
+					dst = (flag == 'w') ? &obj->width : &obj->limit;
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						*dst = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * parse_op
+ *
+ * If "token" is an operator, sets "cmp", and "value" if it has one, and
+ * returns 1 for one compared to the previous snapshot, or 2 for one compared
+ * to a value. Returns 0 if it isn't an operator.
+ */
+
+int parse_op(const char *token, int *cmp, uint64_t *value) {
+	const op_t *op;
+	const char *eq;
+	size_t      len;
+
+	eq  = strchr(token, '=');
+	len = (eq != NULL) ? (size_t) (eq - token) : strlen(token);
+
+	for (op = ops; op->name != NULL; op++) {
+		if (strlen(op->name) != len || strncmp(op->name, token, len) != 0)
+			continue;
+
+		*cmp = op->cmp;
+
+		if (eq == NULL)
+			return 1;
+
+		*value = strtoull(eq + 1, NULL, 0);
+		return 2;
+	}
+
+	return 0;
+}
+
+/*
+ * load_snapshot
+ *
+ * Reads the RAM snapshot at "path" into "buf", which is "size" bytes, or
+ * sets "size" if it is 0. Returns 0, or -1 after reporting why it couldn't.
+ */
+
+int load_snapshot(const char *path, uint8_t **buf, uint32_t *size) {
+	FILE *fp;
+	long  sz;
+
+	fp = fopen(path, "rb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			path,
+			strerror(errno)
+		);
+
+		return -1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	if (sz <= 0 || sz > RAM_MAX_SZ || (*size != 0 && sz != *size)) {
+		fprintf(
+			stderr,
+			"Error: \"%s\" is %ld bytes. Snapshots should all be the same "
+			"size, up to %u bytes.\n",
+			path,
+			sz,
+			RAM_MAX_SZ
+		);
+
+		fclose(fp);
+		return -1;
+	}
+
+	if (*size == 0) {
+		*size = sz;
+		*buf  = (uint8_t *) malloc(sz);
+	}
+
+	if (fread(*buf, 1, sz, fp) != (size_t) sz) {
+		fprintf(stderr, "Error: Failed to read \"%s\"\n", path);
+		fclose(fp);
+		return -1;
+	}
+
+	fclose(fp);
+	return 0;
+}
+
+/*
+ * make_game
+ *
+ * Makes a game with a code for each of the first "limit" candidates left,
+ * writing their values in "ram".
+ */
+
+ARDS_GAME make_game(ar_search_t *s, const uint8_t *ram, args_t *args) {
+	ARDS_GAME  game;
+	ar_data_t  cheat;
+	ar_line_t  line;
+	size_t     slot, n;
+	uint32_t   off, type;
+	char       buf[16];
+
+	// Same defaults as a game read from a ROM
+	game = ards_game_init();
+	memset(&game->header, 0, sizeof(ar_game_info_t));
+
+	game->header.magic = 0x001C0001;
+	game->header.nx20  = 0x0020;
+	game->library      = cn_vec_init(ar_data_t);
+	game->name         = strdup((args->name != NULL) ? args->name : "");
+	game->desc         = strdup("");
+
+	memcpy(game->header.ID, "????", 4);
+
+	if (args->game_id != NULL) {
+		// Shorter IDs are padded with NULs, like strncpy would
+		n = strlen(args->game_id);
+		memset(game->header.ID, 0, 4);
+		memcpy(game->header.ID, args->game_id, (n < 4) ? n : 4);
+
+		if (strlen(args->game_id) > 5)
+			sscanf(&args->game_id[5], "%x", &game->header.N_CRC32);
+	}
+
+	// 0XXXXXXX, 1XXXXXXX or 2XXXXXXX writes
+	type = (s->width == 4) ? 0x0 : (s->width == 2) ? 0x1 : 0x2;
+
+	for (
+		slot = search_next(s, 0), n = 0;
+		slot < s->slots && (args->limit == 0 || n < args->limit);
+		slot = search_next(s, slot + 1), n++
+	) {
+		off = slot * s->width;
+
+		line.memory_location = (type << 28) | (RAM_START + off);
+		line.value           = __search_load(ram + off, s->width);
+
+		sprintf(buf, "0x%08X", RAM_START + off);
+
+		cheat.flag        = AR_FLAG_CODE;
+		cheat.num_entries = 1;
+		cheat.name        = strdup(buf);
+		cheat.desc        = strdup("");
+		cheat.data        = cn_vec_init(ar_line_t);
+
+		cn_vec_push_back(cheat.data, &line);
+		cn_vec_push_back(game->library, &cheat);
+	}
+
+	// Libraries are stored back to front
+	library_reverse(game->library);
+	game->header.num_codes = library_count_codes(game->library);
+
+	return game;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t       args;
+	ar_search_t  search;
+	ARDS_GAME    game;
+	CN_VEC       games;
+	FILE        *out;
+	uint8_t     *cur, *prev, *tmp;
+	uint32_t     size;
+	uint64_t     value;
+	size_t       i, snaps;
+	int          kind, cmp, ret;
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (
+		args.num_tokens < 1 ||
+		(args.width != 8 && args.width != 16 && args.width != 32)
+	) {
+		fprintf(
+			stderr,
+			"usage: %s [-h] [-w BITS] [-l LIMIT] [-g GAME_ID] [-n NAME] "
+			"[-o OUT.xml]\n"
+			"       [OP] SNAP1.bin OP SNAP2.bin [OP SNAP3.bin [...]]\n",
+			argv[0]
+		);
+
+		free(args.tokens);
+		return SEARCH_EXIT_USAGE;
+	}
+
+	cur   = NULL;
+	prev  = NULL;
+	size  = 0;
+	snaps = 0;
+	kind  = 0;
+	cmp   = 0;
+	value = 0;
+	ret   = SEARCH_EXIT_OK;
+
+	// Go through the snapshots, filtering with the operator before each
+	for (i = 0; i < args.num_tokens && ret == SEARCH_EXIT_OK; i++) {
+		if (kind == 0 && (kind = parse_op(args.tokens[i], &cmp, &value)) != 0) {
+			// A value that doesn't fit in "width" bits can't be there
+			if (kind == 2 && (value >> args.width) != 0) {
+				fprintf(
+					stderr,
+					"Error: \"%s\" doesn't fit in %lu bits\n",
+					args.tokens[i],
+					(unsigned long) args.width
+				);
+
+				ret = SEARCH_EXIT_USAGE;
+				break;
+			}
+
+			continue;
+		}
+
+		if (snaps > 0 && kind == 0) {
+			fprintf(
+				stderr,
+				"Error: No operator was given before \"%s\"\n",
+				args.tokens[i]
+			);
+
+			ret = SEARCH_EXIT_USAGE;
+			break;
+		}
+
+		if (snaps == 0 && kind == 1) {
+			fprintf(
+				stderr,
+				"Error: \"%s\" is the first snapshot. There's nothing to "
+				"compare it to.\n",
+				args.tokens[i]
+			);
+
+			ret = SEARCH_EXIT_USAGE;
+			break;
+		}
+
+		// Keep the previous snapshot around to compare to
+		tmp  = prev;
+		prev = cur;
+		cur  = tmp;
+
+		if (cur == NULL && snaps > 0)
+			cur = (uint8_t *) malloc(size);
+
+		if (load_snapshot(args.tokens[i], &cur, &size) != 0) {
+			ret = SEARCH_EXIT_READ;
+			break;
+		}
+
+		if (snaps == 0)
+			search_init(&search, size, args.width / 8);
+
+		if (kind != 0) {
+			search_filter(
+				&search, cur, (kind == 1) ? prev : NULL, cmp, (uint32_t) value
+			);
+
+			fprintf(
+				stderr,
+				"%s: %s: %lu candidates left\n",
+				args.tokens[i],
+				args.tokens[i - 1],
+				(unsigned long) search.count
+			);
+		}
+
+		snaps++;
+		kind = 0;
+	}
+
+	if (ret == SEARCH_EXIT_OK && kind != 0) {
+		fprintf(
+			stderr,
+			"Error: No snapshot was given after \"%s\"\n",
+			args.tokens[args.num_tokens - 1]
+		);
+
+		ret = SEARCH_EXIT_USAGE;
+	}
+
+	// Write what's left as codes
+	if (ret == SEARCH_EXIT_OK) {
+		out = (args.out != NULL) ? fopen(args.out, "w") : stdout;
+
+		if (!out) {
+			fprintf(
+				stderr,
+				"Error: Failed to open \"%s\": %s\n",
+				args.out,
+				strerror(errno)
+			);
+
+			ret = SEARCH_EXIT_READ;
+		}
+		else {
+			if (args.limit != 0 && search.count > args.limit) {
+				fprintf(
+					stderr,
+					"WARN: Only the first %lu of %lu addresses were written. "
+					"Use \"-l 0\" to write all of them.\n",
+					(unsigned long) args.limit,
+					(unsigned long) search.count
+				);
+			}
+
+			game  = make_game(&search, cur, &args);
+			games = cn_vec_init(ARDS_GAME);
+			cn_vec_push_back(games, &game);
+
+			ards_game_export_as_xml(games, out);
+
+			ards_game_free(game);
+			cn_vec_free(games);
+
+			if (out != stdout)
+				fclose(out);
+		}
+	}
+
+	if (snaps > 0)
+		search_free(&search);
+
+	free(cur);
+	free(prev);
+	free(args.tokens);
+
+	return ret;
+}
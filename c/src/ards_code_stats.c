@@ -0,0 +1,698 @@
+/*
+ * ARDS Code Stats
+ *
+ * Description:
+ *     Given an Action Replay DS ROM dump, count how often each code type
+ *     is used, which regions of memory codes point at, and how many lines
+ *     cheats have, over every game in the dump's game list (at 0x00044000)
+ *     or just the ones at the hex positions given.
+ *
+ *     Lines are classified by their first nibble, and C and D codes by
+ *     their first byte. Lines holding an E code's data aren't codes, and
+ *     are counted on their own.
+ *
+ *     Games are read first, then counted on several threads. Each thread
+ *     keeps its own totals, which are added up once they're all done.
+ *
+ *     The result is printed as tables, most common first, or with "-m" as
+ *     tab-separated "SCOPE KIND BUCKET COUNT" lines for other tools.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// Histogram sizes
+#define STAT_TYPES   46 // 0 - B, C0 - CF, D0 - DF, E, F
+#define STAT_REGIONS 16 // Top nibble of a code's 28-bit address
+#define STAT_SIZES   10 // 0, 1, 2, 3-4, 5-8, ..., 129+ lines
+
+// Exit statuses
+#define ST_EXIT_OK    0
+#define ST_EXIT_USAGE 1
+#define ST_EXIT_READ  2
+
+/*
+ * STATS_T
+ *
+ * Counts for a single game, a single thread, or everything.
+ */
+
+typedef struct STATS_T {
+	uint64_t types  [STAT_TYPES];   // Lines of each code type
+	uint64_t regions[STAT_REGIONS]; // Lines with an address in each region
+	uint64_t sizes  [STAT_SIZES];   // Cheats with each number of lines
+	uint64_t games;
+	uint64_t folders;
+	uint64_t cheats;
+	uint64_t lines;
+	uint64_t data;                  // Lines holding E code data
+} stats_t;
+
+/*
+ * JOB_T / POOL_T
+ *
+ * A game to count, and every game with the worker pool state for counting
+ * them.
+ */
+
+typedef struct JOB_T {
+	ARDS_GAME game;
+	stats_t   stats;
+} job_t;
+
+typedef struct POOL_T {
+	job_t           *jobs;
+	size_t           num;
+	size_t           next; // Next game to hand out
+	pthread_mutex_t  lock; // Protects "next"
+} pool_t;
+
+typedef struct WORKER_T {
+	pool_t    *pool;
+	stats_t    total; // This thread's own totals
+	pthread_t  tid;
+} worker_t;
+
+// Names of code types, by index. NULL for ones the ARDS doesn't have.
+const char *type_names[STAT_TYPES] = {
+	"0  Write 32",        "1  Write 16",        "2  Write 8",
+	"3  If greater (32)", "4  If less (32)",    "5  If equal (32)",
+	"6  If not equal (32)",
+	"7  If greater (16)", "8  If less (16)",    "9  If equal (16)",
+	"A  If not equal (16)",
+	"B  Load offset",
+
+	"C0 Loop",            NULL,                 NULL,
+	NULL,                 "C4 Code address",    "C5 Counter",
+	"C6 Save offset",     NULL,                 NULL,
+	NULL,                 NULL,                 NULL,
+	NULL,                 NULL,                 NULL,
+	NULL,
+
+	"D0 End if",          "D1 End loop",        "D2 End all",
+	"D3 Set offset",      "D4 Add to stored",   "D5 Set stored",
+	"D6 Put 32",          "D7 Put 16",          "D8 Put 8",
+	"D9 Get 32",          "DA Get 16",          "DB Get 8",
+	"DC Add to offset",   NULL,                 NULL,
+	NULL,
+
+	"E  Patch",           "F  Copy"
+};
+
+// Names of regions of the DS's memory, by the top nibble of the address
+const char *region_names[STAT_REGIONS] = {
+	"0x00 ITCM (or offset)", "0x01 ITCM mirror", "0x02 Main RAM",
+	"0x03 Shared WRAM",      "0x04 I/O",         "0x05 Palettes",
+	"0x06 VRAM",             "0x07 OAM",         "0x08 GBA ROM",
+	"0x09 GBA ROM",          "0x0A GBA RAM",     "0x0B",
+	"0x0C",                  "0x0D",             "0x0E",
+	"0x0F"
+};
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t   flag_games;
+	uint8_t   flag_machine;
+	size_t    threads;
+	char    **paths;
+	size_t    num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-ghm] [-j THREADS] IN_ARDS.nds [IN_POS_HEX1 [...]]\n",
+		argv[0]
+	);
+
+	printf("Counts code types, the memory regions codes point at, and "
+		"cheat sizes in an\nAction Replay DS ROM dump.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-g\tAlso print the counts of every game on its own.\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-j\tThreads to count games with. Defaults to the number of "
+		"CPUs.\n\n");
+
+	printf("\t-m\tPrint machine-readable \"SCOPE KIND BUCKET COUNT\" lines, "
+		"separated by\n\t\ttabs, instead of tables. SCOPE is a game ID, or "
+		"\"ALL\".\n\n");
+
+	exit(ST_EXIT_OK);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int   i, j, len;
+	char *val;
+
+	// Defaults
+	obj->flag_games   = 0;
+	obj->flag_machine = 0;
+	obj->threads      = 0;
+	obj->paths        = (char **) malloc(argc * sizeof(char *));
+	obj->num_paths    = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Arguments without a "-" are the dump and positions
+		if (argv[i][0] != '-') {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'g':
+					// Per-game counts
+					obj->flag_games = 1;
+					break;
+
+				case 'm':
+					// Machine-readable output
+					obj->flag_machine = 1;
+					break;
+
+				case 'j':
+					// Threads. Either "-j4" or "-j 4".
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						obj->threads = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+
+	if (obj->threads == 0)
+		obj->threads = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+// ----------------------------------------------------------------------------
+// Counting Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * type_index
+ *
+ * Which of the STAT_TYPES a line is.
+ */
+
+size_t type_index(uint32_t l) {
+	switch (l >> 28) {
+		case 0xC: return 12 + ((l >> 24) & 0xF);
+		case 0xD: return 28 + ((l >> 24) & 0xF);
+		case 0xE: return 44;
+		case 0xF: return 45;
+	}
+
+	return l >> 28;
+}
+
+/*
+ * size_index
+ *
+ * Which of the STAT_SIZES a cheat of "n" lines is. After 0, 1 and 2, each
+ * one is up to the next power of 2.
+ */
+
+size_t size_index(size_t n) {
+	size_t b;
+
+	if (n == 0)
+		return 0;
+
+	for (b = 1; n > 1 && b < STAT_SIZES - 1; b++)
+		n = (n + 1) / 2;
+
+	return b;
+}
+
+/*
+ * count_cheat
+ *
+ * Counts the "num" lines of a single cheat.
+ */
+
+void count_cheat(stats_t *s, const ar_line_t *lines, size_t num) {
+	uint32_t l, r;
+	size_t   i, data;
+
+	s->cheats++;
+	s->lines += num;
+	s->sizes[size_index(num)]++;
+
+	for (i = 0; i < num; i++) {
+		l = lines[i].memory_location;
+		r = lines[i].value;
+
+		s->types[type_index(l)]++;
+
+		// Codes with an address: 0 - B, E and F
+		if ((l >> 28) < 0xC || (l >> 28) >= 0xE)
+			s->regions[(l >> 24) & 0xF]++;
+
+		// E code data isn't code. Don't count more than there is.
+		if ((l >> 28) == 0xE) {
+			data = r / 8 + (r % 8 != 0);
+
+			if (data > num - i - 1)
+				data = num - i - 1;
+
+			s->data += data;
+			i       += data;
+		}
+	}
+}
+
+/*
+ * count_library
+ *
+ * Counts every cheat and folder in "root".
+ */
+
+void count_library(stats_t *s, CN_VEC root) {
+	ar_data_t *it;
+
+	cn_vec_traverse(root, it) {
+		if (it->data == NULL)
+			continue;
+
+		switch (it->flag & 0x03) {
+			case AR_FLAG_CODE:
+				count_cheat(
+					s,
+					cn_vec_array(it->data, ar_line_t),
+					cn_vec_size(it->data)
+				);
+
+				break;
+
+			case AR_FLAG_FOLDER:
+				s->folders++;
+				count_library(s, it->data);
+				break;
+		}
+	}
+}
+
+/*
+ * stats_add
+ *
+ * Adds every count in "b" to "a".
+ */
+
+void stats_add(stats_t *a, const stats_t *b) {
+	size_t i;
+
+	for (i = 0; i < STAT_TYPES; i++)
+		a->types[i] += b->types[i];
+
+	for (i = 0; i < STAT_REGIONS; i++)
+		a->regions[i] += b->regions[i];
+
+	for (i = 0; i < STAT_SIZES; i++)
+		a->sizes[i] += b->sizes[i];
+
+	a->games   += b->games;
+	a->folders += b->folders;
+	a->cheats  += b->cheats;
+	a->lines   += b->lines;
+	a->data    += b->data;
+}
+
+/*
+ * pool_worker
+ *
+ * Takes games from the pool until there are none left, counting each into
+ * its own job, and into this thread's totals.
+ */
+
+void *pool_worker(void *arg) {
+	worker_t *worker = (worker_t *) arg;
+	pool_t   *pool   = worker->pool;
+	job_t    *job;
+	size_t    i;
+
+	while (1) {
+		pthread_mutex_lock(&pool->lock);
+		i = pool->next++;
+		pthread_mutex_unlock(&pool->lock);
+
+		if (i >= pool->num)
+			break;
+
+		job = &pool->jobs[i];
+
+		memset(&job->stats, 0, sizeof(stats_t));
+		job->stats.games = 1;
+		count_library(&job->stats, job->game->library);
+
+		stats_add(&worker->total, &job->stats);
+	}
+
+	return NULL;
+}
+
+// ----------------------------------------------------------------------------
+// Output Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * size_label
+ *
+ * Writes the range of lines of STAT_SIZES bucket "b" into "buf".
+ */
+
+void size_label(char *buf, size_t b) {
+	if (b <= 2)
+		sprintf(buf, "%lu", (unsigned long) b);
+	else
+	if (b == STAT_SIZES - 1)
+		sprintf(buf, "%lu+", (1UL << (b - 2)) + 1);
+	else
+		sprintf(buf, "%lu-%lu", (1UL << (b - 2)) + 1, 1UL << (b - 1));
+}
+
+/*
+ * print_table
+ *
+ * Prints one histogram, most common first (or in order if "sorted" is 0).
+ * Buckets that are 0, or have no name, are left out.
+ */
+
+void print_table(
+	const char     *title,
+	const char    **names,
+	const uint64_t *counts,
+	size_t          num,
+	uint64_t        total,
+	uint8_t         sorted
+) {
+	size_t  order[STAT_TYPES], i, j, tmp;
+
+	for (i = 0; i < num; i++)
+		order[i] = i;
+
+	// Insertion sort. There are never more than STAT_TYPES.
+	for (i = 1; sorted && i < num; i++) {
+		for (j = i; j > 0 && counts[order[j]] > counts[order[j - 1]]; j--) {
+			tmp          = order[j];
+			order[j]     = order[j - 1];
+			order[j - 1] = tmp;
+		}
+	}
+
+	printf("\t%-24s %12s %8s\n", title, "COUNT", "%");
+
+	for (i = 0; i < num; i++) {
+		if (counts[order[i]] == 0 || names[order[i]] == NULL)
+			continue;
+
+		printf(
+			"\t%-24s %12llu %7.2f%%\n",
+			names[order[i]],
+			(unsigned long long) counts[order[i]],
+			(total > 0) ? 100.0 * counts[order[i]] / total : 0.0
+		);
+	}
+
+	printf("\n");
+}
+
+/*
+ * type_code
+ *
+ * Writes the code of STAT_TYPES bucket "i" ("0", "C5", "E", ...) into "buf".
+ */
+
+void type_code(char *buf, size_t i) {
+	if (i < 12)
+		sprintf(buf, "%X", (unsigned) i);
+	else
+	if (i < 28)
+		sprintf(buf, "C%X", (unsigned) (i - 12));
+	else
+	if (i < 44)
+		sprintf(buf, "D%X", (unsigned) (i - 28));
+	else
+		sprintf(buf, "%c", (i == 44) ? 'E' : 'F');
+}
+
+/*
+ * print_stats
+ *
+ * Prints the counts of "scope" (a game ID, or "ALL").
+ */
+
+void print_stats(const char *scope, const stats_t *s, args_t *args) {
+	const char *size_names[STAT_SIZES];
+	char        labels[STAT_SIZES][32], code[4];
+	uint64_t    unknown, addressed;
+	size_t      i;
+
+	for (i = 0; i < STAT_SIZES; i++) {
+		size_label(labels[i], i);
+		size_names[i] = labels[i];
+	}
+
+	if (args->flag_machine) {
+		printf("%s\tsummary\tgames\t%llu\n", scope,
+			(unsigned long long) s->games);
+		printf("%s\tsummary\tfolders\t%llu\n", scope,
+			(unsigned long long) s->folders);
+		printf("%s\tsummary\tcheats\t%llu\n", scope,
+			(unsigned long long) s->cheats);
+		printf("%s\tsummary\tlines\t%llu\n", scope,
+			(unsigned long long) s->lines);
+		printf("%s\tsummary\tdata\t%llu\n", scope,
+			(unsigned long long) s->data);
+
+		// Every bucket, even unused ones, so rows line up across runs
+		for (i = 0; i < STAT_TYPES; i++) {
+			type_code(code, i);
+			printf("%s\ttype\t%s\t%llu\n", scope, code,
+				(unsigned long long) s->types[i]);
+		}
+
+		for (i = 0; i < STAT_REGIONS; i++)
+			printf("%s\tregion\t0x%02lX\t%llu\n", scope, (unsigned long) i,
+				(unsigned long long) s->regions[i]);
+
+		for (i = 0; i < STAT_SIZES; i++)
+			printf("%s\tsize\t%s\t%llu\n", scope, labels[i],
+				(unsigned long long) s->sizes[i]);
+
+		return;
+	}
+
+	printf(
+		"%s: %llu games, %llu folders, %llu cheats, %llu lines (%llu of E "
+		"code data)\n\n",
+		scope,
+		(unsigned long long) s->games,
+		(unsigned long long) s->folders,
+		(unsigned long long) s->cheats,
+		(unsigned long long) s->lines,
+		(unsigned long long) s->data
+	);
+
+	print_table(
+		"CODE TYPE", type_names, s->types, STAT_TYPES, s->lines - s->data, 1
+	);
+
+	// Codes the ARDS doesn't have have no name, so are summed up on their own
+	for (i = 0, unknown = 0; i < STAT_TYPES; i++)
+		if (type_names[i] == NULL)
+			unknown += s->types[i];
+
+	if (unknown > 0)
+		printf("\t%-24s %12llu\n\n", "Unknown", (unsigned long long) unknown);
+
+	for (i = 0, addressed = 0; i < STAT_REGIONS; i++)
+		addressed += s->regions[i];
+
+	print_table(
+		"REGION", region_names, s->regions, STAT_REGIONS, addressed, 1
+	);
+
+	print_table(
+		"CHEAT SIZE (LINES)", size_names, s->sizes, STAT_SIZES, s->cheats, 0
+	);
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t             args;
+	pool_t             pool;
+	worker_t          *workers;
+	stats_t            total;
+	ar_game_list_node  node;
+	CN_VEC             positions;
+	FILE              *fp;
+	uint32_t           pos, *it;
+	size_t             i, n;
+	char               id[16];
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (args.num_paths < 1) {
+		fprintf(
+			stderr,
+			"usage: %s [-ghm] [-j THREADS] IN_ARDS.nds [IN_POS_HEX1 [...]]\n",
+			argv[0]
+		);
+
+		free(args.paths);
+		return ST_EXIT_USAGE;
+	}
+
+	fp = fopen(args.paths[0], "rb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			args.paths[0],
+			strerror(errno)
+		);
+
+		free(args.paths);
+		return ST_EXIT_READ;
+	}
+
+	// Positions given, or every game in the list at 0x00044000
+	positions = cn_vec_init(uint32_t);
+
+	if (args.num_paths > 1) {
+		for (i = 1; i < args.num_paths; i++) {
+			sscanf(args.paths[i], "%x", &pos);
+			cn_vec_push_back(positions, &pos);
+		}
+	}
+	else {
+		fseek(fp, 0x44000, SEEK_SET);
+
+		// Read in "ar_game_list_node"s until "FF FF FF FF"
+		while (fread(&node, sizeof(ar_game_list_node), 1, fp) == 1) {
+			if (node.magic == 0xFFFFFFFFU)
+				break;
+
+			// Anything other than "00 00 00 00" = not a game
+			if (node.magic != 0x00000000U)
+				continue;
+
+			pos = 0x40000 + (node.location << 8);
+			cn_vec_push_back(positions, &pos);
+		}
+	}
+
+	// Read every game first. The file can't be shared between threads.
+	pool.num  = cn_vec_size(positions);
+	pool.next = 0;
+	pool.jobs = (job_t *) malloc((pool.num + 1) * sizeof(job_t));
+
+	i = 0;
+	cn_vec_traverse(positions, it) {
+		pool.jobs[i].game = ards_game_init();
+		ards_game_read(pool.jobs[i].game, fp, *it);
+		i++;
+	}
+
+	fclose(fp);
+	cn_vec_free(positions);
+
+	// Count them all, each thread into its own totals
+	memset(&total, 0, sizeof(stats_t));
+	n = (args.threads < pool.num) ? args.threads : pool.num;
+
+	if (n > 0) {
+		workers = (worker_t *) calloc(n, sizeof(worker_t));
+		pthread_mutex_init(&pool.lock, NULL);
+
+		for (i = 0; i < n; i++) {
+			workers[i].pool = &pool;
+			pthread_create(&workers[i].tid, NULL, pool_worker, &workers[i]);
+		}
+
+		for (i = 0; i < n; i++) {
+			pthread_join(workers[i].tid, NULL);
+			stats_add(&total, &workers[i].total);
+		}
+
+		pthread_mutex_destroy(&pool.lock);
+		free(workers);
+	}
+
+	// Report
+	if (args.flag_games) {
+		for (i = 0; i < pool.num; i++) {
+			sprintf(
+				id,
+				"%.4s-%08X",
+				pool.jobs[i].game->header.ID,
+				pool.jobs[i].game->header.N_CRC32
+			);
+
+			print_stats(id, &pool.jobs[i].stats, &args);
+		}
+	}
+
+	print_stats("ALL", &total, &args);
+
+	// Clean up
+	for (i = 0; i < pool.num; i++)
+		ards_game_free(pool.jobs[i].game);
+
+	free(pool.jobs);
+	free(args.paths);
+
+	return ST_EXIT_OK;
+}
@@ -6,6 +6,13 @@
  *     appear in the 5th and 6th byte of the file. This will skip the first 8
  *     bytes of the file.
  *
+ *     Files are streamed in fixed-size blocks, so memory use doesn't depend
+ *     on the size of the file, and pipes work. With no files (or "-"), stdin
+ *     is read.
+ *
+ *     With "--verify", the checksum is compared to the one stored in bytes
+ *     4 - 7 of the file instead of being printed.
+ *
  * Author:
  *     Clara Nguyen (@iDestyKK)
  */
@@ -18,50 +25,257 @@
 
 #include "../lib/ards_util/firmware.h"
 
-int main(int argc, char **argv) {
-	// Argument check
-	if (argc != 2) {
-		fprintf(stderr, "usage: %s ARDS_FIRMWARE.bin\n", argv[0]);
-		return 1;
+// Bytes read (and checksummed) at a time
+#define FW_BLOCK_SZ 0x00100000
+
+// Exit statuses
+#define FW_EXIT_OK       0
+#define FW_EXIT_USAGE    1
+#define FW_EXIT_READ     2
+#define FW_EXIT_MISMATCH 3
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t   flag_verify;
+	char    **paths;
+	size_t    num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf("usage: %s [-v|--verify] [ARDS_FIRMWARE.bin ...]\n", argv[0]);
+	printf("Computes the checksum of Action Replay DS firmware files. With no "
+		"files, or\n\"-\", stdin is read.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-v\tCompare the checksum to the one stored in bytes 4 - 7 of "
+		"each file,\n\t\tand print \"OK\" or \"FAILED\" for each. Same as "
+		"\"--verify\".\n\n");
+
+	printf("Exits with 0 if everything passed, 2 if a file couldn't be read, "
+		"or 3 if a\nchecksum didn't match.\n");
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int i, j, len;
+
+	// Defaults
+	obj->flag_verify = 0;
+	obj->paths       = (char **) malloc(sizeof(char *) * argc);
+	obj->num_paths   = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Anything that isn't a flag is a path
+		if (argv[i][0] != '-' || argv[i][1] == 0) {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		// The only long flags
+		if (strcmp(argv[i], "--verify") == 0) {
+			obj->flag_verify = 1;
+			continue;
+		}
+
+		if (strcmp(argv[i], "--help") == 0)
+			print_help(argc, argv);
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'v':
+					// Verify mode
+					obj->flag_verify = 1;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
 	}
+}
+
+// ----------------------------------------------------------------------------
+// Checksum Functions                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * checksum_stream
+ *
+ * Reads "fp" to the end, "block" (FW_BLOCK_SZ bytes) at a time. The first 8
+ * bytes go into "header", and everything after is checksummed into "crc".
+ *
+ * Returns 0 on success, 1 if there were 8 bytes or less, or -1 if reading
+ * failed (check errno).
+ */
 
-	FILE    *fp;
-	size_t   buffer_sz, ft;
-	uint8_t *buffer;
+int checksum_stream(FILE *fp, uint8_t *block, uint8_t *header, uint16_t *crc) {
+	size_t n, total;
+
+	// Header first. Not part of the checksum.
+	if (fread(header, sizeof(uint8_t), 8, fp) != 8)
+		return ferror(fp) ? -1 : 1;
+
+	*crc  = 0xFFFF;
+	total = 0;
+
+	// Then everything else, a block at a time
+	while ((n = fread(block, sizeof(uint8_t), FW_BLOCK_SZ, fp)) > 0) {
+		*crc   = crc16_parallel(*crc, n, block, 0);
+		total += n;
+	}
 
-	fp = fopen(argv[1], "rb");
+	if (ferror(fp))
+		return -1;
+
+	return (total == 0) ? 1 : 0;
+}
+
+/*
+ * checksum_file
+ *
+ * Checksums the file at "path" ("-" for stdin) and prints the result. In
+ * verify mode, it's compared to the checksum stored in bytes 4 - 7. Returns
+ * one of the FW_EXIT_* statuses.
+ */
+
+int checksum_file(
+	const char *path,
+	uint8_t    *block,
+	uint8_t     verify,
+	uint8_t     show_path
+) {
+	FILE     *fp;
+	uint8_t   header[8];
+	uint16_t  crc;
+	uint32_t  stored;
+	int       status;
+
+	if (strcmp(path, "-") == 0)
+		fp = stdin;
+	else
+		fp = fopen(path, "rb");
 
 	if (!fp) {
-		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
-		return 1;
+		fprintf(
+			stderr,
+			"Error: %s: Failed to open file: %s\n",
+			path,
+			strerror(errno)
+		);
+
+		return FW_EXIT_READ;
 	}
-	
-	// Get file size and check
-	fseek(fp, 0, SEEK_END);
-	ft = ftell(fp);
 
-	if (ft <= 8) {
+	status = checksum_stream(fp, block, header, &crc);
+
+	if (status < 0) {
 		fprintf(
-			stderr, "Error: File must be larger than 8 bytes (is %d)...\n", ft
+			stderr,
+			"Error: %s: Failed to read file: %s\n",
+			path,
+			strerror(errno)
 		);
+	}
+	else
+	if (status > 0) {
+		fprintf(stderr, "Error: %s: File must be larger than 8 bytes\n", path);
+	}
+
+	if (fp != stdin)
+		fclose(fp);
+
+	if (status != 0)
+		return FW_EXIT_READ;
 
-		return 2;
+	// Just print the checksum
+	if (!verify) {
+		if (show_path)
+			printf("%04X  %s\n", crc, path);
+		else
+			printf("%04X\n", crc);
+
+		return FW_EXIT_OK;
 	}
 
-	// Read in all but first 8 bytes
-	buffer_sz = ft - 8;
-	fseek(fp, 8, SEEK_SET);
-	
-	buffer = (uint8_t *) malloc(sizeof(uint8_t) * buffer_sz);
-	fread(&buffer[0], sizeof(uint8_t), buffer_sz, fp);
-	fclose(fp);
+	// Compare to what the file says. Stored as a little-endian 32-bit value.
+	stored = (uint32_t) header[4]
+	       | ((uint32_t) header[5] <<  8)
+	       | ((uint32_t) header[6] << 16)
+	       | ((uint32_t) header[7] << 24);
+
+	if (stored == crc) {
+		printf("%s: OK\n", path);
+		return FW_EXIT_OK;
+	}
 
-	// Get checksum result
 	printf(
-		"%04X\n", crc16(0xFFFF, buffer_sz, buffer)
+		"%s: FAILED (stored %08X, computed %08X)\n",
+		path,
+		stored,
+		(uint32_t) crc
 	);
 
+	return FW_EXIT_MISMATCH;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t   args;
+	uint8_t *block;
+	size_t   i;
+	int      status, ret;
+
+	parse_flags(argc, argv, &args);
+
+	// Read stdin if nothing was given
+	if (args.num_paths == 0)
+		args.paths[args.num_paths++] = "-";
+
+	// One block, reused for every file
+	block = (uint8_t *) malloc(sizeof(uint8_t) * FW_BLOCK_SZ);
+	ret   = FW_EXIT_OK;
+
+	for (i = 0; i < args.num_paths; i++) {
+		status = checksum_file(
+			args.paths[i],
+			block,
+			args.flag_verify,
+			args.num_paths > 1
+		);
+
+		// A file that couldn't be read beats a mismatch
+		if (status == FW_EXIT_READ || ret == FW_EXIT_OK)
+			ret = status;
+	}
+
 	// Clean up. We're done here.
-	free(buffer);
-	return 0;
+	free(block);
+	free(args.paths);
+
+	return ret;
 }
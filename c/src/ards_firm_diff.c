@@ -0,0 +1,455 @@
+/*
+ * ARDS Firmware Diff
+ *
+ * Description:
+ *     Given two or more Action Replay DS firmware files (as written by
+ *     "ards_firm_extract"), report which ranges of each were changed,
+ *     inserted, moved or deleted compared to the one before it. Offsets are
+ *     into the payload, after the 8 byte "FIRM" header.
+ *
+ *     With "-o", a binary delta from the first firmware to the second is
+ *     also written. With "-a", a delta is applied to a firmware to rebuild
+ *     the other one, which is written to stdout.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+#include "../lib/ards_util/firmware.h"
+#include "../lib/ards_util/delta.h"
+#include "../lib/CN_Vec/cn_vec.h"
+
+/*
+ * FIRMWARE_T
+ *
+ * A loaded firmware file.
+ */
+
+typedef struct FIRMWARE_T {
+	char     *path;
+	uint8_t  *payload;
+	size_t    size;
+	uint32_t  checksum; // From the header
+} firmware_t;
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	char    *delta_out;
+	char    *delta_in;
+	size_t   block_sz;
+	char   **paths;
+	size_t   num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf("usage: %s [-b BLOCK] [-o DELTA_OUT] FIRM_A FIRM_B [...]\n",
+		argv[0]);
+	printf("       %s -a DELTA_IN FIRM_A > FIRM_B\n", argv[0]);
+	printf("Compares Action Replay DS firmware files, or applies a delta to "
+		"one.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-a\tApply DELTA_IN to FIRM_A, and write the result to "
+		"stdout.\n\n");
+
+	printf("\t-b\tSmallest match looked for, in bytes. Defaults to %d.\n\n",
+		DELTA_BLOCK_SZ);
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-o\tWrite a delta from FIRM_A to FIRM_B to DELTA_OUT. Only "
+		"works with\n\t\ttwo firmwares.\n\n");
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int    i, j, len;
+	char   flag, *val;
+
+	// Defaults
+	obj->delta_out = NULL;
+	obj->delta_in  = NULL;
+	obj->block_sz  = DELTA_BLOCK_SZ;
+	obj->paths     = (char **) malloc(sizeof(char *) * argc);
+	obj->num_paths = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Anything that isn't a flag is a firmware
+		if (argv[i][0] != '-' || argv[i][1] == 0) {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'a':
+				case 'b':
+				case 'o':
+					// Flags with a value. Either "-oFILE" or "-o FILE".
+					flag = argv[i][j];
+					val  = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val == NULL)
+						fprintf(stderr, "WARN: \"-%c\" needs a value.\n", flag);
+					else
+					if (flag == 'a')
+						obj->delta_in = val;
+					else
+					if (flag == 'o')
+						obj->delta_out = val;
+					else
+						obj->block_sz = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Firmware Diff Functions                                                 {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * load_firmware
+ *
+ * Loads the firmware at "path" into "fw", and warns if its checksum doesn't
+ * match. Returns 0 on success, or 1 (after printing why) on failure.
+ */
+
+int load_firmware(char *path, firmware_t *fw) {
+	int      status;
+	uint16_t crc;
+
+	fw->path = path;
+	status   = firmware_load(path, &fw->payload, &fw->size, &fw->checksum);
+
+	if (status < 0) {
+		fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	if (status > 0) {
+		fprintf(stderr, "Error: %s: Not a firmware file\n", path);
+		return 1;
+	}
+
+	crc = crc16_parallel(0xFFFF, fw->size, fw->payload, 0);
+
+	if (crc != fw->checksum) {
+		fprintf(
+			stderr,
+			"WARN: %s: Checksum is %08X, but the payload's is %08X\n",
+			path,
+			fw->checksum,
+			(uint32_t) crc
+		);
+	}
+
+	return 0;
+}
+
+/*
+ * print_range
+ *
+ * Prints one line of the report.
+ */
+
+void print_range(const char *what, size_t start, size_t len) {
+	printf(
+		"%-8s 0x%08lX - 0x%08lX (%lu bytes)",
+		what,
+		(unsigned long) start,
+		(unsigned long) (start + len - 1),
+		(unsigned long) len
+	);
+}
+
+/*
+ * report
+ *
+ * Prints what changed between "a" and "b", going by "ops" (from
+ * "delta_compute"):
+ *
+ *     changed:  New bytes in "b" that replaced bytes in "a"
+ *     inserted: New bytes in "b" that didn't replace anything
+ *     moved:    Bytes from "a" that ended up out of order in "b"
+ *     deleted:  Bytes in "a" that aren't anywhere in "b"
+ */
+
+void report(firmware_t *a, firmware_t *b, CN_VEC ops) {
+	ar_delta_op_t *op, *pending;
+	uint8_t       *used;
+	size_t         prev_end, end, i, start, copied, added;
+
+	printf("=== %s -> %s ===\n", a->path, b->path);
+
+	used     = (uint8_t *) calloc(a->size + 1, sizeof(uint8_t));
+	pending  = NULL;
+	prev_end = 0;
+	copied   = 0;
+	added    = 0;
+
+	cn_vec_traverse(ops, op) {
+		if (op->type == AR_DELTA_ADD) {
+			pending = op;
+			added  += op->len;
+			continue;
+		}
+
+		copied += op->len;
+
+		// New bytes before this copy. Did they replace anything?
+		if (pending != NULL) {
+			if (op->src_off > prev_end) {
+				print_range("changed", pending->dst_off, pending->len);
+				printf(", was 0x%08lX - 0x%08lX\n",
+					(unsigned long) prev_end,
+					(unsigned long) (op->src_off - 1));
+
+				memset(&used[prev_end], 1, op->src_off - prev_end);
+			}
+			else {
+				print_range("inserted", pending->dst_off, pending->len);
+				printf("\n");
+			}
+
+			pending = NULL;
+		}
+
+		// Going backwards in "a" means this was moved
+		if (op->src_off < prev_end) {
+			print_range("moved", op->dst_off, op->len);
+			printf(", from 0x%08lX\n", (unsigned long) op->src_off);
+		}
+
+		memset(&used[op->src_off], 1, op->len);
+
+		end = op->src_off + op->len;
+
+		if (end > prev_end)
+			prev_end = end;
+	}
+
+	// New bytes at the very end
+	if (pending != NULL) {
+		if (prev_end < a->size) {
+			print_range("changed", pending->dst_off, pending->len);
+			printf(", was 0x%08lX - 0x%08lX\n",
+				(unsigned long) prev_end,
+				(unsigned long) (a->size - 1));
+
+			memset(&used[prev_end], 1, a->size - prev_end);
+		}
+		else {
+			print_range("inserted", pending->dst_off, pending->len);
+			printf("\n");
+		}
+	}
+
+	// Anything in "a" that wasn't used at all
+	for (i = 0; i < a->size; ) {
+		if (used[i]) {
+			i++;
+			continue;
+		}
+
+		for (start = i; i < a->size && !used[i]; i++);
+
+		print_range("deleted", start, i - start);
+		printf(", from %s\n", a->path);
+	}
+
+	printf(
+		"%lu operations, %lu bytes copied, %lu bytes new, %lu byte delta\n",
+		(unsigned long) cn_vec_size(ops),
+		(unsigned long) copied,
+		(unsigned long) added,
+		(unsigned long) delta_size(ops)
+	);
+
+	free(used);
+}
+
+/*
+ * apply
+ *
+ * Applies the delta at "delta_path" to "fw", and writes the resulting
+ * firmware file to stdout. Returns the exit status.
+ */
+
+int apply(const char *delta_path, firmware_t *fw) {
+	FILE     *fp;
+	uint8_t  *out;
+	size_t    out_sz;
+	uint32_t  checksum;
+	int       status;
+
+	fp = fopen(delta_path, "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: %s: %s\n", delta_path, strerror(errno));
+		return 1;
+	}
+
+	status = delta_apply(fp, fw->payload, fw->size, &out, &out_sz);
+	fclose(fp);
+
+	if (status != AR_DELTA_OK) {
+		fprintf(stderr, "Error: %s: %s\n", delta_path, delta_strerror(status));
+		return 2;
+	}
+
+	// Same layout as "ards_firm_extract" writes
+	checksum = (uint32_t) crc16_parallel(0xFFFF, out_sz, out, 0);
+
+	printf(FIRMWARE_MAGIC);
+	fwrite(&checksum, sizeof(uint32_t), 1, stdout);
+	fwrite(out, sizeof(uint8_t), out_sz, stdout);
+
+	free(out);
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t      args;
+	firmware_t *fws;
+	CN_VEC      ops;
+	FILE       *fp;
+	size_t      i;
+	int         status;
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (
+		(args.delta_in != NULL && args.num_paths != 1) ||
+		(args.delta_in == NULL && args.num_paths <  2) ||
+		(args.delta_out != NULL && args.num_paths != 2)
+	) {
+		fprintf(
+			stderr,
+			"usage: %s [-b BLOCK] [-o DELTA_OUT] FIRM_A FIRM_B [...]\n"
+			"       %s -a DELTA_IN FIRM_A > FIRM_B\n",
+			argv[0],
+			argv[0]
+		);
+
+		free(args.paths);
+		return 1;
+	}
+
+	fws = (firmware_t *) calloc(args.num_paths, sizeof(firmware_t));
+
+	for (i = 0; i < args.num_paths; i++) {
+		if (load_firmware(args.paths[i], &fws[i]) != 0)
+			return 2;
+	}
+
+	// Apply mode
+	if (args.delta_in != NULL) {
+		status = apply(args.delta_in, &fws[0]);
+
+		free(fws[0].payload);
+		free(fws);
+		free(args.paths);
+
+		return status;
+	}
+
+	// Compare each firmware to the one before it
+	status = 0;
+
+	for (i = 1; i < args.num_paths; i++) {
+		ops = delta_compute(
+			fws[i - 1].payload,
+			fws[i - 1].size,
+			fws[i].payload,
+			fws[i].size,
+			args.block_sz
+		);
+
+		report(&fws[i - 1], &fws[i], ops);
+
+		if (args.delta_out != NULL) {
+			fp = fopen(args.delta_out, "wb");
+
+			if (!fp) {
+				fprintf(
+					stderr,
+					"Error: %s: %s\n",
+					args.delta_out,
+					strerror(errno)
+				);
+
+				status = 1;
+			}
+			else {
+				delta_write(
+					fp,
+					ops,
+					fws[i - 1].payload,
+					fws[i - 1].size,
+					fws[i].payload,
+					fws[i].size
+				);
+
+				fclose(fp);
+			}
+		}
+
+		cn_vec_free(ops);
+
+		if (i + 1 < args.num_paths)
+			printf("\n");
+	}
+
+	// Clean up. We're done here.
+	for (i = 0; i < args.num_paths; i++)
+		free(fws[i].payload);
+
+	free(fws);
+	free(args.paths);
+
+	return status;
+}
@@ -9,6 +9,12 @@
  *     revision, I will add in an optional argument that lets this be changed
  *     upon generation.
  *
+ *     The firmware region is mirrored in every bank of the dump, so a copy is
+ *     pulled from each of them (0x00100000, 0x00200000, ...). Each copy has
+ *     its 0xFF padding trimmed and is checksummed, and the copy most banks
+ *     agree on is the one written out. Banks that disagree are reported to
+ *     stderr.
+ *
  * Author:
  *     Clara Nguyen (@iDestyKK)
  */
@@ -21,22 +27,139 @@
 
 #include "../lib/ards_util/firmware.h"
 
-#define FW_MAX   0x00040000
-#define FW_START 0x00100000
+#define FW_MAX    0x00040000
+#define FW_START  0x00100000
+#define FW_STRIDE 0x00100000
+
+/*
+ * FW_COPY_T
+ *
+ * The firmware region from a single bank.
+ */
+
+typedef struct FW_COPY_T {
+	uint8_t  *buffer; // FW_MAX bytes, as read
+	size_t    offset; // Where in the dump it came from
+	size_t    size;   // Bytes left after trimming 0xFF padding
+	uint16_t  crc;    // CRC16 of the trimmed bytes
+	size_t    group;  // First copy identical to this one
+	size_t    votes;  // Copies identical to this one, if it's the first
+} fw_copy_t;
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	size_t  start;
+	size_t  stride;
+	char   *path;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-o OFFSET] [-s STRIDE] ARDS_IN.nds > FIRMWARE_OUT.bin\n",
+		argv[0]
+	);
+	printf("Extracts the firmware from an Action Replay DS ROM dump.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-o\tOffset of the first firmware copy. Defaults to "
+		"0x%08X.\n\n", FW_START);
+
+	printf("\t-s\tBytes between firmware copies. Defaults to 0x%08X.\n\n",
+		FW_STRIDE);
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int     i, j, len;
+	char   *val;
+	size_t *dst;
+
+	// Defaults
+	obj->start  = FW_START;
+	obj->stride = FW_STRIDE;
+	obj->path   = NULL;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// The first argument that isn't a flag is the dump
+		if (argv[i][0] != '-') {
+			if (obj->path == NULL)
+				obj->path = argv[i];
+
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'o':
+				case 's':
+					// Offset or stride. Either "-o0x100000" or "-o 0x100000".
+					dst = (argv[i][j] == 'o') ? &obj->start : &obj->stride;
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						*dst = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+
+	if (obj->stride == 0)
+		obj->stride = FW_STRIDE;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
 
 int main(int argc, char **argv) {
+	args_t     args;
+	FILE      *fp;
+	size_t     ft, num, i, j, best;
+	fw_copy_t *copies, *fw;
+	uint32_t   checksum; // Trust me
+
+	parse_flags(argc, argv, &args);
+
 	// Argument check
-	if (argc != 2) {
+	if (args.path == NULL) {
 		fprintf(stderr, "usage: %s ARDS_IN.nds > FIRMWARE_OUT.bin\n", argv[0]);
 		return 1;
 	}
 
-	FILE    *fp;
-	size_t   firmware_sz, ft;
-	uint8_t *buffer;
-	uint32_t checksum; // Trust me
-
-	fp = fopen(argv[1], "rb");
+	fp = fopen(args.path, "rb");
 
 	if (!fp) {
 		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
@@ -47,35 +170,126 @@ int main(int argc, char **argv) {
 	fseek(fp, 0, SEEK_END);
 	ft = ftell(fp);
 
-	if (ft < 0x0013FFFF) {
+	if (ft < args.start + FW_MAX) {
 		fprintf(
 			stderr,
-			"Error: File must be larger than 1310719 bytes (is %d)...\n",
-			ft
+			"Error: File must be at least %lu bytes (is %lu)...\n",
+			(unsigned long) (args.start + FW_MAX),
+			(unsigned long) ft
 		);
 
+		fclose(fp);
 		return 2;
 	}
 
-	// Read in from 0x00100000 to 0x00140000.
-	fseek(fp, FW_START, SEEK_SET);
-	
-	buffer = (uint8_t *) malloc(sizeof(uint8_t) * FW_MAX);
-	fread(&buffer[0], sizeof(uint8_t), FW_MAX, fp);
+	// Every bank the firmware region fits in
+	num    = (ft - args.start - FW_MAX) / args.stride + 1;
+	copies = (fw_copy_t *) calloc(num, sizeof(fw_copy_t));
+
+	for (i = 0; i < num; i++) {
+		fw         = &copies[i];
+		fw->offset = args.start + i * args.stride;
+		fw->buffer = (uint8_t *) malloc(sizeof(uint8_t) * FW_MAX);
+
+		fseek(fp, fw->offset, SEEK_SET);
+
+		if (fread(fw->buffer, sizeof(uint8_t), FW_MAX, fp) != FW_MAX) {
+			fprintf(
+				stderr,
+				"Error: Failed to read bank at 0x%08lX\n",
+				(unsigned long) fw->offset
+			);
+
+			return 2;
+		}
+
+		// Skip the 0xFF padding at the end, then checksum what's left
+		fw->size = firmware_trim(fw->buffer, FW_MAX);
+		fw->crc  = crc16_parallel(0xFFFF, fw->size, fw->buffer, 0);
+	}
+
 	fclose(fp);
 
-	// Skip to the end of the buffer and go backwards until not 0xFF
-	// TODO: This will fail miserably if all bytes are 0xFF, lol...
-	for (firmware_sz = FW_MAX; buffer[firmware_sz - 1] == 0xFF; firmware_sz--);
+	// Group identical copies. The CRC16 narrows it down, memcmp confirms.
+	for (i = 0; i < num; i++) {
+		copies[i].group = i;
+
+		for (j = 0; j < i; j++) {
+			if (
+				copies[j].group == j                 &&
+				copies[j].size  == copies[i].size    &&
+				copies[j].crc   == copies[i].crc     &&
+				memcmp(
+					copies[j].buffer, copies[i].buffer, copies[i].size
+				) == 0
+			) {
+				copies[i].group = j;
+				break;
+			}
+		}
+
+		copies[copies[i].group].votes++;
+	}
+
+	// Most votes wins, and ties go to the earlier bank. A blank copy only
+	// wins if every copy is blank.
+	for (i = 1, best = 0; i < num; i++) {
+		if (copies[i].group != i)
+			continue;
+
+		if (
+			(copies[best].size == 0 && copies[i].size != 0) ||
+			(
+				(copies[best].size == 0) == (copies[i].size == 0) &&
+				copies[i].votes > copies[best].votes
+			)
+		) {
+			best = i;
+		}
+	}
+
+	fw = &copies[best];
 
-	// Get checksum result and write firmware out to stdout
-	checksum = (uint32_t) crc16(0xFFFF, firmware_sz, buffer);
+	// Report every bank that doesn't match the winner
+	for (i = 0; i < num; i++) {
+		if (copies[i].group == best)
+			continue;
+
+		fprintf(
+			stderr,
+			"WARN: Bank at 0x%08lX disagrees (%lu bytes, CRC %04X)\n",
+			(unsigned long) copies[i].offset,
+			(unsigned long) copies[i].size,
+			copies[i].crc
+		);
+	}
+
+	if (fw->votes * 2 <= num && num > 1) {
+		fprintf(
+			stderr,
+			"WARN: No majority. Using bank at 0x%08lX (%lu of %lu agree)\n",
+			(unsigned long) fw->offset,
+			(unsigned long) fw->votes,
+			(unsigned long) num
+		);
+	}
+
+	if (fw->size == 0) {
+		fprintf(stderr, "Error: Firmware region is blank (all 0xFF)\n");
+		return 2;
+	}
+
+	// Write the winning copy out to stdout
+	checksum = (uint32_t) fw->crc;
 
 	printf("FIRM");
 	fwrite(&checksum, sizeof(uint32_t), 1, stdout);
-	fwrite(buffer, sizeof(uint8_t), firmware_sz, stdout);
+	fwrite(fw->buffer, sizeof(uint8_t), fw->size, stdout);
 
 	// Clean up. We're done here.
-	free(buffer);
+	for (i = 0; i < num; i++)
+		free(copies[i].buffer);
+
+	free(copies);
 	return 0;
 }
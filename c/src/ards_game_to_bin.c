@@ -0,0 +1,94 @@
+/*
+ * ARDS Game-to-Binary Extractor
+ *
+ * Description:
+ *     Given a game's hex position in an Action Replay DS ROM dump, read the
+ *     game in and write it back out in the ARDS byte format. The output can be
+ *     fed right back into "ards_game_to_xml" and friends.
+ *
+ *     The address to input into this program is the location of the
+ *     "01 00 1C 00", found 20 bytes before the cartridge ID, and 32 bytes
+ *     before the binary section of the Action Replay codes.
+ *
+ *     Multiple addresses can be supplied. Games are written back-to-back, each
+ *     padded with 0xFF to a 0x100 byte boundary like they are in the ROM. So
+ *     the Nth game in the output is found at the Nth address printed to
+ *     stderr.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// Games in the ROM start on 0x100 byte boundaries
+#define GAME_ALIGN 0x100
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	// Argument check
+	if (argc < 3) {
+		fprintf(
+			stderr,
+			"usage: %s IN_ARDS.nds IN_POS_HEX1 [IN_POS_HEX2 [...]] > OUT.bin\n",
+			argv[0]
+		);
+
+		return 1;
+	}
+
+	FILE      *fp;       // File Pointer
+	ARDS_GAME  game;     // Game being copied
+	size_t     out_pos,  // Bytes written to stdout so far
+	           sz;       // Size of a single game
+	uint32_t   pos_hex;  // Position to jump to in ROM
+	int        i;        // Loop counter
+
+	// Begin reading the contents of the file
+	fp = fopen(argv[1], "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
+		return 2;
+	}
+
+	out_pos = 0;
+
+	// Read each game and immediately write it back out
+	for (i = 2; i < argc; i++) {
+		sscanf(argv[i], "%x", &pos_hex);
+
+		game = ards_game_init();
+		ards_game_read(game, fp, pos_hex);
+
+		fprintf(stderr, "0x%08lx - %.4s-%08X - %s\n",
+			(unsigned long) out_pos, game->header.ID, game->header.N_CRC32,
+			game->name);
+
+		sz = ards_game_export_as_binary(game, stdout);
+
+		// Pad to the next game boundary
+		for (out_pos += sz; out_pos % GAME_ALIGN != 0; out_pos++)
+			fputc(0xFF, stdout);
+
+		ards_game_free(game);
+	}
+
+	// We're done here
+	fclose(fp);
+	return 0;
+}
@@ -0,0 +1,102 @@
+/*
+ * ARDS Game-to-Columns Exporter
+ *
+ * Description:
+ *     Given a game's hex position in an Action Replay DS ROM dump, extract all
+ *     code lines and write them out as flat column files into a directory.
+ *     One row per code line. See "ards_game_export_as_columns" in
+ *     "ards_util/io.c" for the column layout.
+ *
+ *     Columns are fixed-width, so they can be mmap'd and scanned as plain
+ *     arrays, e.g. to find every game that writes to an address range.
+ *
+ *     Multiple addresses can be supplied to put multiple games in the same set
+ *     of columns. The game column is the index of the address given.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	// Argument check
+	if (argc < 4) {
+		fprintf(
+			stderr,
+			"usage: %s IN_ARDS.nds OUT_DIR IN_POS_HEX1 [IN_POS_HEX2 [...]]\n",
+			argv[0]
+		);
+
+		return 1;
+	}
+
+	FILE      *fp;       // File Pointer
+	CN_VEC     games;    // ARDS Game Object Vector
+	size_t     game_num, // Game counter
+	           i;        // Loop counter
+	ARDS_GAME *game_arr; // Game Array
+	uint32_t   pos_hex;  // Position to jump to in ROM
+	int        status;   // Export status
+
+	// Setup variables and data structures
+	game_num = argc - 3;
+	games = cn_vec_init(ARDS_GAME);
+	cn_vec_resize(games, game_num);
+	game_arr = cn_vec_array(games, ARDS_GAME);
+
+	// Begin reading the contents of the file
+	fp = fopen(argv[1], "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
+		cn_vec_free(games);
+		return 2;
+	}
+
+	// Read all games from the addresses in the arguments
+	for (i = 0; i < game_num; i++) {
+		sscanf(argv[i + 3], "%x", &pos_hex);
+		game_arr[i] = ards_game_init();
+		ards_game_read(game_arr[i], fp, pos_hex);
+	}
+
+	// Close the file. We're done reading it
+	fclose(fp);
+
+	// Write out all columns
+	status = ards_game_export_as_columns(games, argv[2]);
+
+	if (status != 0) {
+		fprintf(
+			stderr,
+			"Error: Failed to create column files in \"%s\": %s\n",
+			argv[2],
+			strerror(errno)
+		);
+	}
+
+	// Clean up all CNDS instances
+	for (i = 0; i < game_num; i++)
+		ards_game_free(game_arr[i]);
+
+	cn_vec_free(games);
+
+	//We're done here
+	return (status != 0) ? 3 : 0;
+}
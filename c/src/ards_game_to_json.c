@@ -0,0 +1,179 @@
+/*
+ * ARDS Game-to-JSON "Decompiler"
+ *
+ * Description:
+ *     Given a game's hex position in an Action Replay DS ROM dump, extract all
+ *     codes and folders. Same as "ards_game_to_xml", but writes JSON.
+ *
+ *     The address to input into this program is the location of the
+ *     "01 00 1C 00", found 20 bytes before the cartridge ID, and 32 bytes
+ *     before the binary section of the Action Replay codes.
+ *
+ *     Multiple addresses can be supplied. By default, a single JSON document
+ *     is written. With "-n", NDJSON is written instead: one game per line, so
+ *     the output can be split up and processed in parallel.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t flag_ndjson;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-hn] IN_ARDS.nds IN_POS_HEX1 [IN_POS_HEX2 [...]]\n",
+		argv[0]
+	);
+	printf("Exports games in an Action Replay DS ROM dump as JSON.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-n\tNDJSON. Write one game per line instead of a single JSON "
+		"document.\n\n");
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int i, j, len;
+
+	// Defaults
+	obj->flag_ndjson = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Skip if not a valid flag header
+		if (argv[i][0] != '-')
+			continue;
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'n':
+					// One game per line
+					obj->flag_ndjson = 1;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t     args;     // Parsed flags
+	FILE      *fp;       // File Pointer
+	CN_VEC     games;    // ARDS Game Object Vector
+	ARDS_GAME  game;     // Game being read
+	uint32_t   pos_hex;  // Position to jump to in ROM
+	char      *fname;    // ROM dump path
+	size_t     i;        // Loop counter
+
+	parse_flags(argc, argv, &args);
+
+	// The first argument without a "-" is the filename. The rest are addresses
+	fname = NULL;
+	games = cn_vec_init(ARDS_GAME);
+
+	for (i = 1; i < argc; i++) {
+		if (argv[i][0] == '-')
+			continue;
+
+		if (fname == NULL) {
+			fname = argv[i];
+			fp    = fopen(fname, "rb");
+
+			if (!fp) {
+				fprintf(
+					stderr,
+					"Error: Failed to open file: %s\n",
+					strerror(errno)
+				);
+
+				cn_vec_free(games);
+				return 2;
+			}
+
+			continue;
+		}
+
+		// Read game information at address "hex"
+		sscanf(argv[i], "%x", &pos_hex);
+		game = ards_game_init();
+		ards_game_read(game, fp, pos_hex);
+
+		cn_vec_push_back(games, &game);
+	}
+
+	// Argument check
+	if (cn_vec_size(games) == 0) {
+		fprintf(
+			stderr,
+			"usage: %s [-hn] IN_ARDS.nds IN_POS_HEX1 [IN_POS_HEX2 [...]]\n",
+			argv[0]
+		);
+
+		if (fname != NULL)
+			fclose(fp);
+
+		cn_vec_free(games);
+		return 1;
+	}
+
+	// Close the file. We're done reading it
+	fclose(fp);
+
+	// Print everything out
+	if (args.flag_ndjson)
+		ards_game_export_as_ndjson(games, stdout);
+	else
+		ards_game_export_as_json(games, stdout);
+
+	// Clean up all CNDS instances
+	for (i = 0; i < cn_vec_size(games); i++)
+		ards_game_free(cn_vec_array(games, ARDS_GAME)[i]);
+
+	cn_vec_free(games);
+
+	//We're done here
+	return 0;
+}
@@ -0,0 +1,607 @@
+/*
+ * ARDS Manifest
+ *
+ * Description:
+ *     Given an Action Replay DS ROM dump, generate an integrity manifest for
+ *     it: a hash of every 4 KiB page, and a Merkle tree over the pages of
+ *     each bank and over the banks. See "lib/ards_util/manifest.h".
+ *
+ *     With "-v", a dump is checked against a manifest made earlier. Pages are
+ *     hashed on several threads, and the trees are compared from the top
+ *     down to find exactly which pages are damaged.
+ *
+ *     With "-c", two manifests are compared the same way, without reading
+ *     either dump.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+// ARDS Utils
+#include "../lib/ards_util/manifest.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+#define CHUNK_SZ 0x00100000 // Default bank size
+
+// Exit statuses
+#define MF_EXIT_OK       0
+#define MF_EXIT_USAGE    1
+#define MF_EXIT_READ     2
+#define MF_EXIT_MISMATCH 3
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t  flag_verify;
+	uint8_t  flag_compare;
+	size_t   bank_sz;
+	size_t   banks;
+	size_t   page_sz;
+	size_t   threads;
+	char    *out;
+	char    *paths[2];
+	size_t   num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf(
+		"usage: %s [-b BANK_SZ] [-n BANKS] [-p PAGE_SZ] [-j THREADS] "
+		"[-o OUT.ardm]\n"
+		"       IN_ARDS.nds\n"
+		"       %s -v [-j THREADS] MANIFEST.ardm IN_ARDS.nds\n"
+		"       %s -c MANIFEST_A.ardm MANIFEST_B.ardm\n",
+		argv[0],
+		argv[0],
+		argv[0]
+	);
+
+	printf("Generates and checks integrity manifests of Action Replay DS "
+		"ROM dumps.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-b\tBank size in bytes. Defaults to 1 MiB, or the whole file "
+		"if it isn't\n\t\ta multiple of that, or the file size over "
+		"\"-n\".\n\n");
+
+	printf("\t-c\tCompare two manifests, and print the pages that differ. "
+		"Neither dump\n\t\tis read.\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-j\tThreads to hash pages with. Defaults to the number of "
+		"CPUs.\n\n");
+
+	printf("\t-n\tNumber of banks. Defaults to the file size over the bank "
+		"size.\n\n");
+
+	printf("\t-o\tWhere to write the manifest. Defaults to the dump's path "
+		"with \".ardm\"\n\t\ton the end.\n\n");
+
+	printf("\t-p\tPage size in bytes. Defaults to 4096, and can be at most "
+		"1 MiB.\n\n");
+
+	printf("\t-v\tVerify a dump against a manifest, and print the pages "
+		"that don't match.\n\n");
+
+	printf("Exit status is 0 if everything matches, 2 if a file couldn't "
+		"be read, and 3 if\nany page differs.\n");
+
+	exit(MF_EXIT_OK);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int     i, j, len;
+	char   *val, flag;
+	size_t *dst;
+
+	// Defaults
+	obj->flag_verify  = 0;
+	obj->flag_compare = 0;
+	obj->bank_sz      = 0;
+	obj->banks        = 0;
+	obj->page_sz      = MANIFEST_PAGE_SZ;
+	obj->threads      = 0;
+	obj->out          = NULL;
+	obj->num_paths    = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Arguments without a "-" are filenames
+		if (argv[i][0] != '-') {
+			if (obj->num_paths < 2)
+				obj->paths[obj->num_paths] = argv[i];
+
+			obj->num_paths++;
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			flag = argv[i][j];
+
+			switch (flag) {
+				case 'v':
+					// Verify a dump against a manifest
+					obj->flag_verify = 1;
+					break;
+
+				case 'c':
+					// Compare two manifests
+					obj->flag_compare = 1;
+					break;
+
+				case 'o':
+					// Output path. Either "-oOUT" or "-o OUT".
+					if (j + 1 < len)
+						obj->out = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						obj->out = argv[++i];
+
+					j = len;
+					break;
+
+				case 'b':
+				case 'n':
+				case 'p':
+				case 'j':
+					// Numbers. Either "-p4096" or "-p 4096".
+					dst = (flag == 'b') ? &obj->bank_sz
+						: (flag == 'n') ? &obj->banks
+						: (flag == 'p') ? &obj->page_sz
+						: &obj->threads;
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL)
+						*dst = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Helper Functions                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * load_manifest
+ *
+ * Reads the manifest at "path". Returns an AR_MANIFEST_* status, after
+ * reporting anything but AR_MANIFEST_OK.
+ */
+
+int load_manifest(const char *path, ar_manifest_t *manifest) {
+	FILE *fp;
+	int   status;
+
+	fp = fopen(path, "rb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			path,
+			strerror(errno)
+		);
+
+		return AR_MANIFEST_READ;
+	}
+
+	status = manifest_read(fp, manifest);
+	fclose(fp);
+
+	if (status != AR_MANIFEST_OK)
+		fprintf(stderr, "Error: \"%s\": %s\n", path, manifest_strerror(status));
+
+	return status;
+}
+
+/*
+ * hash_dump
+ *
+ * Sets up "manifest" with the given geometry, and hashes the dump at "path"
+ * into it. If "bank_sz" is 0, it's worked out from the dump's size and
+ * "banks" (which can also be 0). A page bigger than a bank is cut down to
+ * the bank, and one bigger than MANIFEST_MAX_PAGE_SZ is refused. Returns an
+ * MF_EXIT_* status, after reporting anything but MF_EXIT_OK.
+ */
+
+int hash_dump(
+	const char    *path,
+	ar_manifest_t *manifest,
+	uint64_t       bank_sz,
+	uint64_t       banks,
+	uint64_t       page_sz,
+	size_t         threads
+) {
+	struct stat st;
+	int         fd, status;
+
+	fd = open(path, O_RDONLY);
+
+	if (fd < 0 || fstat(fd, &st) != 0) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			path,
+			strerror(errno)
+		);
+
+		if (fd >= 0)
+			close(fd);
+
+		return MF_EXIT_READ;
+	}
+
+	// Work out the bank geometry from whatever wasn't given
+	if (bank_sz == 0 && banks != 0)
+		bank_sz = st.st_size / banks;
+
+	if (bank_sz == 0)
+		bank_sz = (st.st_size % CHUNK_SZ == 0) ? CHUNK_SZ : st.st_size;
+
+	if (banks == 0 && bank_sz != 0)
+		banks = st.st_size / bank_sz;
+
+	if (
+		bank_sz == 0 || page_sz == 0 || banks == 0 || banks > UINT32_MAX ||
+		banks * bank_sz != (uint64_t) st.st_size
+	) {
+		fprintf(
+			stderr,
+			"Error: \"%s\" (%lu bytes) is not %lu banks of %lu bytes\n",
+			path,
+			(unsigned long) st.st_size,
+			(unsigned long) banks,
+			(unsigned long) bank_sz
+		);
+
+		close(fd);
+		return MF_EXIT_USAGE;
+	}
+
+	if (page_sz > MANIFEST_MAX_PAGE_SZ) {
+		fprintf(
+			stderr,
+			"Error: Page size (%lu bytes) is over the limit of %lu bytes\n",
+			(unsigned long) page_sz,
+			(unsigned long) MANIFEST_MAX_PAGE_SZ
+		);
+
+		close(fd);
+		return MF_EXIT_USAGE;
+	}
+
+	// A page can't be bigger than the bank it's in
+	if (page_sz > bank_sz)
+		page_sz = bank_sz;
+
+	manifest_init(manifest, bank_sz, banks, page_sz);
+
+	posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	status = manifest_hash_fd(manifest, fd, threads);
+	close(fd);
+
+	if (status != AR_MANIFEST_OK) {
+		fprintf(stderr, "Error: \"%s\": %s\n", path, manifest_strerror(status));
+		manifest_free(manifest);
+
+		return MF_EXIT_READ;
+	}
+
+	return MF_EXIT_OK;
+}
+
+/*
+ * print_pages
+ *
+ * Prints the pages in "pages" (from "manifest_diff") as ranges of offsets
+ * into the dump, one line per run of pages in a bank. Returns MF_EXIT_OK if
+ * there aren't any, or MF_EXIT_MISMATCH.
+ */
+
+int print_pages(ar_manifest_t *manifest, CN_VEC pages) {
+	ar_manifest_header_t *h;
+	uint32_t             *at, first, last, b, prev, banks;
+	uint64_t              start, end;
+	size_t                i, num;
+
+	h   = &manifest->header;
+	num = cn_vec_size(pages);
+
+	if (num == 0) {
+		printf(
+			"OK: %u banks, %u pages each, root %016llX\n",
+			h->banks,
+			h->pages,
+			(unsigned long long) manifest_root(manifest)
+		);
+
+		return MF_EXIT_OK;
+	}
+
+	for (i = 0, banks = 0, prev = UINT32_MAX; i < num; i++) {
+		at    = (uint32_t *) cn_vec_at(pages, i);
+		first = *at;
+		last  = *at;
+		b     = first / h->pages;
+
+		// Runs stop at the end of a bank
+		for (; i + 1 < num; i++) {
+			at = (uint32_t *) cn_vec_at(pages, i + 1);
+
+			if (*at != last + 1 || *at / h->pages != b)
+				break;
+
+			last = *at;
+		}
+
+		if (b != prev)
+			banks++;
+
+		prev = b;
+
+		start = b * h->bank_sz + (uint64_t) (first % h->pages) * h->page_sz;
+		end   = b * h->bank_sz + (uint64_t) (last % h->pages + 1) * h->page_sz;
+
+		if (end > (b + 1) * h->bank_sz)
+			end = (b + 1) * h->bank_sz;
+
+		printf(
+			"bank %u: 0x%08llX - 0x%08llX (%u pages)\n",
+			b,
+			(unsigned long long) start,
+			(unsigned long long) (end - 1),
+			last - first + 1
+		);
+	}
+
+	printf(
+		"FAILED: %lu of %lu pages differ, in %u of %u banks\n",
+		(unsigned long) num,
+		(unsigned long) h->banks * h->pages,
+		banks,
+		h->banks
+	);
+
+	return MF_EXIT_MISMATCH;
+}
+
+// ----------------------------------------------------------------------------
+// Modes                                                                   {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * manifest_create
+ *
+ * Hashes the dump at "path" and writes its manifest.
+ */
+
+int manifest_create(args_t *args) {
+	ar_manifest_t  manifest;
+	FILE          *fp;
+	char          *out;
+	int            status;
+
+	status = hash_dump(
+		args->paths[0],
+		&manifest,
+		args->bank_sz,
+		args->banks,
+		args->page_sz,
+		args->threads
+	);
+
+	if (status != MF_EXIT_OK)
+		return status;
+
+	// Default to "IN_ARDS.nds.ardm"
+	out = args->out;
+
+	if (out == NULL) {
+		out = (char *) malloc(strlen(args->paths[0]) + 6);
+		sprintf(out, "%s.ardm", args->paths[0]);
+	}
+
+	fp = fopen(out, "wb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			out,
+			strerror(errno)
+		);
+
+		status = MF_EXIT_READ;
+	}
+	else {
+		status = manifest_write(fp, &manifest);
+
+		if (fclose(fp) != 0)
+			status = AR_MANIFEST_WRITE;
+
+		if (status != AR_MANIFEST_OK) {
+			fprintf(
+				stderr,
+				"Error: \"%s\": %s\n",
+				out,
+				manifest_strerror(status)
+			);
+
+			status = MF_EXIT_READ;
+		}
+		else {
+			printf(
+				"%s: %u banks, %u pages each, root %016llX\n",
+				out,
+				manifest.header.banks,
+				manifest.header.pages,
+				(unsigned long long) manifest_root(&manifest)
+			);
+
+			status = MF_EXIT_OK;
+		}
+	}
+
+	if (out != args->out)
+		free(out);
+
+	manifest_free(&manifest);
+
+	return status;
+}
+
+/*
+ * manifest_verify
+ *
+ * Hashes the dump at "paths[1]" with the geometry of the manifest at
+ * "paths[0]", and prints the pages that don't match.
+ */
+
+int manifest_verify(args_t *args) {
+	ar_manifest_t stored, dump;
+	CN_VEC        pages;
+	int           status;
+
+	if (load_manifest(args->paths[0], &stored) != AR_MANIFEST_OK)
+		return MF_EXIT_READ;
+
+	status = hash_dump(
+		args->paths[1],
+		&dump,
+		stored.header.bank_sz,
+		stored.header.banks,
+		stored.header.page_sz,
+		args->threads
+	);
+
+	if (status != MF_EXIT_OK) {
+		manifest_free(&stored);
+		return (status == MF_EXIT_USAGE) ? MF_EXIT_MISMATCH : status;
+	}
+
+	pages = cn_vec_init(uint32_t);
+
+	manifest_diff(&stored, &dump, pages);
+	status = print_pages(&stored, pages);
+
+	cn_vec_free(pages);
+	manifest_free(&stored);
+	manifest_free(&dump);
+
+	return status;
+}
+
+/*
+ * manifest_compare
+ *
+ * Prints the pages that differ between the manifests at "paths[0]" and
+ * "paths[1]".
+ */
+
+int manifest_compare(args_t *args) {
+	ar_manifest_t a, b;
+	CN_VEC        pages;
+	int           status;
+
+	if (load_manifest(args->paths[0], &a) != AR_MANIFEST_OK)
+		return MF_EXIT_READ;
+
+	if (load_manifest(args->paths[1], &b) != AR_MANIFEST_OK) {
+		manifest_free(&a);
+		return MF_EXIT_READ;
+	}
+
+	pages  = cn_vec_init(uint32_t);
+	status = manifest_diff(&a, &b, pages);
+
+	if (status != AR_MANIFEST_OK) {
+		fprintf(stderr, "Error: %s\n", manifest_strerror(status));
+		status = MF_EXIT_MISMATCH;
+	}
+	else {
+		status = print_pages(&a, pages);
+	}
+
+	cn_vec_free(pages);
+	manifest_free(&a);
+	manifest_free(&b);
+
+	return status;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t args;
+	size_t need;
+
+	parse_flags(argc, argv, &args);
+
+	need = (args.flag_verify || args.flag_compare) ? 2 : 1;
+
+	if (args.num_paths != need || (args.flag_verify && args.flag_compare)) {
+		fprintf(
+			stderr,
+			"usage: %s [-b BANK_SZ] [-n BANKS] [-p PAGE_SZ] [-j THREADS] "
+			"[-o OUT.ardm]\n"
+			"       IN_ARDS.nds\n"
+			"       %s -v [-j THREADS] MANIFEST.ardm IN_ARDS.nds\n"
+			"       %s -c MANIFEST_A.ardm MANIFEST_B.ardm\n",
+			argv[0],
+			argv[0],
+			argv[0]
+		);
+
+		return MF_EXIT_USAGE;
+	}
+
+	if (args.flag_verify)
+		return manifest_verify(&args);
+
+	if (args.flag_compare)
+		return manifest_compare(&args);
+
+	return manifest_create(&args);
+}
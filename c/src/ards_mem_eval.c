@@ -2,8 +2,35 @@
  * ARDS Memory Evaluator
  *
  * Description:
- *     Given an Action Replay DS ROM dump of exactly 16,777,216 bytes (16 MiB),
- *     evaluate all sections to make sure they are all the same, byte-by-byte.
+ *     Given an Action Replay DS ROM dump made up of mirrored banks, evaluate
+ *     all banks to make sure they are all the same, byte-by-byte.
+ *
+ *     By default, banks are 1 MiB, and there are as many as the file holds
+ *     (16 in a 16 MiB dump). "-b" and "-n" set the size and number of banks
+ *     instead. The dump is never read in all at once. It is streamed through
+ *     in stripes, reading the same window of every bank at a time, so memory
+ *     use stays the same no matter how big the dump is.
+ *
+ *     With "-c", each bank is hashed once and banks are grouped into classes
+ *     of identical ones, each confirmed with a single memcmp against the first
+ *     bank in it.
+ *
+ *     With "-d", the classes are found the same way, and then every bank
+ *     outside of the biggest class is diffed against it. Each run of
+ *     differing bytes is printed, with how many bits were flipped each way.
+ *
+ *     With "-v", every byte is voted on across all banks, and the most common
+ *     value wins. Offsets where no value won more than half of the banks are
+ *     printed, along with every run where each bank disagrees with the vote,
+ *     and which bank disagrees the most. "-r" and "-R" do the same, and write
+ *     the result out as a single bank ("-r") or as a full dump ("-R"), so the
+ *     other tools can be run on the cleaned up copy.
+ *
+ *     Given more than one file (repeated reads of the same cartridge), each
+ *     file is treated as one bank instead, and they are all streamed through
+ *     side by side. Every mode works the same way on them. With no mode
+ *     given, "-v" is used, and "-r" writes out the consensus of all files.
+ *     "-R" writes the same thing, since each file is already a full dump.
  *
  * Author:
  *     Clara Nguyen (@iDestyKK)
@@ -14,126 +41,907 @@
 #include <stdint.h>
 #include <string.h>
 #include <errno.h>
+#include <fcntl.h>
+
+// ARDS Utils
+#include "../lib/ards_util/bankdiff.h"
+#include "../lib/ards_util/hash.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+#define CHUNK_SZ  0x00100000 // Default bank size
+#define MAX_BANKS 64
+#define STRIPE_SZ 0x00040000 // Bytes read from each bank at a time
+
+#define BANK_BIT(i) (1ULL << (i))
+
+/*
+ * DUMP_T
+ *
+ * An open dump, and the window of each bank that was last read into memory.
+ */
 
-#define CHUNKS   16
-#define CHUNK_SZ 0x00100000
-#define FILE_SZ  (CHUNK_SZ * CHUNKS)
+typedef struct DUMP_T {
+	size_t    files;              // Number of files opened
+	size_t    banks;              // Number of banks
+	size_t    bank_sz;            // Bytes in each bank
+	size_t    stripe_sz;          // Bytes read from each bank at a time
+	uint8_t  *buffer;             // "banks" * "stripe_sz" bytes
+	FILE     *fp[MAX_BANKS];      // File each bank is in
+	size_t    base[MAX_BANKS];    // Where in that file the bank starts
+	char     *name[MAX_BANKS];    // Path of that file, if one file per bank
+	uint8_t  *segment[MAX_BANKS]; // Each bank's window into "buffer"
+} dump_t;
+
+// ----------------------------------------------------------------------------
+// Dump Reading Functions                                                  {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * dump_all
+ *
+ * Mask with a bit set for every bank in the dump.
+ */
+
+uint64_t dump_all(dump_t *dump) {
+	return (dump->banks == 64) ? ~0ULL : BANK_BIT(dump->banks) - 1;
+}
+
+/*
+ * dump_stripe_len
+ *
+ * Bytes in the stripe starting at "off". Only the last one can be short.
+ */
+
+size_t dump_stripe_len(dump_t *dump, size_t off) {
+	return (dump->bank_sz - off < dump->stripe_sz)
+		? dump->bank_sz - off
+		: dump->stripe_sz;
+}
+
+/*
+ * dump_read
+ *
+ * Reads "len" bytes at "off" into the segment of every bank set in "mask".
+ * Returns 0 on success.
+ */
+
+int dump_read(dump_t *dump, size_t off, size_t len, uint64_t mask) {
+	size_t i;
+
+	for (i = 0; i < dump->banks; i++) {
+		if (!(mask & BANK_BIT(i)))
+			continue;
+
+		if (
+			fseek(dump->fp[i], dump->base[i] + off, SEEK_SET) != 0 ||
+			fread(dump->segment[i], len, 1, dump->fp[i]) != 1
+		) {
+			fprintf(
+				stderr,
+				"Error: Failed to read bank %lu at 0x%08lX\n",
+				(unsigned long) i,
+				(unsigned long) off
+			);
+
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
+/*
+ * dump_close
+ *
+ * Closes every file in the dump, and frees the stripe buffer.
+ */
+
+void dump_close(dump_t *dump) {
+	size_t i;
+
+	for (i = 0; i < dump->files; i++)
+		fclose(dump->fp[i]);
+
+	free(dump->buffer);
+}
 
 // ----------------------------------------------------------------------------
 // ARDS Checking Functions                                                 {{{1
 // ----------------------------------------------------------------------------
 
+/*
+ * All of these return 0 if every bank is the same, 1 if not, or -1 if the
+ * dump couldn't be read.
+ */
+
 /*
  * ards_linear_check
  *
- * Fast and easy. Go through each 1 MiB segment and check if it's the same as
- * the previous one.
+ * Fast and easy. Go through each stripe and check if every bank is the same
+ * as the previous one. Stops at the first difference.
  */
 
-int ards_linear_check(uint8_t *segment[CHUNKS]) {
-	size_t i;
-	int    status;
+int ards_linear_check(dump_t *dump) {
+	size_t off, len, i;
 
-	for (i = 1; i < CHUNKS; i++) {
-		status = memcmp(segment[i - 1], segment[i], CHUNK_SZ);
+	for (off = 0; off < dump->bank_sz; off += len) {
+		len = dump_stripe_len(dump, off);
 
-		if (status != 0)
-			return status;
+		if (dump_read(dump, off, len, dump_all(dump)) != 0)
+			return -1;
+
+		for (i = 1; i < dump->banks; i++)
+			if (memcmp(dump->segment[i - 1], dump->segment[i], len) != 0)
+				return 1;
 	}
 
-	return status;
+	return 0;
 }
 
 /*
  * ards_square_check
  *
  * More detailed check. Checks 0-1, 0-2, ... 0-15, 1-2, 1-3, ... 1-15, etc.
- * Prints out a chart of differences.
+ * Prints out a chart of differences. A pair is only compared until the first
+ * stripe where it differs, which decides the sign.
  */
 
-int ards_square_check(uint8_t *segment[CHUNKS]) {
-	size_t i, j;
-	int table[CHUNKS][CHUNKS];
+int ards_square_check(dump_t *dump) {
+	size_t off, len, i, j;
+	int    table[MAX_BANKS][MAX_BANKS], status;
+
+	memset(table, 0, sizeof(table));
+
+	// Compare chunk i to every chunk after it (j), a stripe at a time
+	for (off = 0; off < dump->bank_sz; off += len) {
+		len = dump_stripe_len(dump, off);
+
+		if (dump_read(dump, off, len, dump_all(dump)) != 0)
+			return -1;
+
+		for (i = 0; i < dump->banks; i++) {
+			for (j = i + 1; j < dump->banks; j++) {
+				// Only memcmp if we have to
+				if (table[i][j] == 0) {
+					table[i][j] = memcmp(
+						dump->segment[i], dump->segment[j], len
+					);
+				}
+			}
+		}
+	}
 
 	// Top bar
 	printf("    | ");
-	for (i = 0; i < CHUNKS; i++) printf("  %2d%c", i, (i == 15) ? '\n' : ' ');
+	for (i = 0; i < dump->banks; i++)
+		printf(
+			"  %2lu%c",
+			(unsigned long) i,
+			(i == dump->banks - 1) ? '\n' : ' '
+		);
 
 	printf("----+-");
-	for (i = 0; i < CHUNKS; i++) printf("----%c", (i == 15) ? '\n' : '-');
+	for (i = 0; i < dump->banks; i++)
+		printf("----%c", (i == dump->banks - 1) ? '\n' : '-');
 
 	// Data
-	for (i = 0; i < CHUNKS; i++) {
+	for (i = 0, status = 0; i < dump->banks; i++) {
 		// Left column
-		printf(" %2d | ", i);
-
-		// Compare chunk i to every possible one (j)...
-		for (j = 0; j < CHUNKS; j++) {
-			// Only memcmp if we have to
-			if (i == j) {
-				// Assume they are the same
-				table[i][j] = 0;
-			}
-			else if (i > j) {
-				// Skip computed parts (i, j) = -(j, i).
+		printf(" %2lu | ", (unsigned long) i);
+
+		for (j = 0; j < dump->banks; j++) {
+			// Skip computed parts (i, j) = -(j, i).
+			if (i > j)
 				table[i][j] = -table[j][i];
+
+			if (table[i][j] != 0)
+				status = 1;
+
+			// Output to table
+			printf((j != dump->banks - 1) ? "%4d " : "%4d \n", table[i][j]);
+		}
+	}
+
+	return status;
+}
+
+/*
+ * print_banks
+ *
+ * Prints the banks set in "mask" as ranges, like "0-13,15".
+ */
+
+void print_banks(dump_t *dump, uint64_t mask) {
+	size_t i, j;
+	int    first;
+
+	for (i = 0, first = 1; i < dump->banks; i++) {
+		if (!(mask & BANK_BIT(i)))
+			continue;
+
+		// Find the end of this run
+		for (j = i; j + 1 < dump->banks && (mask & BANK_BIT(j + 1)); j++);
+
+		printf("%s%lu", first ? "" : ",", (unsigned long) i);
+
+		if (j > i)
+			printf("-%lu", (unsigned long) j);
+
+		first = 0;
+		i     = j;
+	}
+}
+
+/*
+ * print_bank
+ *
+ * Prints a single bank as "bank 3", followed by its file if every bank is a
+ * file of its own.
+ */
+
+void print_bank(dump_t *dump, size_t i) {
+	printf("bank %lu", (unsigned long) i);
+
+	if (dump->name[i] != NULL)
+		printf(" (%s)", dump->name[i]);
+}
+
+/*
+ * append_runs
+ *
+ * Appends every run in "part", which came from the stripe at "off", onto
+ * "runs". Runs that meet at the edge of the stripe are merged. "part" is
+ * freed.
+ */
+
+void append_runs(CN_VEC runs, CN_VEC part, size_t off) {
+	ar_diff_run_t *run, *last;
+
+	last = (cn_vec_size(runs) != 0)
+		? (ar_diff_run_t *) cn_vec_at(runs, cn_vec_size(runs) - 1)
+		: NULL;
+
+	cn_vec_traverse(part, run) {
+		run->start += off;
+
+		if (
+			last != NULL &&
+			run->start - (last->start + last->len - 1) <= BANKDIFF_GAP
+		) {
+			__bankdiff_merge(last, run);
+		}
+		else {
+			cn_vec_push_back(runs, run);
+			last = (ar_diff_run_t *) cn_vec_at(runs, cn_vec_size(runs) - 1);
+		}
+	}
+
+	cn_vec_free(part);
+}
+
+/*
+ * print_runs
+ *
+ * Prints the total of "runs", then every run in it, as a diff of bank "i"
+ * against "what". Offsets are into the bank's file.
+ */
+
+void print_runs(dump_t *dump, size_t i, const char *what, CN_VEC runs) {
+	ar_diff_run_t *run, total;
+
+	bankdiff_total(runs, &total);
+
+	printf("\n");
+	print_bank(dump, i);
+	printf(
+		" vs %s: %lu runs, %u bytes, %u bits (+%u/-%u)\n",
+		what,
+		(unsigned long) cn_vec_size(runs),
+		total.bytes,
+		total.bits,
+		total.bits_set,
+		total.bits_clr
+	);
+
+	cn_vec_traverse(runs, run) {
+		printf(
+			"  0x%08lX - 0x%08lX: %u bytes, %u bits (+%u/-%u)\n",
+			(unsigned long) (dump->base[i] + run->start),
+			(unsigned long) (dump->base[i] + run->start + run->len - 1),
+			run->bytes,
+			run->bits,
+			run->bits_set,
+			run->bits_clr
+		);
+	}
+}
+
+/*
+ * BANK_CLASSES_T
+ *
+ * Banks grouped into classes of identical ones. Bit "i" of "members[j]" is
+ * set if bank "i" is in class "j". "rep[j]" is the first bank in it.
+ */
+
+typedef struct BANK_CLASSES_T {
+	size_t   num;
+	size_t   rep[MAX_BANKS];
+	uint64_t members[MAX_BANKS];
+} bank_classes_t;
+
+/*
+ * ards_classify
+ *
+ * O(n) per stripe. Every bank starts out in one class. For each stripe, hash
+ * every bank's window once, and split each class up by it. Banks stay
+ * together only if they were in the same class, and their windows have the
+ * same hash and the same bytes (confirmed by one memcmp against the first
+ * bank in the new class). Returns 0 on success.
+ */
+
+int ards_classify(dump_t *dump, bank_classes_t *classes) {
+	uint64_t hash[MAX_BANKS];
+	size_t   cls[MAX_BANKS];
+	size_t   off, len, i, j, r;
+
+	memset(cls, 0, sizeof(cls));
+
+	classes->num        = 1;
+	classes->rep[0]     = 0;
+	classes->members[0] = dump_all(dump);
+
+	for (off = 0; off < dump->bank_sz; off += len) {
+		len = dump_stripe_len(dump, off);
+
+		// Every bank differs already. Nothing left to split.
+		if (classes->num == dump->banks)
+			break;
+
+		if (dump_read(dump, off, len, dump_all(dump)) != 0)
+			return -1;
+
+		for (i = 0; i < dump->banks; i++)
+			hash[i] = ards_hash64(dump->segment[i], len);
+
+		for (i = 0, classes->num = 0; i < dump->banks; i++) {
+			// Class from the same old class, with the same hash and bytes
+			for (j = 0; j < classes->num; j++) {
+				r = classes->rep[j];
+
+				if (
+					cls[r] == cls[i] &&
+					hash[r] == hash[i] &&
+					memcmp(dump->segment[r], dump->segment[i], len) == 0
+				) {
+					break;
+				}
 			}
-			else {
-				// Compute
-				table[i][j] = memcmp(segment[i], segment[j], CHUNK_SZ);
+
+			// None. Start a new one.
+			if (j == classes->num) {
+				classes->rep[j]     = i;
+				classes->members[j] = 0;
+				classes->num++;
 			}
 
-			// Output to table
-			printf((j != 15) ? "%4d " : "%4d \n", table[i][j]);
+			classes->members[j] |= BANK_BIT(i);
+		}
+
+		// Remember the new classes for the next stripe
+		for (j = 0; j < classes->num; j++)
+			for (i = 0; i < dump->banks; i++)
+				if (classes->members[j] & BANK_BIT(i))
+					cls[i] = j;
+	}
+
+	return 0;
+}
+
+/*
+ * print_classes
+ *
+ * Prints every class in "classes" on one line.
+ */
+
+void print_classes(dump_t *dump, bank_classes_t *classes) {
+	size_t j;
+
+	for (j = 0; j < classes->num; j++) {
+		if (classes->members[j] & (classes->members[j] - 1)) {
+			printf("banks ");
+			print_banks(dump, classes->members[j]);
+			printf(" identical");
+		}
+		else {
+			printf("bank ");
+			print_banks(dump, classes->members[j]);
+			printf(" differs");
 		}
+
+		printf("%s", (j + 1 < classes->num) ? "; " : "\n");
 	}
 }
 
+/*
+ * ards_class_check
+ *
+ * Finds the classes of identical banks and prints them.
+ */
+
+int ards_class_check(dump_t *dump) {
+	bank_classes_t classes;
+
+	if (ards_classify(dump, &classes) != 0)
+		return -1;
+
+	print_classes(dump, &classes);
+
+	return classes.num != 1;
+}
+
+/*
+ * ards_diff_check
+ *
+ * Prints the classes, then diffs every bank outside of the biggest class
+ * against that class's first bank, and prints each run of differing bytes.
+ * Offsets are into the file. Every stripe is diffed separately, and runs
+ * that meet at the edge of a stripe are merged.
+ */
+
+int ards_diff_check(dump_t *dump, size_t threads) {
+	bank_classes_t  classes;
+	CN_VEC          runs[MAX_BANKS];
+	uint64_t        mask;
+	size_t          off, len, i, j, best, ref;
+	char            what[32];
+	int             status;
+
+	// Print the classes first, and find the reference
+	if (ards_classify(dump, &classes) != 0)
+		return -1;
+
+	print_classes(dump, &classes);
+
+	for (j = 1, best = 0; j < classes.num; j++) {
+		if (
+			__builtin_popcountll(classes.members[j]) >
+			__builtin_popcountll(classes.members[best])
+		) {
+			best = j;
+		}
+	}
+
+	ref  = classes.rep[best];
+	mask = dump_all(dump) & ~classes.members[best];
+
+	for (i = 0; i < dump->banks; i++)
+		if (mask & BANK_BIT(i))
+			runs[i] = cn_vec_init(ar_diff_run_t);
+
+	// Only the reference and the banks that differ from it need reading
+	for (off = 0, status = 0; off < dump->bank_sz && mask; off += len) {
+		len = dump_stripe_len(dump, off);
+
+		if (dump_read(dump, off, len, mask | BANK_BIT(ref)) != 0) {
+			status = -1;
+			break;
+		}
+
+		for (i = 0; i < dump->banks; i++) {
+			if (!(mask & BANK_BIT(i)))
+				continue;
+
+			append_runs(
+				runs[i],
+				bankdiff(
+					dump->segment[ref], dump->segment[i], len, 0, threads
+				),
+				off
+			);
+		}
+	}
+
+	sprintf(what, "bank %lu", (unsigned long) ref);
+
+	for (i = 0; i < dump->banks; i++) {
+		if (!(mask & BANK_BIT(i)))
+			continue;
+
+		if (status == 0)
+			print_runs(dump, i, what, runs[i]);
+
+		cn_vec_free(runs[i]);
+	}
+
+	if (status != 0)
+		return status;
+
+	return classes.num != 1;
+}
+
+/*
+ * open_image
+ *
+ * Opens "path" to write a repaired image to. NULL paths give NULL back
+ * quietly. Failing to open one is reported.
+ */
+
+FILE *open_image(const char *path) {
+	FILE *fp;
+
+	if (path == NULL)
+		return NULL;
+
+	fp = fopen(path, "wb");
+
+	if (!fp) {
+		fprintf(
+			stderr,
+			"Error: Failed to open \"%s\": %s\n",
+			path,
+			strerror(errno)
+		);
+	}
+
+	return fp;
+}
+
+/*
+ * ards_vote_repair
+ *
+ * Votes on every byte across all banks, a stripe at a time, and writes the
+ * result to "bank_path" (one bank) and/or "dump_path" (every bank),
+ * whichever aren't NULL. When each bank is a file of its own, a full dump is
+ * one bank, so both get the same image. Offsets with no clear majority are
+ * printed as runs, relative to the start of a bank. Then every bank is
+ * diffed against the vote, and the one that disagrees with it the most is
+ * named, if no other bank disagrees as much. Returns 0 if every byte had a
+ * clear majority, 1 if not, or -1 if the dump couldn't be read or an image
+ * couldn't be written.
+ */
+
+int ards_vote_repair(
+	dump_t     *dump,
+	const char *bank_path,
+	const char *dump_path,
+	size_t      threads
+) {
+	uint8_t       *image;
+	CN_VEC         unclear, runs[MAX_BANKS];
+	FILE          *bank_fp, *dump_fp;
+	ar_diff_run_t  total;
+	uint32_t      *at, start, end;
+	size_t         off, len, differ, i, num, worst, worst_bytes;
+	size_t         copies;
+	int            status, tied;
+
+	bank_fp = open_image(bank_path);
+	dump_fp = open_image(dump_path);
+
+	if ((bank_path && !bank_fp) || (dump_path && !dump_fp)) {
+		if (bank_fp) fclose(bank_fp);
+		if (dump_fp) fclose(dump_fp);
+
+		return -1;
+	}
+
+	image   = (uint8_t *) malloc(dump->stripe_sz);
+	unclear = cn_vec_init(uint32_t);
+	differ  = 0;
+	status  = 0;
+	copies  = (dump->files > 1) ? 1 : dump->banks;
+
+	for (i = 0; i < dump->banks; i++)
+		runs[i] = cn_vec_init(ar_diff_run_t);
+
+	for (off = 0; off < dump->bank_sz && status == 0; off += len) {
+		len = dump_stripe_len(dump, off);
+
+		if (dump_read(dump, off, len, dump_all(dump)) != 0) {
+			status = -1;
+			break;
+		}
+
+		num     = cn_vec_size(unclear);
+		differ += bankdiff_vote(
+			(const uint8_t **) dump->segment, dump->banks, len, image, unclear
+		);
+
+		// Offsets from bankdiff_vote are into this stripe
+		for (i = num; i < cn_vec_size(unclear); i++) {
+			at   = (uint32_t *) cn_vec_at(unclear, i);
+			*at += off;
+		}
+
+		// Where each bank disagrees with the vote
+		for (i = 0; i < dump->banks; i++) {
+			append_runs(
+				runs[i],
+				bankdiff(image, dump->segment[i], len, 0, threads),
+				off
+			);
+		}
+
+		if (bank_fp && fwrite(image, len, 1, bank_fp) != 1)
+			status = -1;
+
+		for (i = 0; dump_fp && i < copies && status == 0; i++) {
+			if (
+				fseek(dump_fp, i * dump->bank_sz + off, SEEK_SET) != 0 ||
+				fwrite(image, len, 1, dump_fp) != 1
+			) {
+				status = -1;
+			}
+		}
+
+		if (status != 0)
+			fprintf(stderr, "Error: Failed to write the repaired image\n");
+	}
+
+	if (bank_fp && fclose(bank_fp) != 0)
+		status = -1;
+
+	if (dump_fp && fclose(dump_fp) != 0)
+		status = -1;
+
+	if (status == 0) {
+		num = cn_vec_size(unclear);
+
+		printf(
+			"%lu bytes differ between banks, %lu repaired, %lu without a "
+			"clear majority\n",
+			(unsigned long) differ,
+			(unsigned long) (differ - num),
+			(unsigned long) num
+		);
+
+		// Print unclear offsets, merged into runs
+		for (i = 0; i < num; i++) {
+			at    = (uint32_t *) cn_vec_at(unclear, i);
+			start = *at;
+			end   = *at;
+
+			for (; i + 1 < num; i++) {
+				at = (uint32_t *) cn_vec_at(unclear, i + 1);
+
+				if (*at != end + 1)
+					break;
+
+				end = *at;
+			}
+
+			printf(
+				"  0x%06lX - 0x%06lX: %lu bytes\n",
+				(unsigned long) start,
+				(unsigned long) end,
+				(unsigned long) (end - start + 1)
+			);
+		}
+
+		// Every bank against the vote. Name the worst one, if there's a
+		// clear worst. With only 2 banks, there's no telling which is off.
+		worst       = 0;
+		worst_bytes = 0;
+		tied        = 0;
+
+		for (i = 0; i < dump->banks; i++) {
+			print_runs(dump, i, "vote", runs[i]);
+			bankdiff_total(runs[i], &total);
+
+			if (total.bytes > worst_bytes) {
+				worst       = i;
+				worst_bytes = total.bytes;
+				tied        = 0;
+			}
+			else
+			if (total.bytes == worst_bytes) {
+				tied = 1;
+			}
+		}
+
+		if (worst_bytes != 0 && !tied && dump->banks > 2) {
+			printf("\nOutlier: ");
+			print_bank(dump, worst);
+			printf(", %lu bytes off the vote\n", (unsigned long) worst_bytes);
+		}
+
+		status = (num != 0);
+	}
+
+	for (i = 0; i < dump->banks; i++)
+		cn_vec_free(runs[i]);
+
+	cn_vec_free(unclear);
+	free(image);
+
+	return status;
+}
+
 // ----------------------------------------------------------------------------
 // Basic Argument Parser                                                   {{{1
 // ----------------------------------------------------------------------------
 
 typedef struct ARGS_T {
 	uint8_t flag_quick_quiet;
+	uint8_t flag_classes;
+	uint8_t flag_diff;
+	uint8_t flag_vote;
+	size_t  threads;
+	size_t  bank_sz;
+	size_t  banks;
+	size_t  num_paths;
+	char   *paths[MAX_BANKS];
+	char   *repair_bank;
+	char   *repair_dump;
 } args_t;
 
 void print_help(int argc, char **argv) {
-	printf("usage: %s [-hq] IN_ARDS.nds\n", argv[0]);
+	printf(
+		"usage: %s [-cdhqv] [-b BANK_SZ] [-n BANKS] [-j THREADS] [-r OUT] "
+		"[-R OUT]\n       IN_ARDS.nds [MORE_ARDS.nds ...]\n",
+		argv[0]
+	);
 	printf("Memory evaluation utility for an Action Replay DS ROM "
 		"dump.\n\n");
 
+	printf("Given more than one file, each file is one bank, and \"-v\" "
+		"is the default.\n\n");
+
 	printf("Optional arguments are:\n\n");
 
+	printf("\t-b\tBank size in bytes (\"0x100000\" works too). Defaults "
+		"to 1 MiB, or\n\t\tthe file size over \"-n\" if that was "
+		"given.\n\n");
+
+	printf("\t-c\tClasses. Hash each bank once, group identical banks, "
+		"and\n\t\tprint the groups (\"banks 0-13,15 identical; bank 14 "
+		"differs\").\n\t\tExit status is the same as the other "
+		"methods.\n\n");
+
+	printf("\t-d\tDiff. Same as \"-c\", then compare every bank outside "
+		"the biggest\n\t\tgroup against it, and print each run of "
+		"differing bytes, with how\n\t\tmany bits went from 0 to 1 (+) "
+		"and 1 to 0 (-).\n\n");
+
 	printf("\t-h\tPrints this help prompt in the terminal and then "
 		"terminates.\n\n");
 
+	printf("\t-j\tThreads to diff with in \"-d\" and \"-v\". Defaults to "
+		"the number of\n\t\tCPUs.\n\n");
+
+	printf("\t-n\tNumber of banks. Defaults to the file size over the "
+		"bank size.\n\n");
+
 	printf("\t-q\tQuick (and quiet). Instead of O(n^2) memory comparisons, "
 		"perform O(n)\n\t\tcomparisons and quit the instant a check fails. "
 		"Exit status will be\n\t\tpersistent with the non-quick method.\n\n");
 
+	printf("\t-r\tRepair. Same as \"-v\", and write the result to OUT "
+		"as a single bank.\n\t\tWith more than one file, that's the "
+		"consensus of all of them.\n\n");
+
+	printf("\t-R\tSame as \"-r\", but write OUT as a full dump, with the "
+		"repaired bank\n\t\tin every bank. Can be used with \"-r\". "
+		"With more than one file,\n\t\tthat's the same as \"-r\", since "
+		"each file is a full dump.\n\n");
+
+	printf("\t-v\tVote on every byte across all banks. Offsets with no "
+		"clear majority\n\t\tare printed, then every run where each "
+		"bank disagrees with the\n\t\tvote, and the bank that disagrees "
+		"the most. Exit status is 1 if\n\t\tany offset had no clear "
+		"majority.\n\n");
+
 	exit(0);
 }
 
 void parse_flags(int argc, char **argv, args_t *obj) {
-	int i, j, len;
+	int    i, j, len;
+	char **path, *val, flag;
 
 	// Defaults
 	obj->flag_quick_quiet = 0;
+	obj->flag_classes     = 0;
+	obj->flag_diff        = 0;
+	obj->flag_vote        = 0;
+	obj->threads          = 0;
+	obj->bank_sz          = 0;
+	obj->banks            = 0;
+	obj->num_paths        = 0;
+	obj->repair_bank      = NULL;
+	obj->repair_dump      = NULL;
 
 	// Go through every argument and read characters
 	for (i = 1; i < argc; i++) {
-		// Skip if not a valid flag header
-		if (argv[i][0] != '-')
+		// Arguments without a "-" are filenames
+		if (argv[i][0] != '-') {
+			if (obj->num_paths < MAX_BANKS)
+				obj->paths[obj->num_paths] = argv[i];
+			else
+				fprintf(
+					stderr,
+					"WARN: Too many files (max %d). Ignoring \"%s\"...\n",
+					MAX_BANKS,
+					argv[i]
+				);
+
+			obj->num_paths++;
 			continue;
+		}
 
 		len = strlen(argv[i]);
 		for (j = 1; j < len; j++) {
-			switch (argv[i][j]) {
+			flag = argv[i][j];
+
+			switch (flag) {
 				case 'q':
 					// Allow duplicate games
 					obj->flag_quick_quiet = 1;
 					break;
 
+				case 'c':
+					// Equivalence classes
+					obj->flag_classes = 1;
+					break;
+
+				case 'd':
+					// Diff against the biggest class
+					obj->flag_diff = 1;
+					break;
+
+				case 'v':
+					// Vote on every byte
+					obj->flag_vote = 1;
+					break;
+
+				case 'j':
+					// Thread count. Either "-j4" or "-j 4".
+					if (j + 1 < len)
+						obj->threads = strtoul(&argv[i][j + 1], NULL, 10);
+					else
+					if (i + 1 < argc)
+						obj->threads = strtoul(argv[++i], NULL, 10);
+
+					j = len;
+					break;
+
+				case 'b':
+				case 'n':
+					// Bank size or count. Either "-n16" or "-n 16".
+					val = NULL;
+
+					if (j + 1 < len)
+						val = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						val = argv[++i];
+
+					if (val != NULL && flag == 'b')
+						obj->bank_sz = strtoul(val, NULL, 0);
+					else
+					if (val != NULL)
+						obj->banks = strtoul(val, NULL, 0);
+
+					j = len;
+					break;
+
+				case 'r':
+				case 'R':
+					// Repaired image. Either "-rOUT" or "-r OUT".
+					path = (flag == 'r')
+						? &obj->repair_bank
+						: &obj->repair_dump;
+
+					if (j + 1 < len)
+						*path = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						*path = argv[++i];
+
+					j = len;
+					break;
+
 				case 'h':
 					// Shows help prompt and terminate
 					print_help(argc, argv);
@@ -160,7 +968,12 @@ void parse_flags(int argc, char **argv, args_t *obj) {
 int main(int argc, char **argv) {
 	// Argument check
 	if (argc < 2) {
-		fprintf(stderr, "usage: %s [-hq] IN_ARDS.nds\n", argv[0]);
+		fprintf(
+			stderr,
+			"usage: %s [-cdhqv] [-b BANK_SZ] [-n BANKS] [-j THREADS] [-r OUT] "
+			"[-R OUT]\n       IN_ARDS.nds [MORE_ARDS.nds ...]\n",
+			argv[0]
+		);
 
 		return 1;
 	}
@@ -170,63 +983,159 @@ int main(int argc, char **argv) {
 
 	parse_flags(argc, argv, &args);
 
-	size_t   i;
-	size_t   fsz;
-	int      status;
-	uint8_t *buffer;
-	uint8_t *segment[CHUNKS];
-	FILE    *fp;
+	size_t  i;
+	size_t  fsz;
+	int     status;
+	dump_t  dump;
 
-	// Setup file for traversal
-	// The first argument without a "-" is the filename.
-	for (i = 1; i < argc; i++) {
-		if (argv[i][0] != '-')
-			break;
+	// Setup files for traversal
+	if (args.num_paths == 0) {
+		fprintf(stderr, "Error: No file was given\n");
+		return 1;
 	}
 
-	fp = fopen(argv[i], "rb");
+	if (args.num_paths > MAX_BANKS)
+		args.num_paths = MAX_BANKS;
 
-	if (!fp) {
-		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
-		return 3;
+	dump.buffer = NULL;
+
+	for (dump.files = 0; dump.files < args.num_paths; dump.files++) {
+		dump.fp[dump.files] = fopen(args.paths[dump.files], "rb");
+
+		if (!dump.fp[dump.files]) {
+			fprintf(
+				stderr,
+				"Error: Failed to open \"%s\": %s\n",
+				args.paths[dump.files],
+				strerror(errno)
+			);
+
+			dump_close(&dump);
+			return 3;
+		}
+
+		fseek(dump.fp[dump.files], 0, SEEK_END);
+		dump.base[dump.files] = ftell(dump.fp[dump.files]);
+		fseek(dump.fp[dump.files], 0, SEEK_SET);
+
+		// Repeated reads of one cartridge have to be the same size
+		if (dump.base[dump.files] != dump.base[0]) {
+			fprintf(
+				stderr,
+				"Error: \"%s\" is %lu bytes, but \"%s\" is %lu bytes\n",
+				args.paths[dump.files],
+				(unsigned long) dump.base[dump.files],
+				args.paths[0],
+				(unsigned long) dump.base[0]
+			);
+
+			dump.files++;
+			dump_close(&dump);
+			return 2;
+		}
 	}
 
-	// Check if file is exactly 16 MiB
-	fseek(fp, 0, SEEK_END);
-	fsz = ftell(fp);
-	fseek(fp, 0, SEEK_SET);
+	fsz = dump.base[0];
 
-	if (fsz != FILE_SZ) {
-		fprintf(
-			stderr,
-			"Error: File size is not %d bytes (got %d bytes instead)\n",
-			FILE_SZ,
-			fsz
-		);
+	if (dump.files > 1) {
+		// Every file is a bank of its own, read straight through
+		if (args.bank_sz != 0 || args.banks != 0)
+			fprintf(
+				stderr,
+				"WARN: \"-b\" and \"-n\" do nothing with more than one "
+				"file. Ignoring...\n"
+			);
 
-		fclose(fp);
-		return 2;
+		dump.banks   = dump.files;
+		dump.bank_sz = fsz;
+
+		for (i = 0; i < dump.banks; i++) {
+			dump.base[i] = 0;
+			dump.name[i] = args.paths[i];
+
+			posix_fadvise(
+				fileno(dump.fp[i]), 0, 0, POSIX_FADV_SEQUENTIAL
+			);
+		}
 	}
+	else {
+		// Work out the bank geometry from whatever wasn't given
+		dump.bank_sz = args.bank_sz;
+		dump.banks   = args.banks;
+
+		if (dump.bank_sz == 0)
+			dump.bank_sz = (dump.banks != 0) ? fsz / dump.banks : CHUNK_SZ;
 
-	// Memory hack
-	buffer = (uint8_t *) malloc(FILE_SZ);
+		if (dump.banks == 0 && dump.bank_sz != 0)
+			dump.banks = fsz / dump.bank_sz;
 
-	for (i = 0; i < CHUNKS; i++)
-		segment[i] = buffer + (CHUNK_SZ * i);
+		if (
+			dump.bank_sz == 0 || dump.banks < 2 || dump.banks > MAX_BANKS ||
+			dump.banks * dump.bank_sz != fsz
+		) {
+			fprintf(
+				stderr,
+				"Error: File size (%lu bytes) is not 2 to %d banks of %lu "
+				"bytes each\n",
+				(unsigned long) fsz,
+				MAX_BANKS,
+				(unsigned long) dump.bank_sz
+			);
 
-	// Read in all bytes
-	fread(buffer, FILE_SZ, 1, fp);
+			dump_close(&dump);
+			return 2;
+		}
 
-	fclose(fp);
+		for (i = 0; i < dump.banks; i++) {
+			dump.fp[i]   = dump.fp[0];
+			dump.base[i] = i * dump.bank_sz;
+			dump.name[i] = NULL;
+		}
+	}
+
+	if (fsz == 0) {
+		fprintf(stderr, "Error: The files are empty\n");
+		dump_close(&dump);
+		return 2;
+	}
+
+	// One stripe of every bank is all that's ever in memory
+	dump.stripe_sz = (dump.bank_sz < STRIPE_SZ) ? dump.bank_sz : STRIPE_SZ;
+	dump.buffer    = (uint8_t *) malloc(dump.banks * dump.stripe_sz);
+
+	for (i = 0; i < dump.banks; i++)
+		dump.segment[i] = dump.buffer + (dump.stripe_sz * i);
 
 	// Evaluate based on method
+	if (
+		args.flag_vote ||
+		args.repair_bank != NULL || args.repair_dump != NULL
+	) {
+		status = ards_vote_repair(
+			&dump, args.repair_bank, args.repair_dump, args.threads
+		);
+	}
+	else
+	if (args.flag_diff)
+		status = ards_diff_check(&dump, args.threads);
+	else
+	if (args.flag_classes)
+		status = ards_class_check(&dump);
+	else
 	if (args.flag_quick_quiet)
-		status = ards_linear_check(segment);
+		status = ards_linear_check(&dump);
+	else
+	if (dump.files > 1)
+		status = ards_vote_repair(&dump, NULL, NULL, args.threads);
 	else
-		status = ards_square_check(segment);
+		status = ards_square_check(&dump);
 
 	// Clean up
-	free(buffer);
+	dump_close(&dump);
+
+	// Couldn't read the dump or write the repaired image
+	if (status < 0)
+		return 3;
 
 	// 0 = All same. 1 = Differences exist.
 	return !!status;
@@ -0,0 +1,107 @@
+/*
+ * ARDS R4-to-XML Converter
+ *
+ * Description:
+ *     Given an R4 "usrcheat.dat", export games in it as an XML codelist, the
+ *     same as "ards_game_to_xml" does for an Action Replay DS ROM dump.
+ *
+ *     Games are picked by their Game ID (XXXX-XXXXXXXX), and are looked up in
+ *     the index of the file, so only the requested games are read. If no Game
+ *     IDs are given, every game in the file is exported.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/r4.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	// Argument check
+	if (argc < 2) {
+		fprintf(
+			stderr,
+			"usage: %s usrcheat.dat [GAME_ID1 [GAME_ID2 [...]]]\n",
+			argv[0]
+		);
+
+		return 1;
+	}
+
+	FILE      *fp;       // File Pointer
+	CN_VEC     games;    // ARDS Game Object Vector
+	ARDS_GAME  game,     // Game being read
+	          *it;       // Iterator
+	uint32_t   N_CRC32;  // Right side of the Game ID
+	size_t     i;        // Loop counter
+	int        status;   // Exit status
+
+	fp = fopen(argv[1], "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
+		return 2;
+	}
+
+	status = 0;
+
+	if (argc == 2) {
+		// Everything
+		games = ards_game_import_all_from_r4(fp);
+	}
+	else {
+		// Only the games asked for
+		games = cn_vec_init(ARDS_GAME);
+
+		for (i = 2; i < argc; i++) {
+			if (
+				strlen(argv[i]) != 13 || argv[i][4] != '-' ||
+				sscanf(&argv[i][5], "%8x", &N_CRC32) != 1
+			) {
+				fprintf(stderr, "Error: Invalid Game ID \"%s\"\n", argv[i]);
+				status = 3;
+				continue;
+			}
+
+			game = ards_game_import_from_r4(fp, argv[i], N_CRC32);
+
+			if (game == NULL) {
+				fprintf(stderr, "Error: Game \"%s\" not found\n", argv[i]);
+				status = 3;
+				continue;
+			}
+
+			cn_vec_push_back(games, &game);
+		}
+	}
+
+	// Close the file. We're done reading it
+	fclose(fp);
+
+	// Print everything out
+	ards_game_export_as_xml(games, stdout);
+
+	// Clean up all CNDS instances
+	cn_vec_traverse(games, it)
+		ards_game_free(*it);
+
+	cn_vec_free(games);
+
+	//We're done here
+	return status;
+}
@@ -0,0 +1,544 @@
+/*
+ * ARDS ROM Match
+ *
+ * Description:
+ *     Given a library of NDS ROMs and one or more Action Replay DS ROM dumps,
+ *     find which games in the dumps have cheats for each ROM.
+ *
+ *     The Game ID of every ROM is computed first, and packed into a 64-bit
+ *     key (the 4 character ID, and the ~CRC32). Those go into a hash table.
+ *     Each dump is then scanned for game headers, and each header's key is
+ *     looked up. Only the name of a game that matched is read. Codes are
+ *     never decoded. Every game that matched is printed, so a ROM whose
+ *     game is in several dumps (or in one more than once) gets a line for
+ *     each.
+ *
+ *     Directories are walked for files ending in ".nds". Files given
+ *     directly are always used.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// Needed for nftw and strcasecmp
+#define _GNU_SOURCE
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <ftw.h>
+#include <sys/stat.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/gameid.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// Where games can start in each 1 MiB chunk of a dump
+#define CHUNK_SZ    0x00100000
+#define GAMES_START 0x00054000
+
+// ----------------------------------------------------------------------------
+// ROM Data Structs                                                        {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * ROM_T
+ *
+ * A ROM from the library.
+ */
+
+typedef struct ROM_T {
+	char     *path;
+	char      gameid[14]; // XXXX-XXXXXXXX + NULL
+	uint64_t  key;        // ID << 32 | ~CRC32
+	int32_t   next;       // Next ROM with the same key, or -1
+} rom_t;
+
+/*
+ * MATCH_T
+ *
+ * A game in a dump that has cheats for a ROM.
+ */
+
+typedef struct MATCH_T {
+	char     *dump;
+	uint32_t  offset;
+	uint16_t  num_codes;
+	char     *name;
+} match_t;
+
+/*
+ * SLOT_T
+ *
+ * A hash table slot. "rom" is the first ROM with "key", or -1 if empty. Every
+ * game in the dumps that matched "key" is kept here too, in the order they
+ * were found.
+ */
+
+typedef struct SLOT_T {
+	uint64_t  key;
+	int32_t   rom;
+	CN_VEC    matches;    // match_t. NULL until the first one.
+} slot_t;
+
+/*
+ * TABLE_T
+ *
+ * Open addressing hash table of ROM keys, with linear probing.
+ */
+
+typedef struct TABLE_T {
+	slot_t *slots;
+	size_t  bits;
+} table_t;
+
+// The ROM list that the directory walk adds to. nftw has no user pointer.
+CN_VEC walk_roms;
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t   flag_matches_only,
+	          flag_misses_only;
+	char    **roms;
+	size_t    num_roms;
+	char    **dumps;
+	size_t    num_dumps;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf("usage: %s [-hmu] ROM_PATH [...] -- IN_ARDS.nds [...]\n", argv[0]);
+	printf("Finds which games in Action Replay DS ROM dumps have cheats for "
+		"each ROM.\n\n");
+
+	printf("Every ROM is printed as a line of tab-separated values:\n\n");
+	printf("\tMATCH  ROM  GAME_ID  DUMP  OFFSET  NUM_CODES  NAME\n");
+	printf("\tMISS   ROM  GAME_ID\n\n");
+
+	printf("A ROM with cheats in more than one place gets a MATCH line for "
+		"each.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-m\tOnly print matches.\n\n");
+
+	printf("\t-u\tOnly print misses (unmatched ROMs).\n\n");
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int     i, j, len;
+	uint8_t after_sep;
+
+	// Defaults
+	obj->flag_matches_only = 0;
+	obj->flag_misses_only  = 0;
+	obj->roms              = (char **) malloc(sizeof(char *) * argc);
+	obj->num_roms          = 0;
+	obj->dumps             = (char **) malloc(sizeof(char *) * argc);
+	obj->num_dumps         = 0;
+
+	// Go through every argument and read characters
+	for (i = 1, after_sep = 0; i < argc; i++) {
+		// ROMs before "--", dumps after
+		if (!after_sep && strcmp(argv[i], "--") == 0) {
+			after_sep = 1;
+			continue;
+		}
+
+		if (after_sep || argv[i][0] != '-') {
+			if (after_sep)
+				obj->dumps[obj->num_dumps++] = argv[i];
+			else
+				obj->roms[obj->num_roms++] = argv[i];
+
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				case 'm':
+					// Matches only
+					obj->flag_matches_only = 1;
+					break;
+
+				case 'u':
+					// Misses only
+					obj->flag_misses_only = 1;
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+}
+
+// ----------------------------------------------------------------------------
+// Hash Table Functions                                                    {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * make_key
+ *
+ * Packs a 4 character ID and ~CRC32 into a single 64-bit key.
+ */
+
+uint64_t make_key(const char *id, uint32_t n_crc32) {
+	uint32_t packed;
+
+	memcpy(&packed, id, 4);
+	return ((uint64_t) packed << 32) | n_crc32;
+}
+
+/*
+ * table_find
+ *
+ * Returns the slot "key" is in, or the empty slot it would go in.
+ */
+
+slot_t *table_find(table_t *table, uint64_t key) {
+	size_t mask, i;
+
+	mask = ((size_t) 1 << table->bits) - 1;
+	i    = (key * 0x9E3779B97F4A7C15ULL) >> (64 - table->bits);
+
+	while (table->slots[i].rom != -1 && table->slots[i].key != key)
+		i = (i + 1) & mask;
+
+	return &table->slots[i];
+}
+
+/*
+ * table_build
+ *
+ * Puts every ROM in "roms" into a table at most half full. ROMs with the same
+ * key share a slot and are chained together.
+ */
+
+void table_build(table_t *table, CN_VEC roms) {
+	size_t  i, num;
+	rom_t  *rom;
+	slot_t *slot;
+
+	num = cn_vec_size(roms);
+
+	for (table->bits = 4; ((size_t) 1 << table->bits) < num * 2; table->bits++);
+
+	table->slots = (slot_t *) calloc(
+		(size_t) 1 << table->bits,
+		sizeof(slot_t)
+	);
+
+	for (i = 0; i < ((size_t) 1 << table->bits); i++)
+		table->slots[i].rom = -1;
+
+	// Backwards, so each chain ends up in the order ROMs were found
+	for (i = num; i > 0; i--) {
+		rom  = (rom_t *) cn_vec_at(roms, i - 1);
+		slot = table_find(table, rom->key);
+
+		rom->next  = slot->rom;
+		slot->key  = rom->key;
+		slot->rom  = i - 1;
+	}
+}
+
+// ----------------------------------------------------------------------------
+// ROM Library Functions                                                   {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * add_rom
+ *
+ * Computes the Game ID of the ROM at "path" and adds it to "roms". Files that
+ * can't be read are reported and skipped.
+ */
+
+void add_rom(CN_VEC roms, const char *path) {
+	uint8_t buffer[GAMEID_HEADER_SZ];
+	rom_t   rom;
+	int     fd, status;
+
+	fd = open(path, O_RDONLY);
+
+	if (fd < 0) {
+		fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+		return;
+	}
+
+	status = get_gameid_fd(fd, buffer, rom.gameid);
+	close(fd);
+
+	if (status != 0) {
+		fprintf(
+			stderr,
+			"Error: %s: %s\n",
+			path,
+			(status > 0) ? "Too short to be a ROM" : strerror(errno)
+		);
+
+		return;
+	}
+
+	rom.path = strdup(path);
+	rom.key  = make_key(&rom.gameid[0], strtoul(&rom.gameid[5], NULL, 16));
+	rom.next = -1;
+
+	cn_vec_push_back(roms, &rom);
+}
+
+/*
+ * walk_cb
+ *
+ * nftw callback. Adds every ".nds" file to "walk_roms".
+ */
+
+int walk_cb(
+	const char        *path,
+	const struct stat *st,
+	int                type,
+	struct FTW        *ftw
+) {
+	size_t len;
+
+	len = strlen(path);
+
+	if (
+		type == FTW_F && S_ISREG(st->st_mode) &&
+		len > 4 && strcasecmp(&path[len - 4], ".nds") == 0
+	) {
+		add_rom(walk_roms, path);
+	}
+
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Dump Scanning Functions                                                 {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * scan_dump
+ *
+ * Reads the dump at "path" into memory, and looks every game header in it up
+ * in "table". Returns 0 on success, or 1 if the dump couldn't be read.
+ */
+
+int scan_dump(table_t *table, char *path) {
+	FILE           *fp;
+	uint8_t        *buf;
+	size_t          sz, pos, text, end;
+	ar_game_info_t  header;
+	slot_t         *slot;
+	match_t         match;
+
+	fp = fopen(path, "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: %s: %s\n", path, strerror(errno));
+		return 1;
+	}
+
+	fseek(fp, 0, SEEK_END);
+	sz = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	buf = (uint8_t *) malloc(sz + 1);
+
+	if (fread(buf, sizeof(uint8_t), sz, fp) != sz) {
+		fprintf(stderr, "Error: %s: Failed to read file\n", path);
+		fclose(fp);
+		free(buf);
+		return 1;
+	}
+
+	fclose(fp);
+
+	for (pos = 0; pos + sizeof(ar_game_info_t) <= sz; pos++) {
+		// Games are only past 0x54000 in each 1 MiB chunk
+		if ((pos & (CHUNK_SZ - 1)) < GAMES_START) {
+			pos = (pos & ~(size_t) (CHUNK_SZ - 1)) | GAMES_START;
+			pos--;
+			continue;
+		}
+
+		// Cheap check of the magic number before anything else
+		if (buf[pos] != 0x01 || buf[pos + 2] != 0x1C || buf[pos + 6] != 0x20)
+			continue;
+
+		memcpy(&header, &buf[pos], sizeof(ar_game_info_t));
+
+		if (header.magic != 0x001C0001 || header.nx20 != 0x0020)
+			continue;
+
+		// The join. Games nobody has a ROM for are skipped right here.
+		slot = table_find(table, make_key(header.ID, header.N_CRC32));
+
+		if (slot->rom == -1)
+			continue;
+
+		// The name is the first string of the text
+		match.dump      = path;
+		match.offset    = pos;
+		match.num_codes = header.num_codes;
+		match.name      = NULL;
+
+		text = pos + header.offset_text + 1;
+
+		if (header.offset_text < sz && text < sz) {
+			for (end = text; end < sz && buf[end] != 0; end++);
+
+			match.name = (char *) malloc(end - text + 1);
+			memcpy(match.name, &buf[text], end - text);
+			match.name[end - text] = 0;
+		}
+
+		if (slot->matches == NULL)
+			slot->matches = cn_vec_init(match_t);
+
+		cn_vec_push_back(slot->matches, &match);
+	}
+
+	free(buf);
+	return 0;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	args_t       args;
+	CN_VEC       roms;
+	table_t      table;
+	rom_t       *rom;
+	slot_t      *slot;
+	match_t     *match;
+	struct stat  st;
+	size_t       i, matched;
+	int          status;
+
+	parse_flags(argc, argv, &args);
+
+	// Argument check
+	if (args.num_roms == 0 || args.num_dumps == 0) {
+		fprintf(
+			stderr,
+			"usage: %s [-hmu] ROM_PATH [...] -- IN_ARDS.nds [...]\n",
+			argv[0]
+		);
+
+		return 1;
+	}
+
+	// Game IDs of every ROM
+	roms      = cn_vec_init(rom_t);
+	walk_roms = roms;
+	status    = 0;
+
+	for (i = 0; i < args.num_roms; i++) {
+		// A file given directly is used, whatever it's called
+		if (stat(args.roms[i], &st) == 0 && S_ISREG(st.st_mode)) {
+			add_rom(roms, args.roms[i]);
+			continue;
+		}
+
+		if (nftw(args.roms[i], walk_cb, 64, FTW_PHYS) != 0) {
+			fprintf(stderr, "Error: %s: %s\n", args.roms[i], strerror(errno));
+			status = 2;
+		}
+	}
+
+	table_build(&table, roms);
+
+	// Join against every dump
+	for (i = 0; i < args.num_dumps; i++) {
+		if (scan_dump(&table, args.dumps[i]) != 0)
+			status = 2;
+	}
+
+	// Print every ROM, in the order they were found
+	matched = 0;
+
+	cn_vec_traverse(roms, rom) {
+		slot = table_find(&table, rom->key);
+
+		if (slot->matches != NULL) {
+			matched++;
+
+			if (args.flag_misses_only)
+				continue;
+
+			cn_vec_traverse(slot->matches, match) {
+				printf(
+					"MATCH\t%s\t%s\t%s\t0x%08x\t%u\t%s\n",
+					rom->path,
+					rom->gameid,
+					match->dump,
+					match->offset,
+					match->num_codes,
+					(match->name != NULL) ? match->name : ""
+				);
+			}
+		}
+		else
+		if (!args.flag_matches_only) {
+			printf("MISS\t%s\t%s\n", rom->path, rom->gameid);
+		}
+	}
+
+	fprintf(
+		stderr,
+		"%lu of %lu ROMs have cheats\n",
+		(unsigned long) matched,
+		(unsigned long) cn_vec_size(roms)
+	);
+
+	// Clean up. We're done here.
+	for (i = 0; i < ((size_t) 1 << table.bits); i++) {
+		if (table.slots[i].matches == NULL)
+			continue;
+
+		cn_vec_traverse(table.slots[i].matches, match)
+			free(match->name);
+
+		cn_vec_free(table.slots[i].matches);
+	}
+
+	cn_vec_traverse(roms, rom)
+		free(rom->path);
+
+	free(table.slots);
+	cn_vec_free(roms);
+	free(args.roms);
+	free(args.dumps);
+
+	return status;
+}
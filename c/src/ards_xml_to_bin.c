@@ -0,0 +1,91 @@
+/*
+ * ARDS XML-to-Binary Converter
+ *
+ * Description:
+ *     Given an XML codelist, as made by "ards_game_to_xml", read every game in
+ *     it and write them out in the ARDS byte format. This is the way back from
+ *     "ards_game_to_xml".
+ *
+ *     Games are written back-to-back, each padded with 0xFF to a 0x100 byte
+ *     boundary, same as "ards_game_to_bin". The address of each game in the
+ *     output is printed to stderr, so they can be fed to the other tools.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+
+// ARDS Utils
+#include "../lib/ards_util/io.h"
+#include "../lib/ards_util/xml.h"
+
+// CNDS (Clara Nguyen's Data Structures)
+#include "../lib/CN_Vec/cn_vec.h"
+
+// Games in the ROM start on 0x100 byte boundaries
+#define GAME_ALIGN 0x100
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	// Argument check
+	if (argc != 2) {
+		fprintf(stderr, "usage: %s IN_CODELIST.xml > OUT.bin\n", argv[0]);
+		return 1;
+	}
+
+	FILE      *fp;       // File Pointer
+	CN_VEC     games;    // ARDS Game Object Vector
+	ARDS_GAME *it;       // Iterator
+	size_t     out_pos,  // Bytes written to stdout so far
+	           err_line; // Where the XML went wrong
+
+	fp = fopen(argv[1], "rb");
+
+	if (!fp) {
+		fprintf(stderr, "Error: Failed to open file: %s\n", strerror(errno));
+		return 2;
+	}
+
+	// Read every game in
+	games = ards_game_import_from_xml(fp, &err_line);
+	fclose(fp);
+
+	if (games == NULL) {
+		fprintf(
+			stderr,
+			"Error: Malformed XML at line %lu\n",
+			(unsigned long) err_line
+		);
+		return 3;
+	}
+
+	// Write them all back out
+	out_pos = 0;
+
+	cn_vec_traverse(games, it) {
+		fprintf(stderr, "0x%08lx - %.4s-%08X - %s\n",
+			(unsigned long) out_pos, (*it)->header.ID,
+			(*it)->header.N_CRC32, (*it)->name);
+
+		// Pad to the next game boundary
+		out_pos += ards_game_export_as_binary(*it, stdout);
+
+		for (; out_pos % GAME_ALIGN != 0; out_pos++)
+			fputc(0xFF, stdout);
+
+		ards_game_free(*it);
+	}
+
+	// We're done here
+	cn_vec_free(games);
+	return 0;
+}
@@ -0,0 +1,136 @@
+/*
+ * CRC-32 Benchmark
+ *
+ * Description:
+ *     Times each CRC-32 implementation in "ards_util/gameid" over a large
+ *     buffer and compares them to how fast the buffer can simply be read. If
+ *     the carry-less multiply version is close to the plain read, it is
+ *     limited by memory bandwidth rather than by the CRC.
+ *
+ *     Buffer size is in MiB, and defaults to 256 MiB.
+ *
+ * Author:
+ *     Clara Nguyen (@iDestyKK)
+ */
+
+// C Includes
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <time.h>
+
+// Utility
+#include "../lib/ards_util/gameid.h"
+
+#define DEFAULT_MIB 256
+#define RUNS        5
+
+// ----------------------------------------------------------------------------
+// Timing Helpers                                                          {{{1
+// ----------------------------------------------------------------------------
+
+double now() {
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+/*
+ * read_all
+ *
+ * Reads every 64-bit word of the buffer. This is the speed to beat.
+ */
+
+uint32_t read_all(uint32_t crc, const void *buffer, size_t len) {
+	const uint64_t *p;
+	uint64_t        sum;
+	size_t          i;
+
+	p = (const uint64_t *) buffer;
+
+	for (i = 0, sum = 0; i < len / sizeof(uint64_t); i++)
+		sum += p[i];
+
+	return crc ^ (uint32_t) (sum ^ (sum >> 32));
+}
+
+/*
+ * bench
+ *
+ * Runs "func" over the buffer RUNS times and prints the best time as MiB/s.
+ */
+
+void bench(
+	const char *name,
+	uint32_t  (*func)(uint32_t, const void *, size_t),
+	uint8_t    *buffer,
+	size_t      len
+) {
+	double   t, best;
+	uint32_t crc;
+	size_t   i;
+
+	best = -1;
+
+	for (i = 0; i < RUNS; i++) {
+		t   = now();
+		crc = crc32_final(func(crc32_init(), buffer, len));
+		t   = now() - t;
+
+		if (best < 0 || t < best)
+			best = t;
+	}
+
+	printf(
+		"%-8s %08X %10.1f MiB/s\n",
+		name, crc, (len / 1048576.0) / best
+	);
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
+
+int main(int argc, char **argv) {
+	size_t   len, i;
+	uint8_t *buffer;
+
+	// Argument check
+	if (argc > 2) {
+		fprintf(stderr, "usage: %s [SIZE_MIB]\n", argv[0]);
+		return 1;
+	}
+
+	len = ((argc == 2) ? strtoul(argv[1], NULL, 10) : DEFAULT_MIB) << 20;
+
+	if (len == 0) {
+		fprintf(stderr, "Error: Size must be at least 1 MiB\n");
+		return 1;
+	}
+
+	buffer = (uint8_t *) malloc(len);
+
+	if (buffer == NULL) {
+		fprintf(stderr, "Error: Failed to allocate %lu bytes\n", len);
+		return 2;
+	}
+
+	// Fill with junk, and fault in every page before timing anything
+	for (i = 0; i < len; i++)
+		buffer[i] = (uint8_t) (i * 2654435761U >> 13);
+
+	printf("Buffer: %lu MiB, PCLMULQDQ: %s\n\n",
+		len >> 20, crc32_has_clmul() ? "yes" : "no");
+
+	bench("read"  , read_all          , buffer, len);
+	bench("table" , crc32_update_table, buffer, len);
+
+	if (crc32_has_clmul())
+		bench("clmul" , crc32_update_clmul, buffer, len);
+
+	// Clean up
+	free(buffer);
+	return 0;
+}
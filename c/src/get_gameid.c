@@ -10,30 +10,638 @@
  *
  *     Written modular so code can be used by other files if needed.
  *
+ *     In batch mode, every path given is processed, and directories are
+ *     walked. If no paths are given, they are read from stdin, one per line.
+ *     Each file is handled by a pool of worker threads, and the result is
+ *     printed as "path<TAB>ID". Files that can't be read are reported to
+ *     stderr and skipped.
+ *
+ *     Batch mode keeps a cache of Game IDs, keyed by each file's device,
+ *     inode, size and modification time. Files that haven't changed since
+ *     the last run are answered from it without being opened.
+ *
+ *     The NDS header is validated from the same read as the Game ID (header
+ *     and logo CRC16s, and whether the file is as big as the header says).
+ *     With "-v", what was found is printed after the Game ID.
+ *
  * Author:
  *     Clara Nguyen (@iDestyKK)
  */
 
+// Needed for nftw
+#define _GNU_SOURCE
+
 // C Include
 #include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <ftw.h>
+#include <pthread.h>
+#include <sys/stat.h>
 
 // Utility
 #include "../lib/ards_util/gameid.h"
+#include "../lib/ards_util/gameid_cache.h"
+#include "../lib/ards_util/nds_header.h"
+
+// Paths handed to the worker pool at once
+#define BATCH_SZ 4096
+
+// ----------------------------------------------------------------------------
+// Batch Data Structs                                                      {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * JOB_T
+ *
+ * A single file to get the Game ID of, and how it went.
+ */
+
+typedef struct JOB_T {
+	char        *path;       // Path to the file
+	char         gameid[14]; // XXXX-XXXXXXXX + NULL
+	int          status;     // Same as get_gameid_fd
+	int          err;        // errno, if status is -1
+	uint16_t     flags;      // NDS_HEADER_* flags, if status is 0
+	uint8_t      done;       // Answered before the workers got to it
+	struct stat  st;         // Identity of the file, for the cache
+} job_t;
+
+/*
+ * BATCH_T
+ *
+ * A batch of jobs, and the worker pool state for running them.
+ */
+
+typedef struct BATCH_T {
+	job_t            jobs[BATCH_SZ];
+	size_t           num;      // Jobs in the batch
+	size_t           next;     // Next job to hand out
+	size_t           threads;  // Workers per batch
+	size_t           failed;   // Jobs that failed, over every batch
+	size_t           hits;     // Jobs answered by the cache
+	size_t           flagged;  // Jobs whose header failed validation
+	uint8_t          validate; // Print header validation results
+	GAMEID_CACHE     cache;    // NULL if not caching
+	pthread_mutex_t  lock;     // Protects "next"
+} batch_t;
+
+// The batch that the directory walk adds to. nftw has no user pointer.
+batch_t *walk_batch;
+
+// ----------------------------------------------------------------------------
+// Basic Argument Parser                                                   {{{1
+// ----------------------------------------------------------------------------
+
+typedef struct ARGS_T {
+	uint8_t  flag_batch;
+	uint8_t  flag_no_cache;
+	uint8_t  flag_validate;
+	char    *cache_path;
+	size_t   threads;
+	char   **paths;
+	size_t   num_paths;
+} args_t;
+
+void print_help(int argc, char **argv) {
+	printf("usage: %s [-v] NDS_IN\n", argv[0]);
+	printf(
+		"       %s -b [-v] [-j THREADS] [-c CACHE | -n] [PATH [PATH [...]]]\n",
+		argv[0]
+	);
+	printf("Gets the Game ID (XXXX-XXXXXXXX) of NDS ROMs.\n\n");
+
+	printf("Optional arguments are:\n\n");
+
+	printf("\t-b\tBatch mode. Every PATH is processed, and directories are "
+		"walked.\n\t\tIf no PATH is given, paths are read from stdin, one "
+		"per line.\n\t\tOutput is \"path<TAB>ID\" per file.\n\n");
+
+	printf("\t-c\tGame ID cache to use in batch mode. Defaults to "
+		"\"ards_gameid.cache\"\n\t\tin $XDG_CACHE_HOME, or ~/.cache.\n\n");
+
+	printf("\t-h\tPrints this help prompt in the terminal and then "
+		"terminates.\n\n");
+
+	printf("\t-j\tNumber of worker threads in batch mode. Defaults to the "
+		"number of\n\t\tCPUs.\n\n");
+
+	printf("\t-n\tDon't use a Game ID cache in batch mode.\n\n");
+
+	printf("\t-v\tPrint NDS header validation after the Game ID: \"OK\", "
+		"or any of\n\t\tBAD_CRC, BAD_LOGO_CRC, BAD_LOGO, TRIMMED, "
+		"BAD_BINARY and\n\t\tOVERSIZED. Exits with 3 if any ROM isn't "
+		"OK.\n\n");
+
+	exit(0);
+}
+
+void parse_flags(int argc, char **argv, args_t *obj) {
+	int i, j, len;
+
+	// Defaults
+	obj->flag_batch    = 0;
+	obj->flag_no_cache = 0;
+	obj->flag_validate = 0;
+	obj->cache_path    = NULL;
+	obj->threads       = 0;
+	obj->paths         = (char **) malloc(sizeof(char *) * argc);
+	obj->num_paths     = 0;
+
+	// Go through every argument and read characters
+	for (i = 1; i < argc; i++) {
+		// Anything that isn't a flag is a path
+		if (argv[i][0] != '-' || argv[i][1] == 0) {
+			obj->paths[obj->num_paths++] = argv[i];
+			continue;
+		}
+
+		len = strlen(argv[i]);
+		for (j = 1; j < len; j++) {
+			switch (argv[i][j]) {
+				case 'b':
+					// Batch mode
+					obj->flag_batch = 1;
+					break;
+
+				case 'j':
+					// Thread count. Either "-j4" or "-j 4".
+					if (j + 1 < len)
+						obj->threads = strtoul(&argv[i][j + 1], NULL, 10);
+					else
+					if (i + 1 < argc)
+						obj->threads = strtoul(argv[++i], NULL, 10);
+
+					j = len;
+					break;
+
+				case 'c':
+					// Cache path. Either "-cFILE" or "-c FILE".
+					if (j + 1 < len)
+						obj->cache_path = &argv[i][j + 1];
+					else
+					if (i + 1 < argc)
+						obj->cache_path = argv[++i];
+
+					j = len;
+					break;
+
+				case 'n':
+					// No cache
+					obj->flag_no_cache = 1;
+					break;
+
+				case 'v':
+					// Print header validation
+					obj->flag_validate = 1;
+					break;
+
+				case 'h':
+					// Shows help prompt and terminate
+					print_help(argc, argv);
+					break;
+
+				default:
+					// Invalid Flag
+					fprintf(
+						stderr,
+						"WARN: Invalid flag \"%c\" was given. Ignoring...\n",
+						argv[i][j]
+					);
+
+					break;
+			}
+		}
+	}
+
+	if (obj->threads == 0)
+		obj->threads = sysconf(_SC_NPROCESSORS_ONLN);
+}
+
+// ----------------------------------------------------------------------------
+// Batch Mode                                                              {{{1
+// ----------------------------------------------------------------------------
+
+/*
+ * batch_worker
+ *
+ * Takes jobs from the batch until there are none left. Every worker has its
+ * own 512 byte buffer, reused for each file. The header is validated from
+ * the same buffer the Game ID came from.
+ */
+
+void *batch_worker(void *arg) {
+	batch_t *batch = (batch_t *) arg;
+	uint8_t  buffer[GAMEID_HEADER_SZ];
+	job_t   *job;
+	size_t   i;
+	int      fd;
+
+	while (1) {
+		pthread_mutex_lock(&batch->lock);
+		i = batch->next++;
+		pthread_mutex_unlock(&batch->lock);
+
+		if (i >= batch->num)
+			break;
+
+		job = &batch->jobs[i];
+
+		if (job->done)
+			continue;
+
+		fd = open(job->path, O_RDONLY);
+
+		if (fd < 0) {
+			job->status = -1;
+			job->err    = errno;
+			continue;
+		}
+
+		// The open file's identity is what the cache should remember
+		if (fstat(fd, &job->st) != 0) {
+			job->status = -1;
+			job->err    = errno;
+			close(fd);
+			continue;
+		}
+
+		job->status = get_gameid_fd(fd, buffer, job->gameid);
+		job->err    = errno;
+
+		if (job->status == 0)
+			job->flags = nds_header_validate(buffer, job->st.st_size);
+
+		close(fd);
+	}
+
+	return NULL;
+}
+
+/*
+ * batch_run
+ *
+ * Runs every job in the batch on the worker pool, prints the results in the
+ * order they were added, and empties the batch.
+ */
+
+void batch_run(batch_t *batch) {
+	pthread_t *tids;
+	job_t     *job;
+	size_t     i, n;
+
+	if (batch->num == 0)
+		return;
+
+	// Only files the cache couldn't answer need a worker
+	for (i = 0, n = 0; i < batch->num; i++)
+		n += !batch->jobs[i].done;
+
+	// No point in more workers than jobs
+	if (n > batch->threads)
+		n = batch->threads;
+
+	if (n > 0) {
+		tids = (pthread_t *) malloc(sizeof(pthread_t) * n);
+
+		batch->next = 0;
+
+		for (i = 0; i < n; i++)
+			pthread_create(&tids[i], NULL, batch_worker, batch);
+
+		for (i = 0; i < n; i++)
+			pthread_join(tids[i], NULL);
+
+		free(tids);
+	}
+
+	// Report
+	for (i = 0; i < batch->num; i++) {
+		job = &batch->jobs[i];
+
+		switch (job->status) {
+			case 0:
+				printf("%s\t%s", job->path, job->gameid);
+
+				if (batch->validate) {
+					printf("\t");
+					nds_header_print_flags(stdout, job->flags);
+
+					if (job->flags != NDS_HEADER_OK)
+						batch->flagged++;
+				}
+
+				printf("\n");
+
+				if (batch->cache != NULL && !job->done) {
+					gameid_cache_store(
+						batch->cache,
+						&job->st,
+						job->gameid,
+						job->flags
+					);
+				}
+
+				break;
+
+			case 1:
+				fprintf(
+					stderr,
+					"Error: %s: File is shorter than %d bytes\n",
+					job->path,
+					GAMEID_HEADER_SZ
+				);
+
+				batch->failed++;
+				break;
+
+			default:
+				fprintf(
+					stderr,
+					"Error: %s: %s\n",
+					job->path,
+					strerror(job->err)
+				);
+
+				batch->failed++;
+				break;
+		}
+
+		free(job->path);
+	}
+
+	batch->num = 0;
+}
+
+/*
+ * batch_add
+ *
+ * Adds a path to the batch, running it first if it's full. "st" is the
+ * file's stat if the caller already has it, or NULL to stat it here. If the
+ * cache has the file, the job is already done, and the file is never opened.
+ */
+
+void batch_add(batch_t *batch, const char *path, const struct stat *st) {
+	job_t *job;
+
+	if (batch->num == BATCH_SZ)
+		batch_run(batch);
+
+	job = &batch->jobs[batch->num++];
+
+	job->path = strdup(path);
+	job->done = 0;
+
+	if (batch->cache == NULL)
+		return;
+
+	if (st == NULL) {
+		// Let the worker report the error, if there is one
+		if (stat(path, &job->st) != 0)
+			return;
+
+		st = &job->st;
+	}
+
+	if (gameid_cache_lookup(batch->cache, st, job->gameid, &job->flags)) {
+		job->status = 0;
+		job->done   = 1;
+		batch->hits++;
+	}
+}
+
+/*
+ * batch_walk_cb
+ *
+ * nftw callback. Adds every regular file to "walk_batch".
+ */
+
+int batch_walk_cb(
+	const char        *path,
+	const struct stat *st,
+	int                type,
+	struct FTW        *ftw
+) {
+	if (type == FTW_F && S_ISREG(st->st_mode))
+		batch_add(walk_batch, path, st);
+	else
+	if (type == FTW_DNR || type == FTW_NS) {
+		fprintf(stderr, "Error: %s: Failed to read\n", path);
+		walk_batch->failed++;
+	}
+
+	return 0;
+}
+
+/*
+ * batch_cache_path
+ *
+ * Default location of the Game ID cache. "$XDG_CACHE_HOME" if set, or
+ * "~/.cache" otherwise. The directory is made if it doesn't exist yet.
+ * Returns NULL if neither is set. Free the result.
+ */
+
+char *batch_cache_path() {
+	const char *base, *home;
+	char       *dir, *path;
+
+	base = getenv("XDG_CACHE_HOME");
+	home = getenv("HOME");
+
+	if (base != NULL && base[0] != 0)
+		dir = strdup(base);
+	else
+	if (home != NULL && home[0] != 0) {
+		dir = (char *) malloc(strlen(home) + 8);
+		sprintf(dir, "%s/.cache", home);
+	}
+	else
+		return NULL;
+
+	mkdir(dir, 0755);
+
+	path = (char *) malloc(strlen(dir) + 19);
+	sprintf(path, "%s/ards_gameid.cache", dir);
+
+	free(dir);
+	return path;
+}
+
+/*
+ * batch_iterate
+ *
+ * Batch mode. Returns 0 if every file was processed, 2 if any failed, or 3
+ * if they were all processed but some failed header validation.
+ */
+
+int batch_iterate(args_t *args) {
+	batch_t *batch;
+	char    *line, *cache_path;
+	size_t   i, cap;
+	ssize_t  len;
+
+	batch = (batch_t *) malloc(sizeof(batch_t));
+
+	batch->num      = 0;
+	batch->threads  = args->threads;
+	batch->failed   = 0;
+	batch->hits     = 0;
+	batch->flagged  = 0;
+	batch->validate = args->flag_validate;
+	batch->cache    = NULL;
+
+	// Setup the cache
+	cache_path = NULL;
+
+	if (!args->flag_no_cache) {
+		cache_path = (args->cache_path != NULL)
+			? strdup(args->cache_path)
+			: batch_cache_path();
+	}
+
+	if (cache_path != NULL)
+		batch->cache = gameid_cache_load(cache_path);
+
+	pthread_mutex_init(&batch->lock, NULL);
+	walk_batch = batch;
+
+	if (args->num_paths > 0) {
+		// Walk everything given. Symlinks aren't followed.
+		for (i = 0; i < args->num_paths; i++) {
+			if (nftw(args->paths[i], batch_walk_cb, 64, FTW_PHYS) != 0) {
+				fprintf(
+					stderr,
+					"Error: %s: %s\n",
+					args->paths[i],
+					strerror(errno)
+				);
+
+				batch->failed++;
+			}
+		}
+	}
+	else {
+		// One path per line from stdin
+		line = NULL;
+		cap  = 0;
+
+		while ((len = getline(&line, &cap, stdin)) != -1) {
+			while (len > 0 && (line[len - 1] == '\n' || line[len - 1] == '\r'))
+				line[--len] = 0;
+
+			if (len > 0)
+				batch_add(batch, line, NULL);
+		}
+
+		free(line);
+	}
+
+	// Whatever is left over
+	batch_run(batch);
+
+	// Write back whatever was new or changed
+	if (batch->cache != NULL) {
+		if (gameid_cache_save(batch->cache, cache_path) != 0) {
+			fprintf(
+				stderr,
+				"WARN: Failed to write Game ID cache \"%s\": %s\n",
+				cache_path,
+				strerror(errno)
+			);
+		}
+
+		gameid_cache_free(batch->cache);
+		free(cache_path);
+	}
+
+	if (batch->failed > 0)
+		len = 2;
+	else
+	if (batch->flagged > 0)
+		len = 3;
+	else
+		len = 0;
+
+	pthread_mutex_destroy(&batch->lock);
+	free(batch);
+
+	return len;
+}
+
+// ----------------------------------------------------------------------------
+// Main Function                                                           {{{1
+// ----------------------------------------------------------------------------
 
 int main(int argc, char **argv) {
+	args_t      args;
+	struct stat st;
+	uint8_t     buffer[GAMEID_HEADER_SZ];
+	uint16_t    flags;
+	int         fd, status;
+
+	parse_flags(argc, argv, &args);
+
+	if (args.flag_batch) {
+		status = batch_iterate(&args);
+		free(args.paths);
+		return status;
+	}
+
 	// Argument check
-	if (argc != 2) {
-		fprintf(stderr, "usage: %s NDS_IN\n", argv[0]);
+	if (args.num_paths != 1) {
+		fprintf(stderr, "usage: %s [-v] NDS_IN\n", argv[0]);
+		free(args.paths);
 		return 1;
 	}
 
 	// Setup buffer. XXXX-XXXXXXXX + NULL
 	char gameid[14];
 
-	// Process
-	get_gameid(argv[1], &gameid[0]);
+	// Process. The header is validated from the same read.
+	fd     = open(args.paths[0], O_RDONLY);
+	status = -1;
 
-	// Done
-	printf("%s\n", gameid);
-	return 0;
+	if (fd >= 0) {
+		if (fstat(fd, &st) == 0)
+			status = get_gameid_fd(fd, buffer, &gameid[0]);
+
+		close(fd);
+	}
+
+	if (status == 1) {
+		fprintf(
+			stderr,
+			"Error: File is shorter than %d bytes\n",
+			GAMEID_HEADER_SZ
+		);
+	}
+	else
+	if (status != 0) {
+		fprintf(stderr, "Error: Failed to read file: %s\n", strerror(errno));
+	}
+	else {
+		// Done
+		printf("%s", gameid);
+
+		if (args.flag_validate) {
+			flags = nds_header_validate(buffer, st.st_size);
+
+			printf("\t");
+			nds_header_print_flags(stdout, flags);
+
+			if (flags != NDS_HEADER_OK)
+				status = 3;
+		}
+
+		printf("\n");
+	}
+
+	free(args.paths);
+
+	if (status == 0 || status == 3)
+		return status;
+
+	return 2;
 }